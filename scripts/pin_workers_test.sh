@@ -0,0 +1,7 @@
+#!/bin/sh
+mkdir -p build
+clang -pedantic -Ilibhmaths -Ilibhccintrinsics -Iinterop -D_GNU_SOURCE -std=gnu11 -Werror -Wfloat-conversion -Wimplicit-fallthrough -Wextra -g -o build/pin_workers_test tools/pin_workers_test.c -lm -ldl -pthread
+if test $? -ne 0; then
+	exit 1
+fi
+./build/pin_workers_test
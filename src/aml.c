@@ -157,6 +157,22 @@ void hcc_aml_function_alctor_deinit(HccCU* cu) {
 	hcc_stack_deinit(function_alctor->basic_block_param_srcs_pool);
 }
 
+void hcc_aml_function_alctor_reset(HccCU* cu) {
+	//
+	// hcc_aml_function_alctor_alloc initializes everything it hands out,
+	// so the pools only need their counts cleared and not their memory zeroed.
+	HccAMLFunctionAlctor* function_alctor = &cu->aml.function_alctor;
+	hcc_stack_clear(function_alctor->functions_pool);
+	hcc_stack_clear(function_alctor->words_pool);
+	hcc_stack_clear(function_alctor->values_pool);
+	hcc_stack_clear(function_alctor->basic_blocks_pool);
+	hcc_stack_clear(function_alctor->basic_block_params_pool);
+	hcc_stack_clear(function_alctor->basic_block_param_srcs_pool);
+	for (uint32_t idx = 0; idx < HCC_AML_FUNCTION_ALLOCATOR_INTSR_LOG2_COUNT; idx += 1) {
+		atomic_store(&function_alctor->free_functions_by_instr_log2[idx], NULL);
+	}
+}
+
 uint32_t hcc_aml_function_alctor_instr_count_round_up_log2(HccCU* cu, uint32_t max_instrs_count) {
 	HCC_UNUSED(cu);
 
@@ -712,12 +728,35 @@ void hcc_aml_init(HccCU* cu, HccCUSetup* setup) {
 	cu->aml.locations = hcc_stack_init(HccLocation*, HCC_ALLOC_TAG_AML_LOCATIONS, setup->ast.expr_locations_grow_count, setup->ast.expr_locations_reserve_cap);
 	cu->aml.call_graph_nodes = hcc_stack_init(HccAMLCallNode, HCC_ALLOC_TAG_AML_CALL_GRAPH_NODES, setup->functions_grow_count, setup->functions_reserve_cap);
 	cu->aml.function_call_node_lists = hcc_stack_init(HccAMLCallNode*, 	HCC_ALLOC_TAG_AML_FUNCTION_CALL_NODE_LISTS, setup->functions_grow_count, setup->functions_reserve_cap);
-	cu->aml.optimize_functions[0] = hcc_stack_init(HccDecl, HCC_ALLOC_TAG_AML_OPIMIZE_FUNCTIONS, setup->functions_grow_count, setup->functions_reserve_cap);
-	cu->aml.optimize_functions[1] = hcc_stack_init(HccDecl, HCC_ALLOC_TAG_AML_OPIMIZE_FUNCTIONS, setup->functions_grow_count, setup->functions_reserve_cap);
+	cu->aml.optimize_functions = hcc_stack_init(HccDecl, HCC_ALLOC_TAG_AML_OPIMIZE_FUNCTIONS, setup->functions_grow_count, setup->functions_reserve_cap);
+	cu->aml.call_graph_deps = hcc_stack_init(HccAMLCallGraphDeps, HCC_ALLOC_TAG_AML_CALL_GRAPH_DEPS, setup->functions_grow_count, setup->functions_reserve_cap);
+	cu->aml.call_graph_waiting_nodes = hcc_stack_init(HccAMLCallNode, HCC_ALLOC_TAG_AML_CALL_GRAPH_WAITING_NODES, setup->functions_grow_count, setup->functions_reserve_cap);
+	cu->aml.call_graph_made_decls = hcc_stack_init(HccDecl, HCC_ALLOC_TAG_AML_CALL_GRAPH_MADE_DECLS, setup->functions_grow_count, setup->functions_reserve_cap);
+	hcc_spin_mutex_init(&cu->aml.call_graph_deps_mutex);
 }
 
 void hcc_aml_deinit(HccCU* cu) {
 	hcc_aml_function_alctor_deinit(cu);
+	hcc_stack_deinit(cu->aml.functions);
+	hcc_stack_deinit(cu->aml.locations);
+	hcc_stack_deinit(cu->aml.call_graph_nodes);
+	hcc_stack_deinit(cu->aml.function_call_node_lists);
+	hcc_stack_deinit(cu->aml.optimize_functions);
+	hcc_stack_deinit(cu->aml.call_graph_deps);
+	hcc_stack_deinit(cu->aml.call_graph_waiting_nodes);
+	hcc_stack_deinit(cu->aml.call_graph_made_decls);
+}
+
+void hcc_aml_reset(HccCU* cu) {
+	hcc_aml_function_alctor_reset(cu);
+	hcc_stack_reset(cu->aml.functions);
+	hcc_stack_reset(cu->aml.locations);
+	hcc_stack_reset(cu->aml.call_graph_nodes);
+	hcc_stack_reset(cu->aml.function_call_node_lists);
+	hcc_stack_reset(cu->aml.optimize_functions);
+	hcc_stack_reset(cu->aml.call_graph_deps);
+	hcc_stack_reset(cu->aml.call_graph_waiting_nodes);
+	hcc_stack_reset(cu->aml.call_graph_made_decls);
 }
 
 void hcc_aml_print_operand(HccCU* cu, const HccAMLFunction* function, HccAMLOperand operand, HccIIO* iio, bool is_definition) {
@@ -825,6 +864,12 @@ void hcc_aml_print(HccCU* cu, HccIIO* iio) {
 	uint32_t functions_count = hcc_stack_count(cu->aml.functions);
 	for (uint32_t function_idx = HCC_FUNCTION_IDX_USER_START; function_idx < functions_count; function_idx += 1) {
 		const HccAMLFunction* function = cu->aml.functions[function_idx];
+		if (function == NULL) {
+			//
+			// the function cannot be reached from a shader so it was never lowered to AML
+			continue;
+		}
+
 		HccString name = hcc_string_table_get_or_empty(function->identifier_string_id);
 		if (iio->ascii_colors_enabled) {
 			fmt = "\x1b[94mFunction\x1b[0m(\x1b[93m#%u\x1b[0m): \x1b[1m%.*s\x1b[0m(";
@@ -913,12 +958,7 @@ HccLocation* hcc_aml_instr_location(HccCU* cu, HccAMLInstr* instr) {
 }
 
 HccStack(HccDecl) hcc_aml_optimize_functions(HccCU* cu) {
-	return cu->aml.optimize_functions[cu->aml.optimize_functions_idx];
-}
-
-void hcc_aml_next_optimize_functions_array(HccCU* cu) {
-	cu->aml.optimize_functions_idx = (cu->aml.optimize_functions_idx + 1) % 2;
-	hcc_stack_clear(cu->aml.optimize_functions[cu->aml.optimize_functions_idx]);
+	return cu->aml.optimize_functions;
 }
 
 HccAMLOperand hcc_aml_basic_block_next(const HccAMLFunction* function, HccAMLOperand basic_block_operand) {
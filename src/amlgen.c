@@ -34,7 +34,7 @@ HccAMLOperand hcc_amlgen_value_add(HccWorker* w, HccDataType data_type) {
 }
 
 HccAMLOperand hcc_amlgen_basic_block_add(HccWorker* w, HccLocation* location) {
-	HccLocation** dst_location = hcc_stack_push_thread_safe(w->cu->aml.locations);
+	HccLocation** dst_location = hcc_cu_stack_push(w->cu, w->cu->aml.locations, HCC_CU_STACK_CHUNK_AML_LOCATIONS);
 	*dst_location = location;
 	w->amlgen.last_op = HCC_AML_OP_BASIC_BLOCK;
 	w->amlgen.last_location = location;
@@ -60,7 +60,7 @@ HccAMLOperand* hcc_amlgen_instr_add(HccWorker* w, HccLocation* location, HccAMLO
 		hcc_amlgen_basic_block_add(w, location);
 	}
 
-	HccLocation** dst_location = hcc_stack_push_thread_safe(w->cu->aml.locations);
+	HccLocation** dst_location = hcc_cu_stack_push(w->cu, w->cu->aml.locations, HCC_CU_STACK_CHUNK_AML_LOCATIONS);
 	*dst_location = location;
 	w->amlgen.last_op = op;
 	w->amlgen.last_location = location;
@@ -1627,8 +1627,5 @@ void hcc_amlgen_generate(HccWorker* w) {
 			hcc_amlgen_instr_add(w, w->amlgen.last_location, HCC_AML_OP_UNREACHABLE, 0);
 		}
 	}
-
-	HccStack(HccDecl) optimize_functions = hcc_aml_optimize_functions(w->cu);
-	*hcc_stack_push_thread_safe(optimize_functions) = function_decl;
 }
 
@@ -226,7 +226,9 @@ CONTINUE:
 
 	//
 	// deduplicate append the function to the optimize_functions array
-	// in an ordered way from the most deepest calls to the entry points
+	// in an ordered way from the most deepest calls to the entry points.
+	// all of the callees have been appended by now, so the thread that appends the function
+	// gives out its next phase straight away instead of waiting for every other shader's call graph.
 	uint32_t idx = 0;
 	HccStack(HccDecl) optimize_functions = hcc_aml_optimize_functions(cu);
 	while (1) {
@@ -236,11 +238,19 @@ CONTINUE:
 				goto END;
 			}
 		}
+
+		bool is_appended = false;
 		hcc_spin_mutex_lock(&cu->aml.optimize_functions_mutex);
 		if (count == hcc_stack_count(optimize_functions)) {
 			*hcc_stack_push(optimize_functions) = function_decl;
+			is_appended = true;
 		}
 		hcc_spin_mutex_unlock(&cu->aml.optimize_functions_mutex);
+
+		if (is_appended) {
+			hcc_compiler_give_amlopt_worker_job(w->c, hcc_worker_task(w), function_decl, w->job.aml_opt_phase + 1);
+			break;
+		}
 	}
 
 END:{}
@@ -307,12 +317,63 @@ CONTINUE:
 
 	*hcc_stack_get(cu->aml.function_call_node_lists, HCC_DECL_AUX(function_decl)) = head;
 
-	HccStack(HccDecl) optimize_functions = hcc_aml_optimize_functions(cu);
-	*hcc_stack_push_thread_safe(optimize_functions) = function_decl;
-
 	return aml_function;
 }
 
+void hcc_amlopt_call_graph_made(HccWorker* w, HccDecl function_decl) {
+	HccCU* cu = w->cu;
+	HccStack(HccDecl) made_decls = cu->aml.call_graph_made_decls;
+	hcc_spin_mutex_lock(&cu->aml.call_graph_deps_mutex);
+
+	//
+	// wait on every callee that does not have its whole call graph made yet
+	HccAMLCallGraphDeps* deps = hcc_stack_get(cu->aml.call_graph_deps, HCC_DECL_AUX(function_decl));
+	HccAMLCallNode* node = *hcc_stack_get(cu->aml.function_call_node_lists, HCC_DECL_AUX(function_decl));
+	while (node) {
+		HccAMLCallGraphDeps* callee_deps = hcc_stack_get(cu->aml.call_graph_deps, HCC_DECL_AUX(node->function_decl));
+		if (HCC_DECL_AUX(node->function_decl) >= HCC_FUNCTION_IDX_USER_START && !callee_deps->is_made) {
+			HccAMLCallNode* waiting_node = hcc_stack_push(cu->aml.call_graph_waiting_nodes);
+			waiting_node->function_decl = function_decl;
+			waiting_node->next_call_node_idx = callee_deps->waiting_callers ? callee_deps->waiting_callers - cu->aml.call_graph_waiting_nodes : UINT32_MAX;
+			callee_deps->waiting_callers = waiting_node;
+			deps->waiting_calls_count += 1;
+		}
+
+		node = node->next_call_node_idx == UINT32_MAX ? NULL : hcc_stack_get(cu->aml.call_graph_nodes, node->next_call_node_idx);
+	}
+
+	if (deps->waiting_calls_count == 0) {
+		*hcc_stack_push(made_decls) = function_decl;
+	}
+
+	//
+	// tell the callers that were waiting on the functions that have been made,
+	// which will make them too when it was the last call they were waiting on.
+	while (hcc_stack_count(made_decls)) {
+		HccDecl made_decl = made_decls[hcc_stack_count(made_decls) - 1];
+		hcc_stack_pop(made_decls);
+
+		HccAMLCallGraphDeps* made_deps = hcc_stack_get(cu->aml.call_graph_deps, HCC_DECL_AUX(made_decl));
+		made_deps->is_made = true;
+		if (hcc_ast_function_get(cu, made_decl)->shader_stage != HCC_SHADER_STAGE_NONE) {
+			hcc_compiler_give_amlopt_worker_job(w->c, hcc_worker_task(w), made_decl, HCC_AML_OPT_PHASE_1);
+		}
+
+		HccAMLCallNode* waiting_node = made_deps->waiting_callers;
+		while (waiting_node) {
+			HccAMLCallGraphDeps* caller_deps = hcc_stack_get(cu->aml.call_graph_deps, HCC_DECL_AUX(waiting_node->function_decl));
+			caller_deps->waiting_calls_count -= 1;
+			if (caller_deps->waiting_calls_count == 0) {
+				*hcc_stack_push(made_decls) = waiting_node->function_decl;
+			}
+
+			waiting_node = waiting_node->next_call_node_idx == UINT32_MAX ? NULL : hcc_stack_get(cu->aml.call_graph_waiting_nodes, waiting_node->next_call_node_idx);
+		}
+	}
+
+	hcc_spin_mutex_unlock(&cu->aml.call_graph_deps_mutex);
+}
+
 const HccAMLFunction* hcc_amlopt_check_for_recursion_and_make_ordered_function_list(HccWorker* w, HccDecl function_decl, const HccAMLFunction* aml_function) {
 	if (aml_function->shader_stage == HCC_SHADER_STAGE_NONE) {
 		return aml_function;
@@ -426,9 +487,6 @@ CONTINUE:
 		aml_word_idx += HCC_AML_INSTR_WORDS_COUNT(aml_instr);
 	}
 
-	HccStack(HccDecl) optimize_functions = hcc_aml_optimize_functions(cu);
-	*hcc_stack_push_thread_safe(optimize_functions) = function_decl;
-
 	return aml_function;
 }
 
@@ -438,8 +496,9 @@ void hcc_amlopt_optimize(HccWorker* w) {
 	HccAMLFunction* aml_function = hcc_aml_function_take_ref(cu, function_decl);
 	HccAtomic(HccAMLFunction*)* dst_aml_function = hcc_stack_get(cu->aml.functions, HCC_DECL_AUX(function_decl));
 
-	HccAMLOptFn* opts = hcc_aml_opts[cu->aml.opt_phase][aml_function->opt_level];
-	uint32_t opts_count = hcc_aml_opts_count[cu->aml.opt_phase][aml_function->opt_level];
+	HccAMLOptPhase phase = w->job.aml_opt_phase;
+	HccAMLOptFn* opts = hcc_aml_opts[phase][aml_function->opt_level];
+	uint32_t opts_count = hcc_aml_opts_count[phase][aml_function->opt_level];
 
 	for (uint32_t opt_idx = 0; opt_idx < opts_count; opt_idx += 1) {
 		HccAMLOptFn optimize_fn = opts[opt_idx];
@@ -460,6 +519,10 @@ void hcc_amlopt_optimize(HccWorker* w) {
 		aml_function = new_aml_function;
 	}
 
+	if (phase == HCC_AML_OPT_PHASE_0) {
+		hcc_amlopt_call_graph_made(w, function_decl);
+	}
+
 	hcc_aml_function_return_ref(cu, aml_function);
 }
 
@@ -425,6 +425,7 @@ HccStringId* hcc_ast_file_unique_included_files(HccASTFile* file, uint32_t* coun
 void hcc_ast_file_reset(HccASTFile* file) {
 	hcc_stack_clear(file->macros);
 	hcc_stack_clear(file->macro_params);
+	hcc_stack_clear(file->include_effects);
 	hcc_ata_token_bag_reset(&file->token_bag);
 }
 
@@ -450,7 +451,7 @@ bool hcc_ast_file_pop_token(HccASTFile* file) {
 	return hcc_ata_token_bag_pop_token(&file->token_bag);
 }
 
-void hcc_ast_file_init(HccASTFile* file, HccCU* cu, HccASTFileSetup* setup, HccString path) {
+void hcc_ast_file_init(HccASTFile* file, HccASTFileSetup* setup, HccString path) {
 	file->path = path;
 	file->macros = hcc_stack_init(HccPPMacro, HCC_ALLOC_TAG_AST_FILE_MACROS, setup->macros_grow_count, setup->macros_reserve_cap);
 	file->macro_params = hcc_stack_init(HccStringId, HCC_ALLOC_TAG_AST_FILE_MACRO_PARAMS, setup->macro_params_grow_count, setup->macro_params_reserve_cap);
@@ -459,18 +460,51 @@ void hcc_ast_file_init(HccASTFile* file, HccCU* cu, HccASTFileSetup* setup, HccS
 	file->forward_declarations_to_link = hcc_stack_init(HccDecl, HCC_ALLOC_TAG_AST_FORWARD_DECLARTIONS_TO_LINK, setup->forward_declarations_to_link_grow_count, setup->forward_declarations_to_link_reserve_cap);
 	hcc_ata_token_bag_init(&file->token_bag, setup->tokens_grow_count, setup->tokens_reserve_cap, setup->values_grow_count, setup->values_reserve_cap);
 	hcc_ata_token_bag_init(&file->macro_token_bag, setup->tokens_grow_count, setup->tokens_reserve_cap, setup->values_grow_count, setup->values_reserve_cap);
+	file->include_effects = hcc_stack_init(HccATAIncludeEffect, HCC_ALLOC_TAG_AST_FILE_INCLUDE_EFFECTS, setup->include_effects_grow_count, setup->include_effects_reserve_cap);
 
-	file->global_declarations = hcc_hash_table_init(HccDeclEntry, HCC_ALLOC_TAG_AST_FILE_GLOBAL_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, cu->global_declarations_cap);
-	file->struct_declarations = hcc_hash_table_init(HccDeclEntry, HCC_ALLOC_TAG_AST_FILE_STRUCT_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, cu->compounds_cap);
-	file->union_declarations = hcc_hash_table_init(HccDeclEntry, HCC_ALLOC_TAG_AST_FILE_UNION_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, cu->compounds_cap);
-	file->enum_declarations = hcc_hash_table_init(HccDeclEntry, HCC_ALLOC_TAG_AST_FILE_ENUM_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, cu->enums_cap);
+	//
+	// these are only created when the file is generated into the AST, see hcc_ast_file_init_declarations
+	file->global_declarations = NULL;
+	file->struct_declarations = NULL;
+	file->union_declarations = NULL;
+	file->enum_declarations = NULL;
+	file->is_linked = false;
+}
+
+#define HCC_AST_FILE_DECLARATIONS_MIN_CAP 64
+
+void hcc_ast_file_init_declarations(HccASTFile* file, HccCU* cu) {
+	HCC_DEBUG_ASSERT(file->global_declarations == NULL, "the declarations of this file have already been initialized");
+
+	//
+	// size the tables from the tokens the file has been turned into instead of the capacities of the whole CU,
+	// so the memory that is reserved follows what is in the file and not the amount of files in the CU.
+	// every declaration needs its identifier and at least one token before it, so there can be no more than half the tokens.
+	uint32_t cap = hcc_stack_count(file->token_bag.tokens) / 2;
+	cap = HCC_MAX(cap, HCC_AST_FILE_DECLARATIONS_MIN_CAP);
+	cap = (uint32_t)1 << (hcc_mostsetbitidx32(cap - 1) + 1);
+
+	file->global_declarations = hcc_hash_table_init(HccDeclEntry, HCC_ALLOC_TAG_AST_FILE_GLOBAL_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, HCC_MIN(cap, cu->global_declarations_cap));
+	file->struct_declarations = hcc_hash_table_init(HccDeclEntry, HCC_ALLOC_TAG_AST_FILE_STRUCT_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, HCC_MIN(cap, cu->compounds_cap));
+	file->union_declarations = hcc_hash_table_init(HccDeclEntry, HCC_ALLOC_TAG_AST_FILE_UNION_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, HCC_MIN(cap, cu->compounds_cap));
+	file->enum_declarations = hcc_hash_table_init(HccDeclEntry, HCC_ALLOC_TAG_AST_FILE_ENUM_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, HCC_MIN(cap, cu->enums_cap));
 }
 
 void hcc_ast_file_deinit(HccASTFile* file) {
 	hcc_stack_deinit(file->macros);
 	hcc_stack_deinit(file->macro_params);
+	hcc_stack_deinit(file->pragma_onced_files);
+	hcc_stack_deinit(file->unique_included_files);
+	hcc_stack_deinit(file->forward_declarations_to_link);
 	hcc_ata_token_bag_deinit(&file->token_bag);
 	hcc_ata_token_bag_deinit(&file->macro_token_bag);
+	hcc_stack_deinit(file->include_effects);
+	if (file->global_declarations) {
+		hcc_hash_table_deinit(file->global_declarations);
+		hcc_hash_table_deinit(file->struct_declarations);
+		hcc_hash_table_deinit(file->union_declarations);
+		hcc_hash_table_deinit(file->enum_declarations);
+	}
 }
 
 bool hcc_ast_file_has_been_pragma_onced(HccASTFile* file, HccStringId path_string_id) {
@@ -484,7 +518,16 @@ bool hcc_ast_file_has_been_pragma_onced(HccASTFile* file, HccStringId path_strin
 }
 
 void hcc_ast_file_set_pragma_onced(HccASTFile* file, HccStringId path_string_id) {
+	if (hcc_ast_file_has_been_pragma_onced(file, path_string_id)) {
+		return;
+	}
+
 	*hcc_stack_push(file->pragma_onced_files) = path_string_id;
+	file->pragma_onced_hash += hcc_ppgen_string_hash(path_string_id, HCC_HASH_FNV_64_INIT);
+
+	HccATAIncludeEffect* effect = hcc_stack_push(file->include_effects);
+	effect->type = HCC_ATA_INCLUDE_EFFECT_TYPE_PRAGMA_ONCE;
+	effect->string_id = path_string_id;
 }
 
 void hcc_ast_file_found_included_file(HccASTFile* file, HccStringId path_string_id) {
@@ -495,6 +538,10 @@ void hcc_ast_file_found_included_file(HccASTFile* file, HccStringId path_string_
 	}
 
 	*hcc_stack_push(file->unique_included_files) = path_string_id;
+
+	HccATAIncludeEffect* effect = hcc_stack_push(file->include_effects);
+	effect->type = HCC_ATA_INCLUDE_EFFECT_TYPE_FOUND_INCLUDED_FILE;
+	effect->string_id = path_string_id;
 }
 
 // ===========================================
@@ -510,30 +557,130 @@ void hcc_ast_init(HccCU* cu, HccCUSetup* setup) {
 	cu->ast.files_hash_table = hcc_hash_table_init(HccASTFileEntry, HCC_ALLOC_TAG_AST_FILES_HASH_TABLE, hcc_string_key_cmp, hcc_string_key_hash, setup->ast.files_cap);
 	cu->ast.files = hcc_stack_init(HccASTFile*, HCC_ALLOC_TAG_AST_FILES, setup->ast.files_cap, setup->ast.files_cap);
 	cu->ast.function_params_and_variables = hcc_stack_init(HccASTVariable, HCC_ALLOC_TAG_AST_FUNCTION_PARAMS_AND_VARIABLES, setup->function_params_and_variables_grow_count, setup->function_params_and_variables_reserve_cap);
+	cu->ast.function_callees = hcc_stack_init(HccDecl, HCC_ALLOC_TAG_AST_FUNCTION_CALLEES, setup->function_callees_grow_count, setup->function_callees_reserve_cap);
 	cu->ast.functions = hcc_stack_init(HccASTFunction, HCC_ALLOC_TAG_AST_FUNCTIONS, setup->functions_grow_count, setup->functions_reserve_cap);
 	cu->ast.exprs = hcc_stack_init(HccASTExpr, HCC_ALLOC_TAG_AST_EXPRS, setup->ast.exprs_grow_count, setup->ast.exprs_reserve_cap);
 	cu->ast.global_variables = hcc_stack_init(HccASTVariable, HCC_ALLOC_TAG_AST_GLOBAL_VARIBALES, setup->ast.global_variables_grow_count, setup->ast.global_variables_reserve_cap);
 	cu->ast.forward_declarations = hcc_stack_init(HccASTForwardDecl, HCC_ALLOC_TAG_AST_FORWARD_DECLARTIONS, setup->ast.forward_declarations_grow_count, setup->ast.forward_declarations_reserve_cap);
 	cu->ast.designated_initializer_elmt_indices = hcc_stack_init(uint64_t, HCC_ALLOC_TAG_AST_DESIGNATED_INITIALIZER_ELMT_INDICES, setup->ast.designated_initializer_elmt_indices_grow_count, setup->ast.designated_initializer_elmt_indices_reserve_cap);
+	cu->ast.include_cache = hcc_hash_table_init(HccATAIncludeCacheEntry, HCC_ALLOC_TAG_AST_INCLUDE_CACHE, hcc_ata_include_cache_key_cmp, hcc_ata_include_cache_key_hash, setup->ast.include_cache_cap);
+	cu->ast.reachable_function_decls = hcc_stack_init(HccDecl, HCC_ALLOC_TAG_AST_REACHABLE_FUNCTION_DECLS, setup->functions_grow_count, setup->functions_reserve_cap);
+	cu->ast.unlinked_reachable_function_decls = hcc_stack_init(HccDecl, HCC_ALLOC_TAG_AST_UNLINKED_REACHABLE_FUNCTION_DECLS, setup->functions_grow_count, setup->functions_reserve_cap);
+	hcc_spin_mutex_init(&cu->ast.reachable_mutex);
 
 	//
 	// preallocate all the intrinsic functions
 	hcc_stack_resize(cu->ast.functions, HCC_FUNCTION_IDX_USER_START);
 }
 
-void hcc_ast_deinit(HccCU* cu) {
-	for (uint32_t idx = 0; idx < hcc_hash_table_cap(cu->ast.files_hash_table); idx += 1) {
+static void hcc_ast_files_deinit(HccCU* cu) {
+	for (uint32_t idx = 0; idx < hcc_hash_table_count(cu->ast.files_hash_table); idx += 1) {
 		HccASTFileEntry* entry = &cu->ast.files_hash_table[idx];
-		if (entry->path.data) {
+		if (hcc_hash_table_is_elmt_used(cu->ast.files_hash_table, idx)) {
 			hcc_ast_file_deinit(&entry->file);
 		}
 	}
+}
+
+void hcc_ast_deinit(HccCU* cu) {
+	hcc_ast_files_deinit(cu);
 	hcc_hash_table_deinit(cu->ast.files_hash_table);
 	hcc_stack_deinit(cu->ast.files);
 	hcc_stack_deinit(cu->ast.function_params_and_variables);
+	hcc_stack_deinit(cu->ast.function_callees);
 	hcc_stack_deinit(cu->ast.functions);
 	hcc_stack_deinit(cu->ast.exprs);
 	hcc_stack_deinit(cu->ast.global_variables);
+	hcc_stack_deinit(cu->ast.forward_declarations);
+	hcc_stack_deinit(cu->ast.designated_initializer_elmt_indices);
+	hcc_hash_table_deinit(cu->ast.include_cache);
+	hcc_stack_deinit(cu->ast.reachable_function_decls);
+	hcc_stack_deinit(cu->ast.unlinked_reachable_function_decls);
+}
+
+void hcc_ast_reset(HccCU* cu) {
+	//
+	// the files are recreated by hcc_ast_add_file, the include cache points into them so it goes too.
+	hcc_ast_files_deinit(cu);
+	hcc_hash_table_clear(cu->ast.files_hash_table);
+	hcc_hash_table_clear(cu->ast.include_cache);
+	hcc_stack_reset(cu->ast.files);
+	hcc_stack_reset(cu->ast.function_params_and_variables);
+	hcc_stack_reset(cu->ast.function_callees);
+	hcc_stack_reset(cu->ast.functions);
+	hcc_stack_reset(cu->ast.exprs);
+	hcc_stack_reset(cu->ast.global_variables);
+	hcc_stack_reset(cu->ast.forward_declarations);
+	hcc_stack_reset(cu->ast.designated_initializer_elmt_indices);
+	hcc_stack_reset(cu->ast.reachable_function_decls);
+	hcc_stack_reset(cu->ast.unlinked_reachable_function_decls);
+
+	//
+	// preallocate all the intrinsic functions
+	hcc_stack_resize(cu->ast.functions, HCC_FUNCTION_IDX_USER_START);
+}
+
+void hcc_ast_seed_reachable_functions(HccCU* cu) {
+	hcc_stack_clear(cu->ast.reachable_function_decls);
+	hcc_stack_clear(cu->ast.unlinked_reachable_function_decls);
+
+	for (uint32_t shader_idx = 0; shader_idx < hcc_stack_count(cu->shader_function_decls); shader_idx += 1) {
+		HccDecl decl = cu->shader_function_decls[shader_idx];
+		HccASTFunction* function = hcc_ast_function_get(cu, decl);
+		if (!(function->flags & HCC_AST_FUNCTION_FLAGS_IS_REACHABLE)) {
+			function->flags |= HCC_AST_FUNCTION_FLAGS_IS_REACHABLE;
+			*hcc_stack_push(cu->ast.unlinked_reachable_function_decls) = decl;
+		}
+	}
+}
+
+void hcc_ast_find_reachable_functions(HccCU* cu, HccASTFile* linked_file, uint32_t* start_idx_out, uint32_t* end_idx_out) {
+	HccStack(HccDecl) reachable_function_decls = cu->ast.reachable_function_decls;
+	HccStack(HccDecl) unlinked_reachable_function_decls = cu->ast.unlinked_reachable_function_decls;
+
+	hcc_spin_mutex_lock(&cu->ast.reachable_mutex);
+	linked_file->is_linked = true;
+	uint32_t start_idx = hcc_stack_count(reachable_function_decls);
+
+	//
+	// take out the functions that have been waiting on this file to be linked
+	for (uint32_t idx = 0; idx < hcc_stack_count(unlinked_reachable_function_decls); ) {
+		HccDecl decl = unlinked_reachable_function_decls[idx];
+		if (hcc_ast_function_get(cu, decl)->ast_file == linked_file) {
+			*hcc_stack_push(reachable_function_decls) = decl;
+			hcc_stack_remove_swap(unlinked_reachable_function_decls, idx);
+		} else {
+			idx += 1;
+		}
+	}
+
+	//
+	// the stack doubles as the work list, so keep going until every new function has had its callees visited
+	for (uint32_t idx = start_idx; idx < hcc_stack_count(reachable_function_decls); idx += 1) {
+		HccASTFunction* function = hcc_ast_function_get(cu, reachable_function_decls[idx]);
+		for (uint32_t callee_idx = 0; callee_idx < function->callees_count; callee_idx += 1) {
+			HccDecl callee_decl = hcc_decl_resolve_and_strip_qualifiers(cu, function->callees[callee_idx]);
+			if (HCC_DECL_IS_FORWARD_DECL(callee_decl) || HCC_DECL_AUX(callee_decl) < HCC_FUNCTION_IDX_USER_START) {
+				//
+				// intrinsics are generated inline and an undefined function has already been reported by ASTLINK
+				continue;
+			}
+
+			HccASTFunction* callee = hcc_ast_function_get(cu, callee_decl);
+			if (!(callee->flags & HCC_AST_FUNCTION_FLAGS_IS_REACHABLE)) {
+				callee->flags |= HCC_AST_FUNCTION_FLAGS_IS_REACHABLE;
+				if (callee->ast_file->is_linked) {
+					*hcc_stack_push(reachable_function_decls) = callee_decl;
+				} else {
+					*hcc_stack_push(unlinked_reachable_function_decls) = callee_decl;
+				}
+			}
+		}
+	}
+
+	*start_idx_out = start_idx;
+	*end_idx_out = hcc_stack_count(reachable_function_decls);
+	hcc_spin_mutex_unlock(&cu->ast.reachable_mutex);
 }
 
 void hcc_ast_add_file(HccCU* cu, HccString file_path, HccASTFile** out) {
@@ -542,7 +689,7 @@ void hcc_ast_add_file(HccCU* cu, HccString file_path, HccASTFile** out) {
 
 	HccASTFile* ast_file = &cu->ast.files_hash_table[insert.idx].file;
 	*out = ast_file;
-	hcc_ast_file_init(*out, cu, &cu->ast.file_setup, file_path);
+	hcc_ast_file_init(*out, &cu->ast.file_setup, file_path);
 
 	*hcc_stack_push(cu->ast.files) = ast_file;
 }
@@ -887,9 +1034,9 @@ void hcc_ast_print_expr(HccCU* cu, HccASTFunction* function, HccASTExpr* expr, u
 }
 
 void hcc_ast_print(HccCU* cu, HccIIO* iio) {
-	for (uint32_t file_idx = 0; file_idx < hcc_hash_table_cap(cu->ast.files_hash_table); file_idx += 1) {
+	for (uint32_t file_idx = 0; file_idx < hcc_hash_table_count(cu->ast.files_hash_table); file_idx += 1) {
 		HccASTFileEntry* entry = &cu->ast.files_hash_table[file_idx];
-		if (entry->path.data == NULL) {
+		if (!hcc_hash_table_is_elmt_used(cu->ast.files_hash_table, file_idx)) {
 			continue;
 		}
 		HccASTFile* file = &entry->file;
@@ -25,12 +25,13 @@ void hcc_astgen_init(HccWorker* w, HccASTGenSetup* setup) {
 	w->astgen.compound_field_locations = hcc_stack_init(HccLocation*, HCC_ALLOC_TAG_ASTGEN_COMPOUND_FIELD_LOCATIONS, setup->compound_fields_reserve_cap, setup->compound_fields_reserve_cap);
 	w->astgen.compound_fields = hcc_stack_init(HccCompoundField, HCC_ALLOC_TAG_ASTGEN_COMPOUND_FIELDS, setup->compound_fields_reserve_cap, setup->compound_fields_reserve_cap);
 	w->astgen.function_params_and_variables = hcc_stack_init(HccASTVariable, HCC_ALLOC_TAG_ASTGEN_FUNCTION_PARAMS_AND_VARIABLES, setup->function_params_and_variables_reserve_cap, setup->function_params_and_variables_reserve_cap);
+	w->astgen.function_callees = hcc_stack_init(HccDecl, HCC_ALLOC_TAG_ASTGEN_FUNCTION_CALLEES, setup->function_callees_grow_count, setup->function_callees_reserve_cap);
 	w->astgen.enum_values = hcc_stack_init(HccEnumValue, HCC_ALLOC_TAG_ASTGEN_ENUM_VALUES, setup->enum_values_reserve_cap, setup->enum_values_reserve_cap);
 
 	w->astgen.curly_initializer.nested = hcc_stack_init(HccASTGenCurlyInitializerNested, HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_NESTED, setup->curly_initializer_nested_reserve_cap, setup->curly_initializer_nested_reserve_cap);
 	w->astgen.curly_initializer.nested_curlys = hcc_stack_init(HccASTGenCurlyInitializerCurly, HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_NESTED_CURLYS, setup->curly_initializer_nested_curlys_reserve_cap, setup->curly_initializer_nested_curlys_reserve_cap);
 	w->astgen.curly_initializer.nested_elmts = hcc_stack_init(HccASTGenCurlyInitializerElmt, HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_NESTED_ELMTS, setup->curly_initializer_nested_elmts_reserve_cap, setup->curly_initializer_nested_elmts_reserve_cap);
-	w->astgen.curly_initializer.composite_constant_ids = hcc_stack_init(HccConstantId, 0, setup->curly_initializer_composite_constant_ids_grow_count, setup->curly_initializer_composite_constant_ids_reserve_cap);
+	w->astgen.curly_initializer.composite_constant_ids = hcc_stack_init(HccConstantId, HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_COMPOSITE_CONSTANT_IDS, setup->curly_initializer_composite_constant_ids_grow_count, setup->curly_initializer_composite_constant_ids_reserve_cap);
 }
 
 void hcc_astgen_deinit(HccWorker* w) {
@@ -39,6 +40,7 @@ void hcc_astgen_deinit(HccWorker* w) {
 	hcc_stack_deinit(w->astgen.compound_type_find_fields);
 	hcc_stack_deinit(w->astgen.compound_field_names);
 	hcc_stack_deinit(w->astgen.compound_field_locations);
+	hcc_stack_deinit(w->astgen.function_callees);
 	hcc_stack_deinit(w->astgen.curly_initializer.composite_constant_ids);
 }
 
@@ -49,6 +51,7 @@ void hcc_astgen_reset(HccWorker* w) {
 	hcc_stack_clear(w->astgen.curly_initializer.nested_elmts);
 	hcc_stack_clear(w->astgen.compound_fields);
 	hcc_stack_clear(w->astgen.function_params_and_variables);
+	hcc_stack_clear(w->astgen.function_callees);
 	hcc_stack_clear(w->astgen.variable_stack_strings);
 	hcc_stack_clear(w->astgen.variable_stack);
 	hcc_stack_clear(w->astgen.compound_type_find_fields);
@@ -1642,7 +1645,7 @@ MAKE_NEW: {}
 				//
 				// our thread claimed the atomic link which means this enum is unique with this identifier.
 				// so now lets setup the enum and atomic link.
-				HccEnumValue* dst_enum_values = hcc_stack_push_many_thread_safe(cu->dtt.enum_values, enum_data_type.values_count);
+				HccEnumValue* dst_enum_values = hcc_cu_stack_push_many(cu, cu->dtt.enum_values, HCC_CU_STACK_CHUNK_DTT_ENUM_VALUES, enum_data_type.values_count);
 				HCC_COPY_ELMT_MANY(dst_enum_values, enum_data_type.values, enum_data_type.values_count);
 				enum_data_type.values = dst_enum_values;
 
@@ -1683,7 +1686,7 @@ MAKE_NEW: {}
 			link_ptr = &link->next;
 		}
 	} else {
-		HccEnumValue* dst_enum_values = hcc_stack_push_many_thread_safe(cu->dtt.enum_values, enum_data_type.values_count);
+		HccEnumValue* dst_enum_values = hcc_cu_stack_push_many(cu, cu->dtt.enum_values, HCC_CU_STACK_CHUNK_DTT_ENUM_VALUES, enum_data_type.values_count);
 		HCC_COPY_ELMT_MANY(dst_enum_values, enum_data_type.values, enum_data_type.values_count);
 		enum_data_type.values = dst_enum_values;
 	}
@@ -2064,7 +2067,7 @@ HccDataType hcc_astgen_generate_compound_data_type(HccWorker* w) {
 	compound_data_type.storage_fields_count = compound_data_type.fields_count;
 
 	if (found_bitfield) {
-		compound_data_type.storage_fields = hcc_stack_push_many_thread_safe(cu->dtt.compound_fields, compound_data_type.fields_count);
+		compound_data_type.storage_fields = hcc_cu_stack_push_many(cu, cu->dtt.compound_fields, HCC_CU_STACK_CHUNK_DTT_COMPOUND_FIELDS, compound_data_type.fields_count);
 	} else {
 		compound_data_type.storage_fields = compound_data_type.fields;
 	}
@@ -2266,7 +2269,7 @@ HccDataType hcc_astgen_generate_compound_data_type(HccWorker* w) {
 			//
 			// our thread claimed the atomic link which means this compound data type is unique with this identifier.
 			// so now lets setup the enum and atomic link.
-			HccCompoundField* new_fields = hcc_stack_push_many_thread_safe(cu->dtt.compound_fields, compound_data_type.fields_count);
+			HccCompoundField* new_fields = hcc_cu_stack_push_many(cu, cu->dtt.compound_fields, HCC_CU_STACK_CHUNK_DTT_COMPOUND_FIELDS, compound_data_type.fields_count);
 			HCC_COPY_ELMT_MANY(new_fields, compound_data_type.fields, compound_data_type.fields_count);
 			compound_data_type.fields = new_fields;
 			if (!found_bitfield) {
@@ -3901,6 +3904,7 @@ HccASTExpr* hcc_astgen_generate_call_expr(HccWorker* w, HccASTExpr* function_exp
 	hcc_astgen_ensure_function_args_count(w, function_decl, args_count);
 
 	if (w->astgen.function) {
+		*hcc_stack_push(w->astgen.function_callees) = function_decl;
 		if (function_expr->type != HCC_AST_EXPR_TYPE_FUNCTION || HCC_AML_OPERAND_AUX(function_decl) >= HCC_FUNCTION_IDX_USER_START) {
 			w->astgen.function->max_instrs_count += 1; // HCC_AML_OP_CALL
 		} else {
@@ -5057,7 +5061,9 @@ void hcc_astgen_generate_function(HccWorker* w, HccDataType return_data_type, Hc
 	HccCU* cu = w->cu;
 	HccASTFunction function = {0};
 	w->astgen.function = &function;
+	hcc_stack_clear(w->astgen.function_callees);
 	function.identifier_location = identifier_location;
+	function.ast_file = w->astgen.ast_file;
 	function.shader_stage = shader_stage;
 	function.flags = flags;
 	function.linkage = found_static ? HCC_AST_LINKAGE_INTERNAL : HCC_AST_LINKAGE_EXTERNAL;
@@ -5325,10 +5331,15 @@ END: {}
 
 	HccDecl decl = 0;
 	bool is_definition = w->astgen.function != NULL;
+	if (is_definition) {
+		function.callees_count = hcc_stack_count(w->astgen.function_callees);
+		function.callees = hcc_cu_stack_push_many(cu, cu->ast.function_callees, HCC_CU_STACK_CHUNK_AST_FUNCTION_CALLEES, function.callees_count);
+		HCC_COPY_ELMT_MANY(function.callees, w->astgen.function_callees, function.callees_count);
+	}
 	if (is_definition && found_static && !is_intrinsic) {
 		//
 		// found static global variable so just add it to the global variable array for the AST
-		HccASTVariable* params_and_variables = hcc_stack_push_many_thread_safe(cu->ast.function_params_and_variables, function.variables_count);
+		HccASTVariable* params_and_variables = hcc_cu_stack_push_many(cu, cu->ast.function_params_and_variables, HCC_CU_STACK_CHUNK_AST_FUNCTION_PARAMS_AND_VARIABLES, function.variables_count);
 		HCC_COPY_ELMT_MANY(params_and_variables, w->astgen.function_params_and_variables, function.variables_count);
 		function.params_and_variables = params_and_variables;
 
@@ -5350,7 +5361,7 @@ END: {}
 				//
 				// our thread claimed the atomic link which means adding this function to the compilation unit is okay.
 				// so now lets setup the function and atomic link.
-				HccASTVariable* params_and_variables = hcc_stack_push_many_thread_safe(cu->ast.function_params_and_variables, function.variables_count);
+				HccASTVariable* params_and_variables = hcc_cu_stack_push_many(cu, cu->ast.function_params_and_variables, HCC_CU_STACK_CHUNK_AST_FUNCTION_PARAMS_AND_VARIABLES, function.variables_count);
 				HCC_COPY_ELMT_MANY(params_and_variables, w->astgen.function_params_and_variables, function.variables_count);
 				function.params_and_variables = params_and_variables;
 
@@ -5415,7 +5426,7 @@ END: {}
 			forward_decl->function.return_data_type = function.return_data_type;
 			forward_decl->function.function_data_type = function.function_data_type;
 
-			HccASTVariable* params_and_variables = hcc_stack_push_many_thread_safe(cu->ast.function_params_and_variables, function.variables_count);
+			HccASTVariable* params_and_variables = hcc_cu_stack_push_many(cu, cu->ast.function_params_and_variables, HCC_CU_STACK_CHUNK_AST_FUNCTION_PARAMS_AND_VARIABLES, function.variables_count);
 			HCC_COPY_ELMT_MANY(params_and_variables, w->astgen.function_params_and_variables, function.variables_count);
 			forward_decl->function.params = params_and_variables;
 			forward_decl->function.params_count = function.params_count;
@@ -5498,6 +5509,7 @@ END: {}
 
 void hcc_astgen_generate(HccWorker* w) {
 	w->astgen.ast_file = w->job.arg;
+	hcc_ast_file_init_declarations(w->astgen.ast_file, w->cu);
 	w->astgen.token_iter = hcc_ata_iter_start(w->astgen.ast_file);
 
 	while (1) {
@@ -285,6 +285,20 @@ uint32_t hcc_ata_token_num_values(HccATAToken token) {
 	}
 }
 
+HccATAValueType hcc_ata_token_value_type(HccATAToken token, uint32_t value_idx) {
+	HCC_DEBUG_ASSERT(value_idx < hcc_ata_token_num_values(token), "value index '%u' is out of bounds for the '%s' token", value_idx, hcc_ata_token_strings[token]);
+	switch (token) {
+		case HCC_ATA_TOKEN_MACRO_PARAM:
+		case HCC_ATA_TOKEN_MACRO_STRINGIFY:
+		case HCC_ATA_TOKEN_MACRO_STRINGIFY_WHITESPACE:
+			return HCC_ATA_VALUE_TYPE_MACRO_PARAM_IDX;
+		default:
+			//
+			// number literals have a constant followed by the string of the literal
+			return HCC_ATA_TOKEN_IS_LIT_NUMBER(token) && value_idx == 0 ? HCC_ATA_VALUE_TYPE_CONSTANT_ID : HCC_ATA_VALUE_TYPE_STRING_ID;
+	}
+}
+
 bool hcc_ata_token_concat_is_okay(HccATAToken before, HccATAToken after) {
 	return (
 		(HCC_ATA_TOKEN_IS_LIT_NUMBER(before) &&
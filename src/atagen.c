@@ -39,6 +39,7 @@ void hcc_ppgen_reset(HccWorker* w) {
 	HccOptions* options = hcc_worker_cu(w)->options;
 	HccTargetArch target_arch = hcc_options_get_u32(options, HCC_OPTION_KEY_TARGET_ARCH);
 	HccTargetOS target_os = hcc_options_get_u32(options, HCC_OPTION_KEY_TARGET_OS);
+	w->atagen.macro_state_hash = 0;
 	for (HccPPPredefinedMacro m = 0; m < HCC_PP_PREDEFINED_MACRO_COUNT; m += 1) {
 		if (m == HCC_PP_PREDEFINED_MACRO___HCC_LINUX__ && target_os != HCC_TARGET_OS_LINUX) {
 			continue;
@@ -54,12 +55,13 @@ void hcc_ppgen_reset(HccWorker* w) {
 		HccHashTableInsert insert = hcc_hash_table_find_insert_idx(w->atagen.ppgen.macro_declarations, &identifier_string_id);
 		HCC_DEBUG_ASSERT(insert.is_new, "internal error: predefined macro has already been initialized");
 		w->atagen.ppgen.macro_declarations[insert.idx].macro_idx = UINT32_MAX;
+		w->atagen.macro_state_hash += hcc_ppgen_predefined_macro_content_hash(identifier_string_id);
 	}
 }
 
 HccPPIfSpan* hcc_ppgen_if_span_get(HccWorker* w, uint32_t pp_if_span_id) {
 	HCC_DEBUG_ASSERT(
-		w->atagen.we_are_mutator_of_code_file || (atomic_load(&w->atagen.location.code_file->flags) & HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS),
+		w->atagen.we_are_mutator_of_code_file || w->atagen.is_code_file_mutator_pass_completed,
 		"we can only get the pp if span if we are the mutator of the code file or the code file has been atagen'd before by the mutator of the code file"
 	);
 	HCC_DEBUG_ASSERT_NON_ZERO(pp_if_span_id);
@@ -70,7 +72,7 @@ HccPPIfSpan* hcc_ppgen_if_span_get(HccWorker* w, uint32_t pp_if_span_id) {
 uint32_t hcc_ppgen_if_span_id(HccWorker* w, HccPPIfSpan* if_span) {
 	HccCodeFile* code_file = w->atagen.location.code_file;
 	HCC_DEBUG_ASSERT(
-		w->atagen.we_are_mutator_of_code_file || (atomic_load(&w->atagen.location.code_file->flags) & HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS),
+		w->atagen.we_are_mutator_of_code_file || w->atagen.is_code_file_mutator_pass_completed,
 		"we can only get the pp if span if we are the mutator of the code file or the code file has been atagen'd before by the mutator of the code file"
 	);
 	HCC_DEBUG_ASSERT(code_file->pp_if_spans <= if_span && if_span <= hcc_stack_get_last(code_file->pp_if_spans), "if_span is out of the array bounds");
@@ -83,7 +85,7 @@ HccPPIfSpan* hcc_ppgen_if_span_push(HccWorker* w, HccPPDirective directive) {
 	w->atagen.pp_if_span_id += 1;
 
 	HccPPIfSpan* pp_if_span = NULL;
-	if (!(atomic_load(&code_file->flags) & HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS)) {
+	if (!w->atagen.is_code_file_mutator_pass_completed) {
 		if (w->atagen.we_are_mutator_of_code_file) {
 #if HCC_DEBUG_CODE_IF_SPAN
 			printf("#%s at line %u\n", hcc_pp_directive_strings[directive], w->atagen.location.line_start);
@@ -132,11 +134,10 @@ void hcc_ppgen_if_found_if(HccWorker* w, HccPPDirective directive) {
 }
 
 HccPPIfSpan* hcc_ppgen_if_found_if_counterpart(HccWorker* w, HccPPDirective directive) {
-	HccCodeFile* code_file = w->atagen.location.code_file;
 	HccPPIfSpan* counterpart = hcc_ppgen_if_span_push(w, directive);
 
 	if (w->atagen.we_are_mutator_of_code_file) {
-		if (!(atomic_load(&code_file->flags) & HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS)) {
+		if (!w->atagen.is_code_file_mutator_pass_completed) {
 			uint32_t counterpart_id = hcc_ppgen_if_span_id(w, counterpart);
 			HccPPIfSpan* pp_if_span = hcc_ppgen_if_span_get(w, hcc_stack_get_last(w->atagen.ppgen.if_stack)->start_span_id);
 			counterpart->first_id = hcc_ppgen_if_span_id(w, pp_if_span);
@@ -172,8 +173,7 @@ void hcc_ppgen_if_found_else(HccWorker* w, HccPPDirective directive) {
 void hcc_ppgen_if_ensure_first_else(HccWorker* w, HccPPDirective directive) {
 	HccPPGenIf* pp_if = hcc_stack_get_last(w->atagen.ppgen.if_stack);
 
-	HccCodeFile* code_file = w->atagen.location.code_file;
-	if (!(atomic_load(&code_file->flags) & HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS)) {
+	if (!w->atagen.is_code_file_mutator_pass_completed) {
 		if (pp_if->has_else) {
 			hcc_atagen_bail_error_2(w, HCC_ERROR_CODE_PP_ELSEIF_CANNOT_FOLLOW_ELSE, &w->atagen.location, &pp_if->location, hcc_pp_directive_strings[directive]);
 		}
@@ -186,6 +186,89 @@ void hcc_ppgen_if_ensure_one_is_open(HccWorker* w, HccPPDirective directive) {
 	}
 }
 
+uint32_t hcc_ppgen_skip_whitespace_and_comments(HccString code, uint32_t code_idx) {
+	while (code_idx < code.size) {
+		char byte = code.data[code_idx];
+		if (byte == ' ' || byte == '\t' || byte == '\r' || byte == '\n') {
+			code_idx += 1;
+		} else if (byte == '/' && code_idx + 1 < code.size && code.data[code_idx + 1] == '/') {
+			while (code_idx < code.size && code.data[code_idx] != '\n') {
+				code_idx += 1;
+			}
+		} else if (byte == '/' && code_idx + 1 < code.size && code.data[code_idx + 1] == '*') {
+			code_idx += 2;
+			while (code_idx + 1 < code.size && !(code.data[code_idx] == '*' && code.data[code_idx + 1] == '/')) {
+				code_idx += 1;
+			}
+			code_idx += 2;
+		} else {
+			break;
+		}
+	}
+
+	return HCC_MIN(code_idx, code.size);
+}
+
+void hcc_ppgen_find_include_guard(HccCodeFile* code_file) {
+	//
+	// the whole file must be inside of a single #ifndef X ... #endif with nothing but whitespace and comments around it.
+	// then every time the file is included with X defined it will not produce anything, so it does not need to be opened.
+	// this is called once the mutator pass is complete, so the #ifndef and it's #endif are the first of the pp_if_spans.
+	code_file->include_guard_string_id.idx_plus_one = 0;
+	if (hcc_stack_count(code_file->pp_if_spans) < 2) {
+		return;
+	}
+
+	HccPPIfSpan* ifndef_span = hcc_stack_get(code_file->pp_if_spans, 0);
+	if (ifndef_span->directive != HCC_PP_DIRECTIVE_IFNDEF || ifndef_span->next_id != ifndef_span->last_id) {
+		return;
+	}
+
+	HccString code = code_file->code;
+	uint32_t code_idx = hcc_ppgen_skip_whitespace_and_comments(code, 0);
+	if (code_idx == code.size || code.data[code_idx] != '#') {
+		return;
+	}
+
+	code_idx += 1;
+	while (code_idx < code.size && (code.data[code_idx] == ' ' || code.data[code_idx] == '\t')) {
+		code_idx += 1;
+	}
+
+	HccString ifndef_string = hcc_string_lit("ifndef");
+	if (code.size - code_idx <= ifndef_string.size || memcmp(&code.data[code_idx], ifndef_string.data, ifndef_string.size) != 0) {
+		return;
+	}
+
+	code_idx += ifndef_string.size;
+	while (code_idx < code.size && (code.data[code_idx] == ' ' || code.data[code_idx] == '\t')) {
+		code_idx += 1;
+	}
+
+	uint32_t identifier_start_idx = code_idx;
+	while (code_idx < code.size) {
+		char byte = code.data[code_idx];
+		if (!(byte == '_' || (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') || (code_idx != identifier_start_idx && byte >= '0' && byte <= '9'))) {
+			break;
+		}
+		code_idx += 1;
+	}
+
+	if (code_idx == identifier_start_idx) {
+		return;
+	}
+
+	//
+	// the location of the #endif span ends just after the directive's name
+	HccPPIfSpan* endif_span = hcc_stack_get(code_file->pp_if_spans, ifndef_span->last_id - 1);
+	HCC_DEBUG_ASSERT(endif_span->directive == HCC_PP_DIRECTIVE_ENDIF, "internal error: expected the last span to be the #endif");
+	if (hcc_ppgen_skip_whitespace_and_comments(code, endif_span->location.code_end_idx) != code.size) {
+		return;
+	}
+
+	hcc_string_table_deduplicate(&code.data[identifier_start_idx], code_idx - identifier_start_idx, &code_file->include_guard_string_id);
+}
+
 void hcc_ppgen_eval_binary_op(HccWorker* w, uint32_t* token_idx_mut, HccASTBinaryOp* binary_op_type_out, uint32_t* precedence_out) {
 	HccATAToken token = *hcc_stack_get(w->atagen.ast_file->token_bag.tokens, *token_idx_mut);
 	switch (token) {
@@ -356,6 +439,51 @@ void hcc_ppgen_ensure_end_of_directive(HccWorker* w, HccErrorCode error_code, Hc
 	}
 }
 
+HccHash64 hcc_ppgen_string_hash(HccStringId string_id, HccHash64 hash) {
+	HccString string = hcc_string_table_get(string_id);
+	hash = hcc_hash_fnv_64(&string.size, sizeof(string.size), hash);
+	return hcc_hash_fnv_64(string.data, string.size, hash);
+}
+
+HccHash64 hcc_ppgen_predefined_macro_content_hash(HccStringId identifier_string_id) {
+	return hcc_ppgen_string_hash(identifier_string_id, HCC_HASH_FNV_64_INIT);
+}
+
+HccHash64 hcc_ppgen_macro_content_hash(HccPPMacro* macro, HccATATokenBag* macro_token_bag) {
+	//
+	// the strings are hashed instead of their identifiers and number literals are hashed by their string and not their constant
+	// so the same macro has the same hash in every compiler process. this lets the hash be part of the name of a precompiled header.
+	uint32_t tokens_count = hcc_ata_token_cursor_tokens_count(&macro->token_cursor);
+	uint32_t params_count = macro->params_count;
+	uint8_t flags = macro->is_function | (macro->has_va_args << 1);
+
+	HccHash64 hash = hcc_ppgen_string_hash(macro->identifier_string_id, HCC_HASH_FNV_64_INIT);
+	hash = hcc_hash_fnv_64(&flags, sizeof(flags), hash);
+	hash = hcc_hash_fnv_64(&params_count, sizeof(params_count), hash);
+	for (uint32_t param_idx = 0; param_idx < params_count; param_idx += 1) {
+		hash = hcc_ppgen_string_hash(macro->params[param_idx], hash);
+	}
+	hash = hcc_hash_fnv_64(&tokens_count, sizeof(tokens_count), hash);
+	hash = hcc_hash_fnv_64(hcc_stack_get_or_null(macro_token_bag->tokens, macro->token_cursor.tokens_start_idx), tokens_count * sizeof(HccATAToken), hash);
+
+	uint32_t token_value_idx = macro->token_cursor.token_value_idx;
+	for (uint32_t token_idx = macro->token_cursor.tokens_start_idx; token_idx < macro->token_cursor.tokens_end_idx; token_idx += 1) {
+		HccATAToken token = *hcc_stack_get(macro_token_bag->tokens, token_idx);
+		uint32_t num_values = hcc_ata_token_num_values(token);
+		for (uint32_t value_idx = 0; value_idx < num_values; value_idx += 1) {
+			HccATAValue value = *hcc_stack_get(macro_token_bag->values, token_value_idx);
+			switch (hcc_ata_token_value_type(token, value_idx)) {
+				case HCC_ATA_VALUE_TYPE_STRING_ID: hash = hcc_ppgen_string_hash(value.string_id, hash); break;
+				case HCC_ATA_VALUE_TYPE_CONSTANT_ID: break; // the string of the number literal follows
+				case HCC_ATA_VALUE_TYPE_MACRO_PARAM_IDX: hash = hcc_hash_fnv_64(&value.macro_param_idx, sizeof(value.macro_param_idx), hash); break;
+			}
+			token_value_idx += 1;
+		}
+	}
+
+	return hash;
+}
+
 void hcc_ppgen_parse_define(HccWorker* w) {
 	//
 	// skip the whitespace after the #define
@@ -517,6 +645,11 @@ void hcc_ppgen_parse_define(HccWorker* w) {
 	macro->params_count = params_count;
 	macro->is_function = is_function;
 	macro->has_va_args = has_va_args;
+	macro->token_values_count = token_values_count;
+	macro->content_hash = hcc_ppgen_macro_content_hash(macro, &w->atagen.ast_file->macro_token_bag);
+
+	w->atagen.macro_state_hash += macro->content_hash;
+	hcc_atagen_include_effect_push(w, HCC_ATA_INCLUDE_EFFECT_TYPE_DEFINE, entry->macro_idx);
 }
 
 void hcc_ppgen_parse_undef(HccWorker* w) {
@@ -534,56 +667,55 @@ void hcc_ppgen_parse_undef(HccWorker* w) {
 
 	//
 	// remove the macro from the hash table. we do not need to error if the macro is not defined.
-	hcc_hash_table_remove(w->atagen.ppgen.macro_declarations, &identifier_string_id);
+	uintptr_t found_idx = hcc_hash_table_find_idx(w->atagen.ppgen.macro_declarations, &identifier_string_id);
+	if (found_idx != UINTPTR_MAX) {
+		uint32_t macro_idx = w->atagen.ppgen.macro_declarations[found_idx].macro_idx;
+		w->atagen.macro_state_hash -= macro_idx == UINT32_MAX
+			? hcc_ppgen_predefined_macro_content_hash(identifier_string_id)
+			: hcc_stack_get(w->atagen.ast_file->macros, macro_idx)->content_hash;
+
+		hcc_hash_table_remove(w->atagen.ppgen.macro_declarations, &identifier_string_id);
+		hcc_atagen_include_effect_push(w, HCC_ATA_INCLUDE_EFFECT_TYPE_UNDEF, identifier_string_id.idx_plus_one);
+	}
 
 	hcc_ppgen_ensure_end_of_directive(w, HCC_ERROR_CODE_TOO_MANY_UNDEF_OPERANDS, HCC_PP_DIRECTIVE_UNDEF);
 }
 
-void hcc_ppgen_parse_include(HccWorker* w) {
-	hcc_atagen_consume_whitespace(w);
-	w->atagen.location.code_start_idx = w->atagen.location.code_end_idx;
-	w->atagen.location.column_start = w->atagen.location.column_end;
-
-	//
-	// run the tokenizer to get the single operand and expand any macros
-	HccATATokenBag* token_bag = &w->atagen.ast_file->token_bag;
-	uint32_t tokens_start_idx = hcc_stack_count(token_bag->tokens);
-	uint32_t token_values_start_idx = hcc_stack_count(token_bag->values);
-	uint32_t token_location_indices_start_idx = hcc_stack_count(token_bag->locations);
-	hcc_atagen_run(w, token_bag, HCC_ATAGEN_RUN_MODE_PP_INCLUDE_OPERAND);
-
-	//
-	// error if no operands found
-	if (tokens_start_idx == hcc_stack_count(token_bag->tokens)) {
-		hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_INVALID_INCLUDE_OPERAND);
-	}
-
-	//
-	// error if more that 1 operands found
-	if (tokens_start_idx + 1 != hcc_stack_count(token_bag->tokens)) {
-		hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_TOO_MANY_INCLUDE_OPERANDS);
-	}
-
-	HccATAToken token = *hcc_stack_get(token_bag->tokens, tokens_start_idx);
-	if (token != HCC_ATA_TOKEN_STRING && token != HCC_ATA_TOKEN_INCLUDE_PATH_SYSTEM) {
-		hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_INVALID_INCLUDE_OPERAND);
-	}
-
-	HccStringId path_string_id = hcc_stack_get(token_bag->values, token_values_start_idx)->string_id;
-	HccString path_string = hcc_string_table_get(path_string_id);
-	if (path_string.size <= 1) { // <= as it has a null terminator
-		hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_INCLUDE_PATH_IS_EMPTY);
-	}
-
+//
+// returns the path of the file that the #include resolves to, or an empty string if it does not exist.
+//
+// @param(dir_bits_out): is set to the hcc_include_resolve_dir_bit of every directory that was searched,
+//     or zero if one of them could not be tracked and the result must not be cached.
+HccString hcc_ppgen_find_include_path(HccWorker* w, HccATAToken token, HccString path_string, uint64_t* dir_bits_out) {
 	bool search_the_include_paths = false;
+	uint64_t dir_bits = 0;
+	bool is_tracking_dirs = true;
 	switch (token) {
 		case HCC_ATA_TOKEN_STRING:
 			//
 			// if the path is relative then glue the directory of the current file to the start of the include path.
 			// this is to prevent finding a file relative from in the current working directory
 			if (hcc_path_is_relative(path_string.data)) {
-				HccCodeFile* code_file = w->atagen.location.code_file;
-				HccString check_path = hcc_path_replace_file_name(code_file->path_string, path_string);
+				//
+				// build {including_file_dir}/{path} in the string buffer
+				HccString including_path = w->atagen.location.code_file->path_string;
+				uint32_t dir_size = including_path.size;
+				while (dir_size) {
+					dir_size -= 1;
+					if (including_path.data[dir_size] == '/' || including_path.data[dir_size] == '\\') {
+						break;
+					}
+				}
+
+				hcc_stack_clear(w->string_buffer);
+				hcc_stack_push_string(w->string_buffer, hcc_string(including_path.data, dir_size));
+				*hcc_stack_push(w->string_buffer) = '/';
+				hcc_stack_push_string(w->string_buffer, path_string);
+				*hcc_stack_push(w->string_buffer) = '\0';
+				HccString check_path = hcc_string(w->string_buffer, hcc_stack_count(w->string_buffer) - 1);
+				uint64_t dir_bit = hcc_include_resolve_dir_bit(check_path.data, check_path.size);
+				dir_bits |= dir_bit;
+				is_tracking_dirs &= dir_bit != 0;
 				if (!hcc_path_is_file(check_path.data)) {
 					search_the_include_paths = true;
 					break;
@@ -628,6 +760,9 @@ void hcc_ppgen_parse_include(HccWorker* w) {
 			hcc_stack_push_string(w->string_buffer, path_string);
 			*hcc_stack_push(w->string_buffer) = '\0';
 
+			uint64_t dir_bit = hcc_include_resolve_dir_bit(w->string_buffer, hcc_stack_count(w->string_buffer) - 1);
+			dir_bits |= dir_bit;
+			is_tracking_dirs &= dir_bit != 0;
 			if (hcc_path_is_file(w->string_buffer)) {
 				path_string = hcc_string(w->string_buffer, hcc_stack_count(w->string_buffer));
 				break;
@@ -635,15 +770,99 @@ void hcc_ppgen_parse_include(HccWorker* w) {
 		}
 
 		if (idx == count) {
-			w->atagen.location = *HCC_PP_TOKEN_STRIP_PREEXPANDED_MACRO_ARG(*hcc_stack_get(token_bag->locations, tokens_start_idx));
-			hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_INCLUDE_PATH_DOES_NOT_EXIST);
+			path_string = hcc_string(NULL, 0);
 		}
+	} else if (dir_bits == 0) {
+		//
+		// an absolute path is only looked for in its own directory
+		uint64_t dir_bit = hcc_include_resolve_dir_bit(path_string.data, path_string.size);
+		dir_bits |= dir_bit;
+		is_tracking_dirs &= dir_bit != 0;
 	}
 
-	path_string = hcc_path_canonicalize(path_string.data);
-	if (path_string.size == 0) {
-		hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_FAILED_TO_OPEN_FILE_FOR_READ, path_string.data);
+	*dir_bits_out = is_tracking_dirs ? dir_bits : 0;
+	return path_string;
+}
+
+void hcc_ppgen_parse_include(HccWorker* w) {
+	hcc_atagen_consume_whitespace(w);
+	w->atagen.location.code_start_idx = w->atagen.location.code_end_idx;
+	w->atagen.location.column_start = w->atagen.location.column_end;
+
+	//
+	// run the tokenizer to get the single operand and expand any macros
+	HccATATokenBag* token_bag = &w->atagen.ast_file->token_bag;
+	uint32_t tokens_start_idx = hcc_stack_count(token_bag->tokens);
+	uint32_t token_values_start_idx = hcc_stack_count(token_bag->values);
+	uint32_t token_location_indices_start_idx = hcc_stack_count(token_bag->locations);
+	hcc_atagen_run(w, token_bag, HCC_ATAGEN_RUN_MODE_PP_INCLUDE_OPERAND);
+
+	//
+	// error if no operands found
+	if (tokens_start_idx == hcc_stack_count(token_bag->tokens)) {
+		hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_INVALID_INCLUDE_OPERAND);
+	}
+
+	//
+	// error if more that 1 operands found
+	if (tokens_start_idx + 1 != hcc_stack_count(token_bag->tokens)) {
+		hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_TOO_MANY_INCLUDE_OPERANDS);
+	}
+
+	HccATAToken token = *hcc_stack_get(token_bag->tokens, tokens_start_idx);
+	if (token != HCC_ATA_TOKEN_STRING && token != HCC_ATA_TOKEN_INCLUDE_PATH_SYSTEM) {
+		hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_INVALID_INCLUDE_OPERAND);
+	}
+
+	HccStringId path_string_id = hcc_stack_get(token_bag->values, token_values_start_idx)->string_id;
+	HccString path_string = hcc_string_table_get(path_string_id);
+	if (path_string.size <= 1) { // <= as it has a null terminator
+		hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_INCLUDE_PATH_IS_EMPTY);
+	}
+
+	//
+	// look the #include up in the cache first to save searching through the file system for it again.
+	// a relative #include "" depends on the directory of the file that includes it.
+	HccIncludeResolveKey resolve_key = {0};
+	resolve_key.path_string_id = path_string_id;
+	resolve_key.include_paths_hash = hcc_worker_task(w)->include_paths_hash;
+	resolve_key.is_system = token == HCC_ATA_TOKEN_INCLUDE_PATH_SYSTEM;
+	if (!resolve_key.is_system && hcc_path_is_relative(path_string.data)) {
+		HccString including_path = w->atagen.location.code_file->path_string;
+		uint32_t dir_size = including_path.size;
+		while (dir_size) {
+			dir_size -= 1;
+			if (including_path.data[dir_size] == '/' || including_path.data[dir_size] == '\\') {
+				break;
+			}
+		}
+		hcc_string_table_deduplicate(including_path.data, dir_size, &resolve_key.dir_path_string_id);
+	}
+
+	HccString canonical_path;
+	if (!hcc_include_resolve_cache_find(&resolve_key, &canonical_path)) {
+		uint64_t dir_bits;
+		HccString found_path = hcc_ppgen_find_include_path(w, token, path_string, &dir_bits);
+		canonical_path = hcc_string(NULL, 0);
+		if (found_path.size) {
+			canonical_path = hcc_path_canonicalize_deduplicate(found_path.data);
+			if (canonical_path.size == 0) {
+				hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_FAILED_TO_OPEN_FILE_FOR_READ, found_path.data);
+			}
+		}
+
+		//
+		// the files that do not exist are cached as an empty path
+		if (dir_bits) {
+			hcc_include_resolve_cache_insert(&resolve_key, canonical_path, dir_bits);
+		}
+	}
+
+	if (canonical_path.size == 0) {
+		w->atagen.location = *HCC_PP_TOKEN_STRIP_PREEXPANDED_MACRO_ARG(*hcc_stack_get(token_bag->locations, tokens_start_idx));
+		hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_INCLUDE_PATH_DOES_NOT_EXIST);
 	}
+	path_string = canonical_path;
 
 	HccCodeFile* code_file;
 	HccResult result = hcc_code_file_find_or_insert(path_string, &code_file);
@@ -652,20 +871,58 @@ void hcc_ppgen_parse_include(HccWorker* w) {
 	}
 	bool we_are_mutator_of_code_file = result.code == HCC_SUCCESS_IS_NEW;
 
-	hcc_string_table_deduplicate(path_string.data, path_string.size, &path_string_id);
-	hcc_ast_file_found_included_file(w->atagen.ast_file, path_string_id);
-	if (!hcc_ast_file_has_been_pragma_onced(w->atagen.ast_file, path_string_id)) {
-		hcc_atagen_paused_file_push(w);
-		hcc_atagen_location_setup_new_file(w, code_file);
-		w->atagen.we_are_mutator_of_code_file = we_are_mutator_of_code_file;
-	}
-
 	//
 	// remove the added token for when we evaluated the include operand
 	// using the call to hcc_atagen_run.
 	hcc_stack_resize(token_bag->tokens, tokens_start_idx);
 	hcc_stack_resize(token_bag->values, token_values_start_idx);
 	hcc_stack_resize(token_bag->locations, token_location_indices_start_idx);
+
+	hcc_string_table_deduplicate(path_string.data, path_string.size, &path_string_id);
+	hcc_ast_file_found_included_file(w->atagen.ast_file, path_string_id);
+	if (hcc_ast_file_has_been_pragma_onced(w->atagen.ast_file, path_string_id)) {
+		return;
+	}
+
+	//
+	// skip the file without opening it if it has an include guard that is already defined
+	if (
+		!we_are_mutator_of_code_file &&
+		(atomic_load(&code_file->flags) & HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS) &&
+		code_file->include_guard_string_id.idx_plus_one &&
+		hcc_hash_table_find_idx(w->atagen.ppgen.macro_declarations, &code_file->include_guard_string_id) != UINTPTR_MAX
+	) {
+		return;
+	}
+
+	//
+	// if another file has already tokenized this file with the same macros defined,
+	// then copy it's tokens instead of tokenizing this file again.
+	// if we are the mutator of the code file then we have to tokenize it to complete the mutator pass.
+	HccATAIncludeCacheKey key = {
+		.path_string_id = path_string_id,
+		.macro_state_hash = w->atagen.macro_state_hash,
+		.pragma_onced_hash = w->atagen.ast_file->pragma_onced_hash,
+	};
+	bool can_use_include_cache = hcc_atagen_include_cache_can_be_used(w);
+	if (can_use_include_cache && !we_are_mutator_of_code_file && hcc_atagen_include_cache_replay(w, &key)) {
+		return;
+	}
+
+	//
+	// otherwise try a precompiled header from an earlier compile.
+	// it holds the mutator pass of the files it tokenized so it can be used even when we are the mutator.
+	if (can_use_include_cache && hcc_worker_task(w)->pch_dir_path.size && hcc_atagen_pch_load(w, &key, code_file, we_are_mutator_of_code_file)) {
+		return;
+	}
+
+	hcc_atagen_paused_file_push(w);
+	hcc_atagen_location_setup_new_file(w, code_file);
+	w->atagen.we_are_mutator_of_code_file = we_are_mutator_of_code_file;
+	if (can_use_include_cache) {
+		hcc_atagen_include_recording_begin(w, &key);
+	}
+	hcc_atagen_include_effect_push(w, HCC_ATA_INCLUDE_EFFECT_TYPE_TOKENIZED_FILE, path_string_id.idx_plus_one);
 }
 
 bool hcc_ppgen_parse_if(HccWorker* w) {
@@ -813,6 +1070,7 @@ void hcc_ppgen_parse_line(HccWorker* w) {
 	// store the custom line and custom path in the code file we are currently parsing
 	w->atagen.custom_line_dst = custom_line;
 	w->atagen.custom_line_src = w->atagen.location.line_start;
+	hcc_atagen_include_recordings_invalidate(w);
 	if (custom_path.data) {
 		w->atagen.location.display_path = custom_path;
 	}
@@ -852,6 +1110,10 @@ void hcc_ppgen_parse_warning(HccWorker* w) {
 	location->display_line = hcc_atagen_display_line(w);
 
 	hcc_warn_push(hcc_worker_task(w), HCC_WARN_CODE_PP_WARNING, location, NULL, (int)message.size, message.data);
+
+	//
+	// the include cache does not replay warnings
+	hcc_atagen_include_recordings_invalidate(w);
 }
 
 void hcc_ppgen_parse_pragma(HccWorker* w) {
@@ -1029,11 +1291,10 @@ void hcc_ppgen_parse_directive(HccWorker* w) {
 void hcc_ppgen_skip_false_conditional(HccWorker* w, bool is_skipping_until_endif) {
 	bool first_non_white_space_char = false;
 	uint32_t nested_level = hcc_stack_count(w->atagen.ppgen.if_stack);
-	HccCodeFile* code_file = w->atagen.location.code_file;
 	bool is_inside_nested_comment = false;
 	bool is_inside_single_line_comment = false;
 	while (w->atagen.location.code_end_idx < w->atagen.code_size) {
-		if (!(atomic_load(&code_file->flags) & HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS)) {
+		if (!w->atagen.is_code_file_mutator_pass_completed) {
 			//
 			// TODO test a SIMD optimized version of this
 			//
@@ -1266,6 +1527,7 @@ void hcc_ppgen_copy_expand_predefined_macro(HccWorker* w, HccPPPredefinedMacro p
 			hcc_atagen_token_value_add(w, token_value);
 
 			w->atagen.__counter__ += 1;
+			hcc_atagen_include_recordings_invalidate(w);
 			break;
 		};
 		case HCC_PP_PREDEFINED_MACRO___HCC__:
@@ -1825,18 +2087,65 @@ void hcc_atagen_init(HccWorker* w, HccATAGenSetup* setup) {
 	hcc_ppgen_init(w, &setup->ppgen);
 	w->atagen.paused_file_stack = hcc_stack_init(HccATAPausedFile, HCC_ALLOC_TAG_ATAGEN_PAUSED_FILE_STACK, setup->paused_file_stack_grow_count, setup->paused_file_stack_reserve_cap);
 	w->atagen.open_bracket_stack = hcc_stack_init(HccATAOpenBracket, HCC_ALLOC_TAG_ATAGEN_OPEN_BRACKET_STACK, setup->open_bracket_stack_grow_count, setup->open_bracket_stack_reserve_cap);
+	w->atagen.include_recording_stack = hcc_stack_init(HccATAIncludeRecording, HCC_ALLOC_TAG_ATAGEN_INCLUDE_RECORDING_STACK, setup->include_recording_stack_grow_count, setup->include_recording_stack_reserve_cap);
+
+	HccATAGenPCH* pch = &w->atagen.pch;
+	pch->idx_map = hcc_hash_table_init(HccATAPCHIdxEntry, HCC_ALLOC_TAG_ATA_BINARY, hcc_u64_key_cmp, hcc_u64_key_hash, setup->pch_idx_map_cap);
+	pch->strings = hcc_stack_init(HccATAPCHString, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->string_bytes = hcc_stack_init(char, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->files = hcc_stack_init(HccATAPCHFile, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->code_files = hcc_stack_init(HccCodeFile*, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->line_code_start_indices = hcc_stack_init(uint32_t, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->if_spans = hcc_stack_init(HccATAPCHIfSpan, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->locations = hcc_stack_init(HccATAPCHLocation, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->src_locations = hcc_stack_init(HccLocation*, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->constants = hcc_stack_init(HccATAPCHConstant, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->macros = hcc_stack_init(HccATAPCHMacro, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->macro_params = hcc_stack_init(uint32_t, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->tokens = hcc_stack_init(HccATAToken, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->token_locations = hcc_stack_init(uint32_t, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->token_values = hcc_stack_init(uint32_t, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->effects = hcc_stack_init(HccATAIncludeEffect, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->string_ids = hcc_stack_init(HccStringId, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->constant_ids = hcc_stack_init(HccConstantId, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->macro_indices = hcc_stack_init(uint32_t, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
+	pch->we_are_mutator_of_code_files = hcc_stack_init(bool, HCC_ALLOC_TAG_ATA_BINARY, setup->pch_elmts_grow_count, setup->pch_elmts_reserve_cap);
 }
 
 void hcc_atagen_deinit(HccWorker* w) {
 	hcc_ppgen_deinit(w);
 	hcc_stack_deinit(w->atagen.paused_file_stack);
 	hcc_stack_deinit(w->atagen.open_bracket_stack);
+	hcc_stack_deinit(w->atagen.include_recording_stack);
+
+	HccATAGenPCH* pch = &w->atagen.pch;
+	hcc_hash_table_deinit(pch->idx_map);
+	hcc_stack_deinit(pch->strings);
+	hcc_stack_deinit(pch->string_bytes);
+	hcc_stack_deinit(pch->files);
+	hcc_stack_deinit(pch->code_files);
+	hcc_stack_deinit(pch->line_code_start_indices);
+	hcc_stack_deinit(pch->if_spans);
+	hcc_stack_deinit(pch->locations);
+	hcc_stack_deinit(pch->src_locations);
+	hcc_stack_deinit(pch->constants);
+	hcc_stack_deinit(pch->macros);
+	hcc_stack_deinit(pch->macro_params);
+	hcc_stack_deinit(pch->tokens);
+	hcc_stack_deinit(pch->token_locations);
+	hcc_stack_deinit(pch->token_values);
+	hcc_stack_deinit(pch->effects);
+	hcc_stack_deinit(pch->string_ids);
+	hcc_stack_deinit(pch->constant_ids);
+	hcc_stack_deinit(pch->macro_indices);
+	hcc_stack_deinit(pch->we_are_mutator_of_code_files);
 }
 
 void hcc_atagen_reset(HccWorker* w) {
 	hcc_ppgen_reset(w);
 	hcc_stack_clear(w->atagen.paused_file_stack);
 	hcc_stack_clear(w->atagen.open_bracket_stack);
+	hcc_stack_clear(w->atagen.include_recording_stack);
 }
 
 void hcc_atagen_generate(HccWorker* w) {
@@ -1882,6 +2191,24 @@ void hcc_atagen_advance_newline(HccWorker* w) {
 	}
 }
 
+//
+// advance over size bytes of code that may have newlines in them.
+// the line starts are recorded a chunk of bytes at a time instead of going through each newline.
+void hcc_atagen_advance_over_code(HccWorker* w, uint32_t size) {
+	uint32_t code_idx = w->atagen.location.code_end_idx;
+	HccStack(uint32_t) line_starts = w->atagen.we_are_mutator_of_code_file ? w->atagen.location.code_file->line_code_start_indices : NULL;
+	uint32_t last_line_start_idx;
+	uint32_t newlines_count = hcc_bytes_push_line_starts(&w->atagen.code[code_idx], size, code_idx, line_starts, &last_line_start_idx);
+	if (newlines_count) {
+		w->atagen.location.line_end += newlines_count;
+		w->atagen.location.column_start = 1;
+		w->atagen.location.column_end = 1;
+		w->atagen.location.code_end_idx = last_line_start_idx;
+		size = code_idx + size - last_line_start_idx;
+	}
+	hcc_atagen_advance_column(w, size);
+}
+
 uint32_t hcc_atagen_display_line(HccWorker* w) {
 	uint32_t line_num = w->atagen.location.line_start;
 	return w->atagen.custom_line_dst ? w->atagen.custom_line_dst + (line_num - w->atagen.custom_line_src) : line_num;
@@ -1962,6 +2289,7 @@ _Noreturn void hcc_atagen_bail_error_2(HccWorker* w, HccErrorCode error_code, Hc
 void hcc_atagen_paused_file_push(HccWorker* w) {
 	HccATAPausedFile* paused_file = hcc_stack_push(w->atagen.paused_file_stack);
 	paused_file->we_are_mutator_of_code_file = w->atagen.we_are_mutator_of_code_file;
+	paused_file->is_code_file_mutator_pass_completed = w->atagen.is_code_file_mutator_pass_completed;
 	paused_file->location = w->atagen.location;
 	paused_file->if_stack_count = hcc_stack_count(w->atagen.ppgen.if_stack);
 	paused_file->pp_if_span_id = w->atagen.pp_if_span_id;
@@ -1969,6 +2297,7 @@ void hcc_atagen_paused_file_push(HccWorker* w) {
 
 void hcc_atagen_paused_file_pop(HccWorker* w) {
 	if (w->atagen.we_are_mutator_of_code_file) {
+		hcc_ppgen_find_include_guard(w->atagen.location.code_file);
 		atomic_fetch_or(&w->atagen.location.code_file->flags, HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS);
 	}
 
@@ -1979,7 +2308,22 @@ void hcc_atagen_paused_file_pop(HccWorker* w) {
 		hcc_atagen_bail_error_1(w, HCC_ERROR_CODE_PP_IF_UNTERMINATED, hcc_pp_directive_strings[pp_if->directive]);
 	}
 
+	//
+	// tokens that continue on from an included file into the parent file (eg. macro arguments)
+	// cannot be stored in the include cache.
+	if (w->atagen.run_mode != HCC_ATAGEN_RUN_MODE_CODE && w->atagen.run_mode != HCC_ATAGEN_RUN_MODE_PP_CONCAT) {
+		hcc_atagen_include_recordings_invalidate(w);
+	}
+
+	if (
+		hcc_stack_count(w->atagen.include_recording_stack) &&
+		hcc_stack_get_last(w->atagen.include_recording_stack)->paused_files_count == hcc_stack_count(w->atagen.paused_file_stack)
+	) {
+		hcc_atagen_include_recording_end(w);
+	}
+
 	w->atagen.we_are_mutator_of_code_file = paused_file->we_are_mutator_of_code_file;
+	w->atagen.is_code_file_mutator_pass_completed = paused_file->is_code_file_mutator_pass_completed;
 	w->atagen.location = paused_file->location;
 	w->atagen.code = paused_file->location.code_file->code.data;
 	w->atagen.code_size = paused_file->location.code_file->code.size;
@@ -2002,72 +2346,1208 @@ void hcc_atagen_location_setup_new_file(HccWorker* w, HccCodeFile* code_file) {
 	w->atagen.code = code_file->code.data;
 	w->atagen.code_size = code_file->code.size;
 	w->atagen.pp_if_span_id = 0;
+
+	//
+	// the mutator of the code file can finish while we are still parsing it.
+	// if we switched to using its #if spans half way through, the #if we are in the middle of would not have a start span.
+	w->atagen.is_code_file_mutator_pass_completed = atomic_load(&code_file->flags) & HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS;
 }
 
 bool hcc_atagen_is_last_token_string(HccATATokenBag* bag) {
 	return hcc_stack_count(bag->tokens) > 0 && *hcc_stack_get_last(bag->tokens) == HCC_ATA_TOKEN_STRING;
 }
 
-void hcc_atagen_token_merge_append_string(HccWorker* w, HccATATokenBag* bag, HccString append_string) {
-	HCC_DEBUG_ASSERT(hcc_stack_count(bag->tokens) > 0 && *hcc_stack_get_last(bag->tokens) == HCC_ATA_TOKEN_STRING, "expected string token");
+bool hcc_ata_include_cache_key_cmp(void* a, void* b, uintptr_t size) {
+	HCC_UNUSED(size);
+	HccATAIncludeCacheKey* a_ = a;
+	HccATAIncludeCacheKey* b_ = b;
+	return a_->path_string_id.idx_plus_one == b_->path_string_id.idx_plus_one && a_->macro_state_hash == b_->macro_state_hash && a_->pragma_onced_hash == b_->pragma_onced_hash;
+}
 
-	HccString prepend_string = hcc_string_table_get(hcc_stack_get_last(bag->values)->string_id);
+HccHash hcc_ata_include_cache_key_hash(void* key, uintptr_t size) {
+	HCC_DEBUG_ASSERT(size == sizeof(HccATAIncludeCacheKey), "key is not a HccATAIncludeCacheKey");
 
-	uint32_t stringify_buffer_start_idx = hcc_stack_count(w->string_buffer);
-	hcc_stack_push_string(w->string_buffer, prepend_string);
-	hcc_stack_pop(w->string_buffer); // remove \0
-	hcc_stack_push_string(w->string_buffer, append_string);
-	HccStringId string_id;
-	hcc_string_table_deduplicate(&w->string_buffer[stringify_buffer_start_idx], hcc_stack_count(w->string_buffer) - stringify_buffer_start_idx, &string_id);
-	hcc_stack_resize(w->string_buffer, stringify_buffer_start_idx);
+	HccATAIncludeCacheKey* k = key;
+	HccHash hash = HCC_HASH_FNV_INIT;
+	hash = hcc_hash_fnv(&k->path_string_id, sizeof(k->path_string_id), hash);
+	hash = hcc_hash_fnv(&k->macro_state_hash, sizeof(k->macro_state_hash), hash);
+	hash = hcc_hash_fnv(&k->pragma_onced_hash, sizeof(k->pragma_onced_hash), hash);
+	return hash;
+}
 
-	hcc_stack_get_last(bag->values)->string_id = string_id;
+void hcc_atagen_include_effect_push(HccWorker* w, HccATAIncludeEffectType type, uint32_t macro_idx_or_string_id) {
+	HccATAIncludeEffect* effect = hcc_stack_push(w->atagen.ast_file->include_effects);
+	effect->type = type;
+	effect->macro_idx = macro_idx_or_string_id;
 }
 
-bool hcc_atagen_consume_backslash(HccWorker* w) {
-	hcc_atagen_advance_column(w, 1);
-	char byte = w->atagen.code[w->atagen.location.code_end_idx];
-	bool found_newline = false;
-	if (byte == '\r') {
-		hcc_atagen_advance_column(w, 1);
-		byte = w->atagen.code[w->atagen.location.code_end_idx];
-		found_newline = true;
-	}
-	if (byte == '\n'){
-		hcc_atagen_advance_column(w, 1);
-		byte = w->atagen.code[w->atagen.location.code_end_idx];
-		found_newline = true;
-	}
-	if (found_newline) {
-		w->atagen.location.line_end += 1;
-		w->atagen.location.column_start = 1;
-		w->atagen.location.column_end = 1;
-		if (w->atagen.we_are_mutator_of_code_file) {
-			uint32_t* dst = hcc_stack_push(w->atagen.location.code_file->line_code_start_indices);
-			*dst = w->atagen.location.code_end_idx;
-		}
-	}
-	return found_newline;
+bool hcc_atagen_include_cache_can_be_used(HccWorker* w) {
+	//
+	// the tokens of an included file only get stored and reused when they do not depend on or
+	// change anything that lives outside of the included file and is not part of the cache key.
+	// open brackets and a string literal at the end of the token bag can both be changed by the included file.
+	return
+		w->atagen.run_mode == HCC_ATAGEN_RUN_MODE_CODE &&
+		w->atagen.dst_token_bag == &w->atagen.ast_file->token_bag &&
+		hcc_stack_count(w->atagen.open_bracket_stack) == 0 &&
+		hcc_stack_count(w->atagen.ppgen.expand_stack) == 0 &&
+		!hcc_atagen_is_last_token_string(&w->atagen.ast_file->token_bag) &&
+		w->atagen.custom_line_dst == 0;
 }
 
-void hcc_atagen_consume_whitespace(HccWorker* w) {
-	while (w->atagen.location.code_end_idx < w->atagen.code_size) {
-		char byte = w->atagen.code[w->atagen.location.code_end_idx];
-		if (byte != ' ' && byte != '\t') {
-			char next_byte = w->atagen.code[w->atagen.location.code_end_idx + 1];
-			if (byte != '\\' || !hcc_atagen_consume_backslash(w)) {
-				break;
-			}
-		} else {
-			hcc_atagen_advance_column(w, 1);
-		}
+bool hcc_atagen_include_cache_replay(HccWorker* w, HccATAIncludeCacheKey* key) {
+	HccCU* cu = w->cu;
+	uintptr_t found_idx = hcc_hash_table_find_idx(cu->ast.include_cache, key);
+	if (found_idx == UINTPTR_MAX) {
+		return false;
 	}
-}
 
-void hcc_atagen_consume_whitespace_and_newlines(HccWorker* w) {
-	while (w->atagen.location.code_end_idx < w->atagen.code_size) {
-		char byte = w->atagen.code[w->atagen.location.code_end_idx];
-		if (byte != ' ' && byte != '\t' && byte != '\r' && byte != '\n' && byte != '\\') {
+	HccATAIncludeCacheEntry* entry = &cu->ast.include_cache[found_idx];
+	if (!atomic_load(&entry->is_ready)) {
+		//
+		// another worker is still storing this entry, just tokenize the file ourselves
+		return false;
+	}
+
+	HccASTFile* src_file = entry->ast_file;
+	HccASTFile* dst_file = w->atagen.ast_file;
+
+	//
+	// copy the tokens into our token bag
+	uint32_t tokens_count = entry->tokens_end_idx - entry->tokens_start_idx;
+	uint32_t token_values_count = entry->token_values_end_idx - entry->token_values_start_idx;
+	if (tokens_count) {
+		HCC_COPY_ELMT_MANY(hcc_stack_push_many(dst_file->token_bag.tokens, tokens_count), hcc_stack_get(src_file->token_bag.tokens, entry->tokens_start_idx), tokens_count);
+		HCC_COPY_ELMT_MANY(hcc_stack_push_many(dst_file->token_bag.locations, tokens_count), hcc_stack_get(src_file->token_bag.locations, entry->tokens_start_idx), tokens_count);
+	}
+	if (token_values_count) {
+		HCC_COPY_ELMT_MANY(hcc_stack_push_many(dst_file->token_bag.values, token_values_count), hcc_stack_get(src_file->token_bag.values, entry->token_values_start_idx), token_values_count);
+	}
+
+	//
+	// replay all of the changes the included file made to the preprocessor state
+	for (uint32_t effect_idx = entry->effects_start_idx; effect_idx < entry->effects_end_idx; effect_idx += 1) {
+		HccATAIncludeEffect* effect = hcc_stack_get(src_file->include_effects, effect_idx);
+		switch (effect->type) {
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_DEFINE: {
+				HccPPMacro* src_macro = hcc_stack_get(src_file->macros, effect->macro_idx);
+				uint32_t macro_tokens_count = hcc_ata_token_cursor_tokens_count(&src_macro->token_cursor);
+				uint32_t params_start_idx = hcc_stack_count(dst_file->macro_params);
+				uint32_t macro_tokens_start_idx = hcc_stack_count(dst_file->macro_token_bag.tokens);
+				uint32_t macro_token_values_start_idx = hcc_stack_count(dst_file->macro_token_bag.values);
+				if (src_macro->params_count) {
+					HCC_COPY_ELMT_MANY(hcc_stack_push_many(dst_file->macro_params, src_macro->params_count), src_macro->params, src_macro->params_count);
+				}
+				if (macro_tokens_count) {
+					HCC_COPY_ELMT_MANY(hcc_stack_push_many(dst_file->macro_token_bag.tokens, macro_tokens_count), hcc_stack_get(src_file->macro_token_bag.tokens, src_macro->token_cursor.tokens_start_idx), macro_tokens_count);
+					HCC_COPY_ELMT_MANY(hcc_stack_push_many(dst_file->macro_token_bag.locations, macro_tokens_count), hcc_stack_get(src_file->macro_token_bag.locations, src_macro->token_cursor.tokens_start_idx), macro_tokens_count);
+				}
+				if (src_macro->token_values_count) {
+					HCC_COPY_ELMT_MANY(hcc_stack_push_many(dst_file->macro_token_bag.values, src_macro->token_values_count), hcc_stack_get(src_file->macro_token_bag.values, src_macro->token_cursor.token_value_idx), src_macro->token_values_count);
+				}
+
+				uint32_t macro_idx = hcc_stack_count(dst_file->macros);
+				HccPPMacro* macro = hcc_stack_push(dst_file->macros);
+				*macro = *src_macro;
+				macro->params = hcc_stack_get_or_null(dst_file->macro_params, params_start_idx);
+				macro->token_cursor.tokens_start_idx = macro_tokens_start_idx;
+				macro->token_cursor.tokens_end_idx = macro_tokens_start_idx + macro_tokens_count;
+				macro->token_cursor.token_idx = macro_tokens_start_idx;
+				macro->token_cursor.token_value_idx = macro_token_values_start_idx;
+				hcc_atagen_include_replay_define(w, macro_idx);
+				break;
+			};
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_UNDEF:
+				hcc_atagen_include_replay_undef(w, effect->string_id);
+				break;
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_PRAGMA_ONCE:
+				hcc_ast_file_set_pragma_onced(dst_file, effect->string_id);
+				break;
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_FOUND_INCLUDED_FILE:
+				hcc_ast_file_found_included_file(dst_file, effect->string_id);
+				break;
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_TOKENIZED_FILE:
+				hcc_atagen_include_effect_push(w, HCC_ATA_INCLUDE_EFFECT_TYPE_TOKENIZED_FILE, effect->string_id.idx_plus_one);
+				break;
+		}
+	}
+
+	return true;
+}
+
+void hcc_atagen_include_replay_define(HccWorker* w, uint32_t macro_idx) {
+	HccPPMacro* macro = hcc_stack_get(w->atagen.ast_file->macros, macro_idx);
+	HccHashTableInsert insert = hcc_hash_table_find_insert_idx(w->atagen.ppgen.macro_declarations, &macro->identifier_string_id);
+	HCC_DEBUG_ASSERT(insert.is_new, "internal error: the include cache key should guarantee that '%.*s' is not defined", (int)macro->identifier_string.size, macro->identifier_string.data);
+	w->atagen.ppgen.macro_declarations[insert.idx].macro_idx = macro_idx;
+	w->atagen.macro_state_hash += macro->content_hash;
+	hcc_atagen_include_effect_push(w, HCC_ATA_INCLUDE_EFFECT_TYPE_DEFINE, macro_idx);
+}
+
+void hcc_atagen_include_replay_undef(HccWorker* w, HccStringId identifier_string_id) {
+	uintptr_t found_idx = hcc_hash_table_find_idx(w->atagen.ppgen.macro_declarations, &identifier_string_id);
+	HCC_DEBUG_ASSERT(found_idx != UINTPTR_MAX, "internal error: the include cache key should guarantee that the macro is defined");
+	uint32_t macro_idx = w->atagen.ppgen.macro_declarations[found_idx].macro_idx;
+	w->atagen.macro_state_hash -= macro_idx == UINT32_MAX
+		? hcc_ppgen_predefined_macro_content_hash(identifier_string_id)
+		: hcc_stack_get(w->atagen.ast_file->macros, macro_idx)->content_hash;
+
+	hcc_hash_table_remove(w->atagen.ppgen.macro_declarations, &identifier_string_id);
+	hcc_atagen_include_effect_push(w, HCC_ATA_INCLUDE_EFFECT_TYPE_UNDEF, identifier_string_id.idx_plus_one);
+}
+
+void hcc_atagen_include_recording_begin(HccWorker* w, HccATAIncludeCacheKey* key) {
+	HccATAIncludeRecording* recording = hcc_stack_push(w->atagen.include_recording_stack);
+	recording->key = *key;
+	recording->paused_files_count = hcc_stack_count(w->atagen.paused_file_stack);
+	recording->tokens_start_idx = hcc_stack_count(w->atagen.ast_file->token_bag.tokens);
+	recording->token_values_start_idx = hcc_stack_count(w->atagen.ast_file->token_bag.values);
+	recording->effects_start_idx = hcc_stack_count(w->atagen.ast_file->include_effects);
+	recording->is_invalid = false;
+}
+
+void hcc_atagen_include_recording_end(HccWorker* w) {
+	HccATAIncludeRecording* recording = hcc_stack_get_last(w->atagen.include_recording_stack);
+	HccASTFile* ast_file = w->atagen.ast_file;
+
+	//
+	// if the last token is a string, the parent file can still append to it when it continues.
+	if (!recording->is_invalid && hcc_stack_count(w->atagen.open_bracket_stack) == 0 && !hcc_atagen_is_last_token_string(&ast_file->token_bag)) {
+		hcc_atagen_include_cache_publish(w, &recording->key, recording->tokens_start_idx, recording->token_values_start_idx, recording->effects_start_idx);
+
+		//
+		// only the outermost included file that gets stored is written as a precompiled header,
+		// as the files it includes are already a part of it.
+		bool is_outermost = true;
+		for (uint32_t idx = 0; idx < hcc_stack_count(w->atagen.include_recording_stack) - 1; idx += 1) {
+			if (!hcc_stack_get(w->atagen.include_recording_stack, idx)->is_invalid) {
+				is_outermost = false;
+				break;
+			}
+		}
+
+		if (is_outermost && hcc_worker_task(w)->pch_dir_path.size) {
+			hcc_atagen_pch_store(w, recording);
+		}
+	}
+
+	hcc_stack_pop(w->atagen.include_recording_stack);
+}
+
+void hcc_atagen_include_cache_publish(HccWorker* w, HccATAIncludeCacheKey* key, uint32_t tokens_start_idx, uint32_t token_values_start_idx, uint32_t effects_start_idx) {
+	HccCU* cu = w->cu;
+	HccASTFile* ast_file = w->atagen.ast_file;
+	HccHashTableInsert insert = hcc_hash_table_find_insert_idx(cu->ast.include_cache, key);
+	if (insert.is_new) {
+		HccATAIncludeCacheEntry* entry = &cu->ast.include_cache[insert.idx];
+		entry->ast_file = ast_file;
+		entry->tokens_start_idx = tokens_start_idx;
+		entry->tokens_end_idx = hcc_stack_count(ast_file->token_bag.tokens);
+		entry->token_values_start_idx = token_values_start_idx;
+		entry->token_values_end_idx = hcc_stack_count(ast_file->token_bag.values);
+		entry->effects_start_idx = effects_start_idx;
+		entry->effects_end_idx = hcc_stack_count(ast_file->include_effects);
+		atomic_store(&entry->is_ready, true);
+	}
+}
+
+void hcc_atagen_include_recordings_invalidate(HccWorker* w) {
+	for (uint32_t idx = 0; idx < hcc_stack_count(w->atagen.include_recording_stack); idx += 1) {
+		hcc_stack_get(w->atagen.include_recording_stack, idx)->is_invalid = true;
+	}
+}
+
+HccHash64 hcc_atagen_pch_key_hash(HccWorker* w, HccATAIncludeCacheKey* key) {
+	//
+	// the token count and the first user string id are hashed so that a precompiled header
+	// written by a different build of the compiler is never used.
+	uint32_t format[] = { HCC_ATA_PCH_VERSION, HCC_ATA_TOKEN_COUNT, HCC_STRING_ID_USER_START };
+	HccHash64 hash = hcc_hash_fnv_64(format, sizeof(format), HCC_HASH_FNV_64_INIT);
+	hash = hcc_ppgen_string_hash(key->path_string_id, hash);
+	hash = hcc_hash_fnv_64(&key->macro_state_hash, sizeof(key->macro_state_hash), hash);
+	hash = hcc_hash_fnv_64(&key->pragma_onced_hash, sizeof(key->pragma_onced_hash), hash);
+
+	//
+	// the include paths decide which files get found by the #include directives in the included file
+	HccStack(HccString) include_path_strings = hcc_worker_task(w)->include_path_strings;
+	for (uint32_t idx = 0; idx < hcc_stack_count(include_path_strings); idx += 1) {
+		HccString* include_path_string = hcc_stack_get(include_path_strings, idx);
+		hash = hcc_hash_fnv_64(&include_path_string->size, sizeof(include_path_string->size), hash);
+		hash = hcc_hash_fnv_64(include_path_string->data, include_path_string->size, hash);
+	}
+
+	return hash;
+}
+
+bool hcc_atagen_pch_path(HccWorker* w, HccHash64 key_hash, char* path_out, uint32_t path_out_size) {
+	HccString dir_path = hcc_worker_task(w)->pch_dir_path;
+	bool has_separator = dir_path.data[dir_path.size - 1] == '/' || dir_path.data[dir_path.size - 1] == '\\';
+	int size = snprintf(path_out, path_out_size, "%.*s%s%016llx" HCC_ATA_PCH_FILE_EXTENSION, (int)dir_path.size, dir_path.data, has_separator ? "" : "/", (unsigned long long)key_hash);
+	return size >= 0 && (uint32_t)size < path_out_size;
+}
+
+bool hcc_atagen_pch_load(HccWorker* w, HccATAIncludeCacheKey* key, HccCodeFile* code_file, bool we_are_mutator_of_code_file) {
+	HccATAGenPCH* pch = &w->atagen.pch;
+	HccASTFile* ast_file = w->atagen.ast_file;
+
+	char path[PATH_MAX];
+	HccHash64 key_hash = hcc_atagen_pch_key_hash(w, key);
+	if (!hcc_atagen_pch_path(w, key_hash, path, sizeof(path)) || !hcc_path_is_file(path)) {
+		return false;
+	}
+
+	//
+	// precompiled headers are never modified in place, they are renamed over the top of the old file.
+	// so unlike code files they are safe to map straight from disk, falling back to reading them like code.
+	HccString data;
+	uint64_t data_size;
+	if (_hcc_gs.file_open_read_fn == hcc_file_open_read && hcc_virt_mem_map_file(HCC_ALLOC_TAG_CODE, path, _HCC_TOKENIZER_LOOK_HEAD_SIZE, (void**)&data.data, &data_size)) {
+		data.size = data_size;
+	} else if (!HCC_IS_SUCCESS(hcc_code_file_load_code(hcc_string_c(path), &data))) {
+		return false;
+	}
+
+	//
+	// precompiled headers are only written by the compiler and get renamed into place once they are complete,
+	// but a file that is truncated, corrupt or from another build of the compiler must not make us read out of bounds.
+	// so the header, the size of the arrays and every index inside of them is checked before anything is loaded.
+	HccATAPCHHeader* header = (HccATAPCHHeader*)data.data;
+	uint64_t offset = sizeof(HccATAPCHHeader);
+	if (
+		data.size < sizeof(HccATAPCHHeader) ||
+		header->magic_number != HCC_ATA_PCH_MAGIC_NUMBER ||
+		header->version != HCC_ATA_PCH_VERSION ||
+		header->key_hash != key_hash ||
+		header->macro_state_hash != key->macro_state_hash ||
+		header->pragma_onced_hash != key->pragma_onced_hash
+	) {
+		goto FAIL_RELEASE;
+	}
+
+	HccATAPCHString* strings = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->strings_count * sizeof(HccATAPCHString), HCC_ATA_PCH_ALIGN);
+	char* string_bytes = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->string_bytes_size, HCC_ATA_PCH_ALIGN);
+	HccATAPCHFile* files = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->files_count * sizeof(HccATAPCHFile), HCC_ATA_PCH_ALIGN);
+	uint32_t* line_code_start_indices = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->line_code_start_indices_count * sizeof(uint32_t), HCC_ATA_PCH_ALIGN);
+	HccATAPCHIfSpan* if_spans = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->if_spans_count * sizeof(HccATAPCHIfSpan), HCC_ATA_PCH_ALIGN);
+	HccATAPCHLocation* locations = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->locations_count * sizeof(HccATAPCHLocation), HCC_ATA_PCH_ALIGN);
+	HccATAPCHConstant* constants = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->constants_count * sizeof(HccATAPCHConstant), HCC_ATA_PCH_ALIGN);
+	HccATAPCHMacro* macros = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->macros_count * sizeof(HccATAPCHMacro), HCC_ATA_PCH_ALIGN);
+	uint32_t* macro_params = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->macro_params_count * sizeof(uint32_t), HCC_ATA_PCH_ALIGN);
+	HccATAToken* tokens = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->tokens_count * sizeof(HccATAToken), HCC_ATA_PCH_ALIGN);
+	uint32_t* token_locations = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->tokens_count * sizeof(uint32_t), HCC_ATA_PCH_ALIGN);
+	uint32_t* token_values = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->token_values_count * sizeof(uint32_t), HCC_ATA_PCH_ALIGN);
+	HccATAIncludeEffect* effects = HCC_PTR_ADD(data.data, offset);
+	offset += HCC_INT_ROUND_UP_ALIGN((uint64_t)header->effects_count * sizeof(HccATAIncludeEffect), HCC_ATA_PCH_ALIGN);
+	if (
+		offset != data.size ||
+		header->path_string_idx >= header->strings_count ||
+		header->file_tokens_count > header->tokens_count ||
+		header->file_token_values_count > header->token_values_count
+	) {
+		goto FAIL_RELEASE;
+	}
+
+	for (uint32_t string_idx = 0; string_idx < header->strings_count; string_idx += 1) {
+		HccATAPCHString* string = &strings[string_idx];
+		if (
+			(uint64_t)string->bytes_start_idx + string->size >= header->string_bytes_size ||
+			hcc_string_hash(&string_bytes[string->bytes_start_idx], string->size) != string->hash
+		) {
+			goto FAIL_RELEASE;
+		}
+	}
+
+	for (uint32_t file_idx = 0; file_idx < header->files_count; file_idx += 1) {
+		HccATAPCHFile* file = &files[file_idx];
+		if (
+			file->path_string_idx >= header->strings_count ||
+			(uint64_t)file->line_code_start_indices_start_idx + file->line_code_start_indices_count > header->line_code_start_indices_count ||
+			(uint64_t)file->if_spans_start_idx + file->if_spans_count > header->if_spans_count
+		) {
+			goto FAIL_RELEASE;
+		}
+
+		for (uint32_t span_idx = 0; span_idx < file->if_spans_count; span_idx += 1) {
+			HccATAPCHIfSpan* span = &if_spans[file->if_spans_start_idx + span_idx];
+			if (
+				span->directive >= HCC_PP_DIRECTIVE_COUNT ||
+				span->location_idx >= header->locations_count ||
+				span->parent_id > file->if_spans_count ||
+				span->first_id > file->if_spans_count ||
+				span->prev_id > file->if_spans_count ||
+				span->next_id > file->if_spans_count ||
+				span->last_id > file->if_spans_count
+			) {
+				goto FAIL_RELEASE;
+			}
+		}
+	}
+
+	//
+	// the parent of a location is always stored before it, as they are loaded in order
+	for (uint32_t location_idx = 0; location_idx < header->locations_count; location_idx += 1) {
+		HccATAPCHLocation* location = &locations[location_idx];
+		if (
+			location->file_idx >= header->files_count ||
+			location->parent_location_idx_plus_one > location_idx ||
+			location->macro_idx_plus_one > header->macros_count ||
+			location->macro_identifier_string_idx_plus_one > header->strings_count ||
+			location->display_path_string_idx_plus_one > header->strings_count
+		) {
+			goto FAIL_RELEASE;
+		}
+	}
+
+	//
+	// the constants are the values of literal tokens, so they are always stored as scalar AML intrinsics
+	for (uint32_t constant_idx = 0; constant_idx < header->constants_count; constant_idx += 1) {
+		HccDataType data_type = constants[constant_idx].data_type;
+		if (!HCC_DATA_TYPE_IS_AML_INTRINSIC(data_type) || HCC_DATA_TYPE_AUX(data_type) >= HCC_AML_INTRINSIC_DATA_TYPE_SCALAR_COUNT) {
+			goto FAIL_RELEASE;
+		}
+	}
+
+	for (uint32_t param_idx = 0; param_idx < header->macro_params_count; param_idx += 1) {
+		if (macro_params[param_idx] >= header->strings_count) {
+			goto FAIL_RELEASE;
+		}
+	}
+
+	for (uint32_t macro_idx = 0; macro_idx < header->macros_count; macro_idx += 1) {
+		HccATAPCHMacro* macro = &macros[macro_idx];
+		if (
+			macro->identifier_string_idx >= header->strings_count ||
+			macro->location_idx >= header->locations_count ||
+			(uint64_t)macro->params_start_idx + macro->params_count > header->macro_params_count ||
+			(uint64_t)macro->tokens_start_idx + macro->tokens_count > header->tokens_count ||
+			(uint64_t)macro->token_values_start_idx + macro->token_values_count > header->token_values_count ||
+			!hcc_atagen_pch_tokens_are_valid(header, &tokens[macro->tokens_start_idx], &token_locations[macro->tokens_start_idx], &token_values[macro->token_values_start_idx], macro->tokens_count, macro->token_values_count, macro->params_count)
+		) {
+			goto FAIL_RELEASE;
+		}
+	}
+
+	if (!hcc_atagen_pch_tokens_are_valid(header, tokens, token_locations, token_values, header->file_tokens_count, header->file_token_values_count, 0)) {
+		goto FAIL_RELEASE;
+	}
+
+	for (uint32_t effect_idx = 0; effect_idx < header->effects_count; effect_idx += 1) {
+		HccATAIncludeEffect* effect = &effects[effect_idx];
+		uint32_t pch_idx_end;
+		switch (effect->type) {
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_DEFINE: pch_idx_end = header->macros_count; break;
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_UNDEF:
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_PRAGMA_ONCE:
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_FOUND_INCLUDED_FILE: pch_idx_end = header->strings_count; break;
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_TOKENIZED_FILE: pch_idx_end = header->files_count; break;
+			default: pch_idx_end = 0; break;
+		}
+		if (effect->pch_idx >= pch_idx_end) {
+			goto FAIL_RELEASE;
+		}
+	}
+
+	HccATAPCHString* path_pch_string = &strings[header->path_string_idx];
+	HccString path_string = hcc_string_table_get(key->path_string_id);
+	if (path_pch_string->size != path_string.size || memcmp(&string_bytes[path_pch_string->bytes_start_idx], path_string.data, path_string.size) != 0) {
+		goto FAIL_RELEASE;
+	}
+
+	//
+	// check that none of the files have changed before anything is changed.
+	// the files that the included file tokenized are allowed to be new, as they can be loaded.
+	// the others are only in the locations (eg. of a macro that was defined before the included file) so they must already be loaded.
+	for (uint32_t file_idx = 0; file_idx < header->files_count; file_idx += 1) {
+		HccATAPCHFile* file = &files[file_idx];
+		HccATAPCHString* file_path_pch_string = &strings[file->path_string_idx];
+		HccCodeFile* file_code_file = hcc_code_file_find_hashed(hcc_string(&string_bytes[file_path_pch_string->bytes_start_idx], file_path_pch_string->size), file_path_pch_string->hash);
+		if (file_code_file) {
+			if (
+				!(atomic_load(&file_code_file->flags) & HCC_CODE_FILE_FLAGS_IS_LOADED) ||
+				file_code_file->code_hash != file->code_hash ||
+				file_code_file->code.size != file->code_size
+			) {
+				goto FAIL_RELEASE;
+			}
+		} else if (!file->is_tokenized) {
+			goto FAIL_RELEASE;
+		}
+	}
+
+	//
+	// now load the files that the included file tokenized and claim the ones that nobody has started parsing,
+	// their mutator pass gets completed from the precompiled header.
+	hcc_stack_clear(pch->code_files);
+	hcc_stack_clear(pch->we_are_mutator_of_code_files);
+	for (uint32_t file_idx = 0; file_idx < header->files_count; file_idx += 1) {
+		HccATAPCHFile* file = &files[file_idx];
+		HccString file_path = hcc_string(&string_bytes[strings[file->path_string_idx].bytes_start_idx], strings[file->path_string_idx].size);
+		HccCodeFile* file_code_file = hcc_code_file_find(file_path);
+		bool we_are_mutator = false;
+		if (file->is_tokenized) {
+			if (file_code_file) {
+				file_path = file_code_file->path_string;
+			} else {
+				//
+				// the path is the key of the code file so it needs to outlive the mapping of the precompiled header
+				file_path = hcc_path_deduplicate(file_path.data, file_path.size);
+				if (file_path.size == 0) {
+					goto FAIL_UNCLAIM;
+				}
+			}
+
+			HccResult result = hcc_code_file_find_or_insert(file_path, &file_code_file);
+			if (!HCC_IS_SUCCESS(result)) {
+				goto FAIL_UNCLAIM;
+			}
+			we_are_mutator = file_code_file == code_file ? we_are_mutator_of_code_file : result.code == HCC_SUCCESS_IS_NEW;
+		}
+
+		*hcc_stack_push(pch->code_files) = file_code_file;
+		*hcc_stack_push(pch->we_are_mutator_of_code_files) = we_are_mutator;
+		if (file_code_file->code_hash != file->code_hash || file_code_file->code.size != file->code_size) {
+			goto FAIL_UNCLAIM;
+		}
+	}
+
+	//
+	// nothing can fail from here on, so start mapping everything back into this process
+	HccCU* cu = w->cu;
+	hcc_stack_clear(pch->string_ids);
+	for (uint32_t string_idx = 0; string_idx < header->strings_count; string_idx += 1) {
+		HccATAPCHString* string = &strings[string_idx];
+		hcc_string_table_deduplicate_hashed(&string_bytes[string->bytes_start_idx], string->size, string->hash, hcc_stack_push(pch->string_ids));
+	}
+
+	hcc_stack_clear(pch->constant_ids);
+	for (uint32_t constant_idx = 0; constant_idx < header->constants_count; constant_idx += 1) {
+		HccBasic basic = constants[constant_idx].basic;
+		*hcc_stack_push(pch->constant_ids) = hcc_constant_table_deduplicate_basic(cu, constants[constant_idx].data_type, &basic);
+	}
+
+	hcc_stack_clear(pch->src_locations);
+	for (uint32_t location_idx = 0; location_idx < header->locations_count; location_idx += 1) {
+		HccATAPCHLocation* pch_location = &locations[location_idx];
+		HccLocation* location = hcc_worker_alloc_location(w);
+		hcc_atagen_pch_load_location(w, pch_location, location);
+		location->parent_location = pch_location->parent_location_idx_plus_one ? *hcc_stack_get(pch->src_locations, pch_location->parent_location_idx_plus_one - 1) : NULL;
+		*hcc_stack_push(pch->src_locations) = location;
+	}
+
+	for (uint32_t file_idx = 0; file_idx < header->files_count; file_idx += 1) {
+		if (!*hcc_stack_get(pch->we_are_mutator_of_code_files, file_idx)) {
+			continue;
+		}
+
+		HccATAPCHFile* file = &files[file_idx];
+		HccCodeFile* file_code_file = *hcc_stack_get(pch->code_files, file_idx);
+		hcc_stack_clear(file_code_file->line_code_start_indices);
+		HCC_COPY_ELMT_MANY(hcc_stack_push_many(file_code_file->line_code_start_indices, file->line_code_start_indices_count), &line_code_start_indices[file->line_code_start_indices_start_idx], file->line_code_start_indices_count);
+
+		hcc_stack_clear(file_code_file->pp_if_spans);
+		for (uint32_t span_idx = 0; span_idx < file->if_spans_count; span_idx += 1) {
+			HccATAPCHIfSpan* pch_span = &if_spans[file->if_spans_start_idx + span_idx];
+			HccPPIfSpan* span = hcc_stack_push(file_code_file->pp_if_spans);
+			span->directive = pch_span->directive;
+			hcc_atagen_pch_load_location(w, &locations[pch_span->location_idx], &span->location);
+			span->parent_id = pch_span->parent_id;
+			span->first_id = pch_span->first_id;
+			span->has_else = pch_span->has_else;
+			span->prev_id = pch_span->prev_id;
+			span->next_id = pch_span->next_id;
+			span->last_id = pch_span->last_id;
+		}
+
+		hcc_ppgen_find_include_guard(file_code_file);
+		atomic_fetch_or(&file_code_file->flags, HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS);
+	}
+
+	hcc_stack_clear(pch->macro_indices);
+	for (uint32_t macro_idx = 0; macro_idx < header->macros_count; macro_idx += 1) {
+		HccATAPCHMacro* pch_macro = &macros[macro_idx];
+		uint32_t params_start_idx = hcc_stack_count(ast_file->macro_params);
+		HccStringId* params = hcc_stack_push_many(ast_file->macro_params, pch_macro->params_count);
+		for (uint32_t param_idx = 0; param_idx < pch_macro->params_count; param_idx += 1) {
+			params[param_idx] = *hcc_stack_get(pch->string_ids, macro_params[pch_macro->params_start_idx + param_idx]);
+		}
+
+		uint32_t macro_tokens_start_idx = hcc_stack_count(ast_file->macro_token_bag.tokens);
+		uint32_t macro_token_values_start_idx = hcc_stack_count(ast_file->macro_token_bag.values);
+		hcc_atagen_pch_load_tokens(w, &ast_file->macro_token_bag, &tokens[pch_macro->tokens_start_idx], &token_locations[pch_macro->tokens_start_idx], &token_values[pch_macro->token_values_start_idx], pch_macro->tokens_count);
+
+		*hcc_stack_push(pch->macro_indices) = hcc_stack_count(ast_file->macros);
+		HccPPMacro* macro = hcc_stack_push(ast_file->macros);
+		macro->identifier_string_id = *hcc_stack_get(pch->string_ids, pch_macro->identifier_string_idx);
+		macro->identifier_string = hcc_string_table_get(macro->identifier_string_id);
+		macro->location = *hcc_stack_get(pch->src_locations, pch_macro->location_idx);
+		macro->params = hcc_stack_get_or_null(ast_file->macro_params, params_start_idx);
+		macro->token_cursor.tokens_start_idx = macro_tokens_start_idx;
+		macro->token_cursor.tokens_end_idx = macro_tokens_start_idx + pch_macro->tokens_count;
+		macro->token_cursor.token_idx = macro_tokens_start_idx;
+		macro->token_cursor.token_value_idx = macro_token_values_start_idx;
+		macro->content_hash = pch_macro->content_hash;
+		macro->token_values_count = pch_macro->token_values_count;
+		macro->params_count = pch_macro->params_count;
+		macro->is_function = pch_macro->is_function;
+		macro->has_va_args = pch_macro->has_va_args;
+	}
+
+	//
+	// link the locations to the macros they were expanded from.
+	// the macros defined before the included file are looked up by name, before the effects are replayed.
+	for (uint32_t location_idx = 0; location_idx < header->locations_count; location_idx += 1) {
+		HccATAPCHLocation* pch_location = &locations[location_idx];
+		HccLocation* location = *hcc_stack_get(pch->src_locations, location_idx);
+		if (pch_location->macro_idx_plus_one) {
+			location->macro = hcc_stack_get(ast_file->macros, *hcc_stack_get(pch->macro_indices, pch_location->macro_idx_plus_one - 1));
+		} else if (pch_location->macro_identifier_string_idx_plus_one) {
+			HccStringId identifier_string_id = *hcc_stack_get(pch->string_ids, pch_location->macro_identifier_string_idx_plus_one - 1);
+			uintptr_t found_idx = hcc_hash_table_find_idx(w->atagen.ppgen.macro_declarations, &identifier_string_id);
+			uint32_t macro_idx = found_idx == UINTPTR_MAX ? UINT32_MAX : w->atagen.ppgen.macro_declarations[found_idx].macro_idx;
+			location->macro = macro_idx == UINT32_MAX ? NULL : hcc_stack_get(ast_file->macros, macro_idx);
+		}
+	}
+
+	uint32_t tokens_start_idx = hcc_stack_count(ast_file->token_bag.tokens);
+	uint32_t token_values_start_idx = hcc_stack_count(ast_file->token_bag.values);
+	uint32_t effects_start_idx = hcc_stack_count(ast_file->include_effects);
+	hcc_atagen_pch_load_tokens(w, &ast_file->token_bag, tokens, token_locations, token_values, header->file_tokens_count);
+
+	for (uint32_t effect_idx = 0; effect_idx < header->effects_count; effect_idx += 1) {
+		HccATAIncludeEffect* effect = &effects[effect_idx];
+		switch (effect->type) {
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_DEFINE:
+				hcc_atagen_include_replay_define(w, *hcc_stack_get(pch->macro_indices, effect->pch_idx));
+				break;
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_UNDEF:
+				hcc_atagen_include_replay_undef(w, *hcc_stack_get(pch->string_ids, effect->pch_idx));
+				break;
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_PRAGMA_ONCE:
+				hcc_ast_file_set_pragma_onced(ast_file, *hcc_stack_get(pch->string_ids, effect->pch_idx));
+				break;
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_FOUND_INCLUDED_FILE:
+				hcc_ast_file_found_included_file(ast_file, *hcc_stack_get(pch->string_ids, effect->pch_idx));
+				break;
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_TOKENIZED_FILE:
+				hcc_atagen_include_effect_push(w, HCC_ATA_INCLUDE_EFFECT_TYPE_TOKENIZED_FILE, hcc_stack_get(pch->string_ids, files[effect->pch_idx].path_string_idx)->idx_plus_one);
+				break;
+		}
+	}
+
+	//
+	// the other files in this compile can now take the tokens from the include cache
+	hcc_atagen_include_cache_publish(w, key, tokens_start_idx, token_values_start_idx, effects_start_idx);
+	hcc_code_file_release_code(data);
+	return true;
+
+FAIL_UNCLAIM:
+	for (uint32_t file_idx = 0; file_idx < hcc_stack_count(pch->code_files); file_idx += 1) {
+		HccCodeFile* file_code_file = *hcc_stack_get(pch->code_files, file_idx);
+		if (*hcc_stack_get(pch->we_are_mutator_of_code_files, file_idx) && file_code_file != code_file) {
+			atomic_fetch_and(&file_code_file->flags, ~HCC_CODE_FILE_FLAGS_HAS_STARTED_BEING_PARSED);
+		}
+	}
+FAIL_RELEASE:
+	hcc_code_file_release_code(data);
+	return false;
+}
+
+void hcc_atagen_pch_store(HccWorker* w, HccATAIncludeRecording* recording) {
+	HccATAGenPCH* pch = &w->atagen.pch;
+	HccASTFile* ast_file = w->atagen.ast_file;
+
+	uint32_t tokens_count = hcc_stack_count(ast_file->token_bag.tokens) - recording->tokens_start_idx;
+	if (tokens_count + hcc_stack_count(ast_file->macro_token_bag.tokens) > hcc_stack_reserve_cap(pch->tokens)) {
+		return;
+	}
+
+	hcc_hash_table_clear(pch->idx_map);
+	hcc_stack_clear(pch->strings);
+	hcc_stack_clear(pch->string_bytes);
+	hcc_stack_clear(pch->files);
+	hcc_stack_clear(pch->code_files);
+	hcc_stack_clear(pch->line_code_start_indices);
+	hcc_stack_clear(pch->if_spans);
+	hcc_stack_clear(pch->locations);
+	hcc_stack_clear(pch->src_locations);
+	hcc_stack_clear(pch->constants);
+	hcc_stack_clear(pch->macros);
+	hcc_stack_clear(pch->macro_params);
+	hcc_stack_clear(pch->tokens);
+	hcc_stack_clear(pch->token_locations);
+	hcc_stack_clear(pch->token_values);
+	hcc_stack_clear(pch->effects);
+
+	uint32_t path_string_idx = hcc_atagen_pch_add_string(w, recording->key.path_string_id);
+
+	//
+	// the tokens of the included file go first, the tokens of the macros it defines get appended after them
+	if (path_string_idx == UINT32_MAX || !hcc_atagen_pch_add_tokens(w, &ast_file->token_bag, recording->tokens_start_idx, tokens_count, recording->token_values_start_idx)) {
+		return;
+	}
+	uint32_t file_token_values_count = hcc_stack_count(pch->token_values);
+
+	for (uint32_t effect_idx = recording->effects_start_idx; effect_idx < hcc_stack_count(ast_file->include_effects); effect_idx += 1) {
+		HccATAIncludeEffect* effect = hcc_stack_get(ast_file->include_effects, effect_idx);
+		uint32_t pch_idx = UINT32_MAX;
+		switch (effect->type) {
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_DEFINE:
+				pch_idx = hcc_atagen_pch_add_macro(w, hcc_stack_get(ast_file->macros, effect->macro_idx));
+				break;
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_UNDEF:
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_PRAGMA_ONCE:
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_FOUND_INCLUDED_FILE:
+				pch_idx = hcc_atagen_pch_add_string(w, effect->string_id);
+				break;
+			case HCC_ATA_INCLUDE_EFFECT_TYPE_TOKENIZED_FILE: {
+				HccCodeFile* code_file = hcc_code_file_find(hcc_string_table_get(effect->string_id));
+				pch_idx = code_file ? hcc_atagen_pch_add_file(w, code_file) : UINT32_MAX;
+				if (pch_idx != UINT32_MAX) {
+					hcc_stack_get(pch->files, pch_idx)->is_tokenized = true;
+				}
+				break;
+			};
+		}
+
+		if (pch_idx == UINT32_MAX) {
+			return;
+		}
+
+		HccATAIncludeEffect* pch_effect = hcc_stack_push(pch->effects);
+		HCC_ZERO_ELMT(pch_effect);
+		pch_effect->type = effect->type;
+		pch_effect->pch_idx = pch_idx;
+	}
+
+	for (uint32_t file_idx = 0; file_idx < hcc_stack_count(pch->files); file_idx += 1) {
+		if (hcc_stack_get(pch->files, file_idx)->is_tokenized && !hcc_atagen_pch_add_code_file_mutator_data(w, file_idx)) {
+			return;
+		}
+	}
+
+	//
+	// now that all of the macros are known, link the locations to the macros they were expanded from.
+	// the macro may have been copied from the include cache so when the pointer is not found, it is found by name.
+	for (uint32_t location_idx = 0; location_idx < hcc_stack_count(pch->locations); location_idx += 1) {
+		HccPPMacro* macro = (*hcc_stack_get(pch->src_locations, location_idx))->macro;
+		if (macro == NULL) {
+			continue;
+		}
+
+		uint32_t macro_idx = hcc_atagen_pch_idx_find(w, HCC_ATA_PCH_IDX_KEY_PTR(macro));
+		if (macro_idx == UINT32_MAX) {
+			macro_idx = hcc_atagen_pch_idx_find(w, HCC_ATA_PCH_IDX_KEY_MACRO_IDENTIFIER(macro->identifier_string_id));
+		}
+
+		if (macro_idx != UINT32_MAX) {
+			hcc_stack_get(pch->locations, location_idx)->macro_idx_plus_one = macro_idx + 1;
+		} else {
+			uint32_t identifier_string_idx = hcc_atagen_pch_add_string(w, macro->identifier_string_id);
+			if (identifier_string_idx == UINT32_MAX) {
+				return;
+			}
+			hcc_stack_get(pch->locations, location_idx)->macro_identifier_string_idx_plus_one = identifier_string_idx + 1;
+		}
+	}
+
+	HccATAPCHHeader header = {
+		.magic_number = HCC_ATA_PCH_MAGIC_NUMBER,
+		.version = HCC_ATA_PCH_VERSION,
+		.key_hash = hcc_atagen_pch_key_hash(w, &recording->key),
+		.macro_state_hash = recording->key.macro_state_hash,
+		.pragma_onced_hash = recording->key.pragma_onced_hash,
+		.path_string_idx = path_string_idx,
+		.strings_count = hcc_stack_count(pch->strings),
+		.string_bytes_size = hcc_stack_count(pch->string_bytes),
+		.files_count = hcc_stack_count(pch->files),
+		.line_code_start_indices_count = hcc_stack_count(pch->line_code_start_indices),
+		.if_spans_count = hcc_stack_count(pch->if_spans),
+		.locations_count = hcc_stack_count(pch->locations),
+		.constants_count = hcc_stack_count(pch->constants),
+		.macros_count = hcc_stack_count(pch->macros),
+		.macro_params_count = hcc_stack_count(pch->macro_params),
+		.tokens_count = hcc_stack_count(pch->tokens),
+		.token_values_count = hcc_stack_count(pch->token_values),
+		.file_tokens_count = tokens_count,
+		.file_token_values_count = file_token_values_count,
+		.effects_count = hcc_stack_count(pch->effects),
+	};
+
+	//
+	// write to a file unique to this worker and then rename it into place,
+	// so other compiles never see a precompiled header that is half written.
+	char path[PATH_MAX];
+	char tmp_path[PATH_MAX];
+	if (!hcc_atagen_pch_path(w, header.key_hash, path, sizeof(path))) {
+		return;
+	}
+	int tmp_path_size = snprintf(tmp_path, sizeof(tmp_path), "%s.%u.%u.tmp", path, hcc_process_id(), (uint32_t)(w - w->c->workers));
+
+	HccIIO iio;
+	if (tmp_path_size < 0 || (uint32_t)tmp_path_size >= sizeof(tmp_path) || !hcc_file_open_write(tmp_path, &iio)) {
+		return;
+	}
+
+	bool is_written =
+		hcc_atagen_pch_write_section(&iio, &header, sizeof(header)) &&
+		hcc_atagen_pch_write_section(&iio, pch->strings, header.strings_count * sizeof(*pch->strings)) &&
+		hcc_atagen_pch_write_section(&iio, pch->string_bytes, header.string_bytes_size * sizeof(*pch->string_bytes)) &&
+		hcc_atagen_pch_write_section(&iio, pch->files, header.files_count * sizeof(*pch->files)) &&
+		hcc_atagen_pch_write_section(&iio, pch->line_code_start_indices, header.line_code_start_indices_count * sizeof(*pch->line_code_start_indices)) &&
+		hcc_atagen_pch_write_section(&iio, pch->if_spans, header.if_spans_count * sizeof(*pch->if_spans)) &&
+		hcc_atagen_pch_write_section(&iio, pch->locations, header.locations_count * sizeof(*pch->locations)) &&
+		hcc_atagen_pch_write_section(&iio, pch->constants, header.constants_count * sizeof(*pch->constants)) &&
+		hcc_atagen_pch_write_section(&iio, pch->macros, header.macros_count * sizeof(*pch->macros)) &&
+		hcc_atagen_pch_write_section(&iio, pch->macro_params, header.macro_params_count * sizeof(*pch->macro_params)) &&
+		hcc_atagen_pch_write_section(&iio, pch->tokens, header.tokens_count * sizeof(*pch->tokens)) &&
+		hcc_atagen_pch_write_section(&iio, pch->token_locations, header.tokens_count * sizeof(*pch->token_locations)) &&
+		hcc_atagen_pch_write_section(&iio, pch->token_values, header.token_values_count * sizeof(*pch->token_values)) &&
+		hcc_atagen_pch_write_section(&iio, pch->effects, header.effects_count * sizeof(*pch->effects));
+	hcc_iio_close(&iio);
+
+	if (!is_written || !hcc_path_rename(tmp_path, path)) {
+		hcc_path_remove(tmp_path);
+	}
+}
+
+uint32_t hcc_atagen_pch_idx_find(HccWorker* w, uint64_t key) {
+	uintptr_t found_idx = hcc_hash_table_find_idx(w->atagen.pch.idx_map, &key);
+	return found_idx == UINTPTR_MAX ? UINT32_MAX : w->atagen.pch.idx_map[found_idx].idx;
+}
+
+bool hcc_atagen_pch_idx_insert(HccWorker* w, uint64_t key, uint32_t idx) {
+	//
+	// give up on the precompiled header instead of bailing out when the map fills up
+	HccHashTable(HccATAPCHIdxEntry) idx_map = w->atagen.pch.idx_map;
+	if (hcc_hash_table_count(idx_map) >= hcc_hash_table_reserve_cap(idx_map) / 2) {
+		return false;
+	}
+
+	HccHashTableInsert insert = hcc_hash_table_find_insert_idx(idx_map, &key);
+	idx_map[insert.idx].idx = idx;
+	return true;
+}
+
+uint32_t hcc_atagen_pch_add_string(HccWorker* w, HccStringId string_id) {
+	HccATAGenPCH* pch = &w->atagen.pch;
+	uint64_t key = HCC_ATA_PCH_IDX_KEY_STRING_ID(string_id);
+	uint32_t string_idx = hcc_atagen_pch_idx_find(w, key);
+	if (string_idx != UINT32_MAX) {
+		return string_idx;
+	}
+
+	HccString string = hcc_string_table_get(string_id);
+	string_idx = hcc_stack_count(pch->strings);
+	if (hcc_stack_count(pch->string_bytes) + string.size + 1 > hcc_stack_reserve_cap(pch->string_bytes) || !hcc_atagen_pch_idx_insert(w, key, string_idx)) {
+		return UINT32_MAX;
+	}
+
+	HccATAPCHString* pch_string = hcc_stack_push(pch->strings);
+	pch_string->bytes_start_idx = hcc_stack_count(pch->string_bytes);
+	pch_string->size = string.size;
+	pch_string->hash = hcc_string_hash(string.data, string.size);
+	char* bytes = hcc_stack_push_many(pch->string_bytes, string.size + 1);
+	memcpy(bytes, string.data, string.size);
+	bytes[string.size] = '\0';
+	return string_idx;
+}
+
+uint32_t hcc_atagen_pch_add_constant(HccWorker* w, HccConstantId constant_id) {
+	HccATAGenPCH* pch = &w->atagen.pch;
+	uint64_t key = HCC_ATA_PCH_IDX_KEY_CONSTANT_ID(constant_id);
+	uint32_t constant_idx = hcc_atagen_pch_idx_find(w, key);
+	if (constant_idx != UINT32_MAX) {
+		return constant_idx;
+	}
+
+	constant_idx = hcc_stack_count(pch->constants);
+	if (!hcc_atagen_pch_idx_insert(w, key, constant_idx)) {
+		return UINT32_MAX;
+	}
+
+	HccATAPCHConstant* pch_constant = hcc_stack_push(pch->constants);
+	HCC_ZERO_ELMT(pch_constant);
+	pch_constant->data_type = hcc_constant_table_get(w->cu, constant_id).data_type;
+	pch_constant->basic = hcc_constant_table_get_basic(w->cu, constant_id);
+	return constant_idx;
+}
+
+uint32_t hcc_atagen_pch_add_file(HccWorker* w, HccCodeFile* code_file) {
+	HccATAGenPCH* pch = &w->atagen.pch;
+	uint64_t key = HCC_ATA_PCH_IDX_KEY_PTR(code_file);
+	uint32_t file_idx = hcc_atagen_pch_idx_find(w, key);
+	if (file_idx != UINT32_MAX) {
+		return file_idx;
+	}
+
+	//
+	// the file has to be found again by it's path when loading,
+	// so files that only live in memory like the macro paste buffer cannot be stored.
+	if (hcc_code_file_find(code_file->path_string) != code_file) {
+		return UINT32_MAX;
+	}
+
+	HccStringId path_string_id;
+	hcc_string_table_deduplicate(code_file->path_string.data, code_file->path_string.size, &path_string_id);
+	uint32_t path_string_idx = hcc_atagen_pch_add_string(w, path_string_id);
+	file_idx = hcc_stack_count(pch->files);
+	if (path_string_idx == UINT32_MAX || !hcc_atagen_pch_idx_insert(w, key, file_idx)) {
+		return UINT32_MAX;
+	}
+
+	HccATAPCHFile* file = hcc_stack_push(pch->files);
+	HCC_ZERO_ELMT(file);
+	file->code_hash = code_file->code_hash;
+	file->code_size = code_file->code.size;
+	file->path_string_idx = path_string_idx;
+	*hcc_stack_push(pch->code_files) = code_file;
+	return file_idx;
+}
+
+uint32_t hcc_atagen_pch_add_location(HccWorker* w, HccLocation* location) {
+	HccATAGenPCH* pch = &w->atagen.pch;
+	uint64_t key = HCC_ATA_PCH_IDX_KEY_PTR(location);
+	uint32_t location_idx = hcc_atagen_pch_idx_find(w, key);
+	if (location_idx != UINT32_MAX) {
+		return location_idx;
+	}
+
+	//
+	// the parent is added first so it has already been made when this location is loaded
+	uint32_t parent_location_idx_plus_one = 0;
+	if (location->parent_location) {
+		uint32_t parent_location_idx = hcc_atagen_pch_add_location(w, location->parent_location);
+		if (parent_location_idx == UINT32_MAX) {
+			return UINT32_MAX;
+		}
+		parent_location_idx_plus_one = parent_location_idx + 1;
+	}
+
+	uint32_t file_idx = location->code_file ? hcc_atagen_pch_add_file(w, location->code_file) : UINT32_MAX;
+	if (file_idx == UINT32_MAX) {
+		return UINT32_MAX;
+	}
+
+	uint32_t display_path_string_idx_plus_one = 0;
+	if (location->display_path.data) {
+		HccStringId display_path_string_id;
+		hcc_string_table_deduplicate(location->display_path.data, location->display_path.size, &display_path_string_id);
+		uint32_t display_path_string_idx = hcc_atagen_pch_add_string(w, display_path_string_id);
+		if (display_path_string_idx == UINT32_MAX) {
+			return UINT32_MAX;
+		}
+		display_path_string_idx_plus_one = display_path_string_idx + 1;
+	}
+
+	location_idx = hcc_stack_count(pch->locations);
+	if (!hcc_atagen_pch_idx_insert(w, key, location_idx)) {
+		return UINT32_MAX;
+	}
+
+	HccATAPCHLocation* pch_location = hcc_stack_push(pch->locations);
+	HCC_ZERO_ELMT(pch_location);
+	pch_location->file_idx = file_idx;
+	pch_location->parent_location_idx_plus_one = parent_location_idx_plus_one;
+	pch_location->code_start_idx = location->code_start_idx;
+	pch_location->code_end_idx = location->code_end_idx;
+	pch_location->line_start = location->line_start;
+	pch_location->line_end = location->line_end;
+	pch_location->column_start = location->column_start;
+	pch_location->column_end = location->column_end;
+	pch_location->display_path_string_idx_plus_one = display_path_string_idx_plus_one;
+	pch_location->display_line = location->display_line;
+	*hcc_stack_push(pch->src_locations) = location;
+	return location_idx;
+}
+
+uint32_t hcc_atagen_pch_add_macro(HccWorker* w, HccPPMacro* macro) {
+	HccATAGenPCH* pch = &w->atagen.pch;
+	HccASTFile* ast_file = w->atagen.ast_file;
+
+	uint32_t identifier_string_idx = hcc_atagen_pch_add_string(w, macro->identifier_string_id);
+	uint32_t location_idx = hcc_atagen_pch_add_location(w, macro->location);
+	if (identifier_string_idx == UINT32_MAX || location_idx == UINT32_MAX) {
+		return UINT32_MAX;
+	}
+
+	uint32_t params_start_idx = hcc_stack_count(pch->macro_params);
+	for (uint32_t param_idx = 0; param_idx < macro->params_count; param_idx += 1) {
+		uint32_t param_string_idx = hcc_atagen_pch_add_string(w, macro->params[param_idx]);
+		if (param_string_idx == UINT32_MAX) {
+			return UINT32_MAX;
+		}
+		*hcc_stack_push(pch->macro_params) = param_string_idx;
+	}
+
+	uint32_t tokens_start_idx = hcc_stack_count(pch->tokens);
+	uint32_t token_values_start_idx = hcc_stack_count(pch->token_values);
+	uint32_t tokens_count = hcc_ata_token_cursor_tokens_count(&macro->token_cursor);
+	if (!hcc_atagen_pch_add_tokens(w, &ast_file->macro_token_bag, macro->token_cursor.tokens_start_idx, tokens_count, macro->token_cursor.token_value_idx)) {
+		return UINT32_MAX;
+	}
+
+	uint32_t macro_idx = hcc_stack_count(pch->macros);
+	if (
+		!hcc_atagen_pch_idx_insert(w, HCC_ATA_PCH_IDX_KEY_PTR(macro), macro_idx) ||
+		!hcc_atagen_pch_idx_insert(w, HCC_ATA_PCH_IDX_KEY_MACRO_IDENTIFIER(macro->identifier_string_id), macro_idx)
+	) {
+		return UINT32_MAX;
+	}
+
+	HccATAPCHMacro* pch_macro = hcc_stack_push(pch->macros);
+	HCC_ZERO_ELMT(pch_macro);
+	pch_macro->content_hash = macro->content_hash;
+	pch_macro->identifier_string_idx = identifier_string_idx;
+	pch_macro->location_idx = location_idx;
+	pch_macro->params_start_idx = params_start_idx;
+	pch_macro->params_count = macro->params_count;
+	pch_macro->tokens_start_idx = tokens_start_idx;
+	pch_macro->tokens_count = tokens_count;
+	pch_macro->token_values_start_idx = token_values_start_idx;
+	pch_macro->token_values_count = macro->token_values_count;
+	pch_macro->is_function = macro->is_function;
+	pch_macro->has_va_args = macro->has_va_args;
+	return macro_idx;
+}
+
+bool hcc_atagen_pch_add_tokens(HccWorker* w, HccATATokenBag* bag, uint32_t tokens_start_idx, uint32_t tokens_count, uint32_t token_values_start_idx) {
+	HccATAGenPCH* pch = &w->atagen.pch;
+	if (tokens_count) {
+		HCC_COPY_ELMT_MANY(hcc_stack_push_many(pch->tokens, tokens_count), hcc_stack_get(bag->tokens, tokens_start_idx), tokens_count);
+	}
+
+	uint32_t token_value_idx = token_values_start_idx;
+	for (uint32_t token_idx = tokens_start_idx; token_idx < tokens_start_idx + tokens_count; token_idx += 1) {
+		HccLocation* location = *hcc_stack_get(bag->locations, token_idx);
+		uint32_t location_idx = hcc_atagen_pch_add_location(w, HCC_PP_TOKEN_STRIP_PREEXPANDED_MACRO_ARG(location));
+		if (location_idx == UINT32_MAX) {
+			return false;
+		}
+		if (HCC_PP_TOKEN_IS_PREEXPANDED_MACRO_ARG(location)) {
+			location_idx |= HCC_ATA_PCH_TOKEN_LOCATION_IS_PREEXPANDED_MACRO_ARG;
+		}
+		*hcc_stack_push(pch->token_locations) = location_idx;
+
+		HccATAToken token = *hcc_stack_get(bag->tokens, token_idx);
+		uint32_t values_count = hcc_ata_token_num_values(token);
+		for (uint32_t value_idx = 0; value_idx < values_count; value_idx += 1) {
+			HccATAValue* value = hcc_stack_get(bag->values, token_value_idx);
+			uint32_t pch_value = UINT32_MAX;
+			switch (hcc_ata_token_value_type(token, value_idx)) {
+				case HCC_ATA_VALUE_TYPE_STRING_ID: pch_value = hcc_atagen_pch_add_string(w, value->string_id); break;
+				case HCC_ATA_VALUE_TYPE_CONSTANT_ID: pch_value = hcc_atagen_pch_add_constant(w, value->constant_id); break;
+				case HCC_ATA_VALUE_TYPE_MACRO_PARAM_IDX: pch_value = value->macro_param_idx; break;
+			}
+			if (pch_value == UINT32_MAX) {
+				return false;
+			}
+			*hcc_stack_push(pch->token_values) = pch_value;
+			token_value_idx += 1;
+		}
+	}
+
+	return true;
+}
+
+bool hcc_atagen_pch_add_code_file_mutator_data(HccWorker* w, uint32_t file_idx) {
+	HccATAGenPCH* pch = &w->atagen.pch;
+	HccCodeFile* code_file = *hcc_stack_get(pch->code_files, file_idx);
+
+	//
+	// another worker can still be the mutator of a file that we have tokenized
+	if (!(atomic_load(&code_file->flags) & HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS)) {
+		return false;
+	}
+
+	uint32_t line_code_start_indices_start_idx = hcc_stack_count(pch->line_code_start_indices);
+	uint32_t line_code_start_indices_count = hcc_stack_count(code_file->line_code_start_indices);
+	HCC_COPY_ELMT_MANY(hcc_stack_push_many(pch->line_code_start_indices, line_code_start_indices_count), code_file->line_code_start_indices, line_code_start_indices_count);
+
+	uint32_t if_spans_start_idx = hcc_stack_count(pch->if_spans);
+	uint32_t if_spans_count = hcc_stack_count(code_file->pp_if_spans);
+	for (uint32_t span_idx = 0; span_idx < if_spans_count; span_idx += 1) {
+		HccPPIfSpan* span = hcc_stack_get(code_file->pp_if_spans, span_idx);
+		uint32_t location_idx = hcc_atagen_pch_add_location(w, &span->location);
+		if (location_idx == UINT32_MAX) {
+			return false;
+		}
+
+		HccATAPCHIfSpan* pch_span = hcc_stack_push(pch->if_spans);
+		pch_span->directive = span->directive;
+		pch_span->location_idx = location_idx;
+		pch_span->parent_id = span->parent_id;
+		pch_span->first_id = span->first_id;
+		pch_span->has_else = span->has_else;
+		pch_span->prev_id = span->prev_id;
+		pch_span->next_id = span->next_id;
+		pch_span->last_id = span->last_id;
+	}
+
+	HccATAPCHFile* file = hcc_stack_get(pch->files, file_idx);
+	file->line_code_start_indices_start_idx = line_code_start_indices_start_idx;
+	file->line_code_start_indices_count = line_code_start_indices_count;
+	file->if_spans_start_idx = if_spans_start_idx;
+	file->if_spans_count = if_spans_count;
+	return true;
+}
+
+bool hcc_atagen_pch_write_section(HccIIO* iio, void* data, uintptr_t size) {
+	static const uint8_t zeros[HCC_ATA_PCH_ALIGN] = {0};
+	uintptr_t padding_size = HCC_INT_ROUND_UP_ALIGN(size, HCC_ATA_PCH_ALIGN) - size;
+	return hcc_iio_write(iio, data, size) == size && hcc_iio_write(iio, zeros, padding_size) == padding_size;
+}
+
+void hcc_atagen_pch_load_location(HccWorker* w, HccATAPCHLocation* pch_location, HccLocation* location_out) {
+	HccATAGenPCH* pch = &w->atagen.pch;
+	location_out->code_file = *hcc_stack_get(pch->code_files, pch_location->file_idx);
+	location_out->parent_location = NULL;
+	location_out->macro = NULL;
+	location_out->code_start_idx = pch_location->code_start_idx;
+	location_out->code_end_idx = pch_location->code_end_idx;
+	location_out->line_start = pch_location->line_start;
+	location_out->line_end = pch_location->line_end;
+	location_out->column_start = pch_location->column_start;
+	location_out->column_end = pch_location->column_end;
+	location_out->display_path = pch_location->display_path_string_idx_plus_one
+		? hcc_string_table_get(*hcc_stack_get(pch->string_ids, pch_location->display_path_string_idx_plus_one - 1))
+		: hcc_string(NULL, 0);
+	location_out->display_line = pch_location->display_line;
+}
+
+bool hcc_atagen_pch_tokens_are_valid(HccATAPCHHeader* header, HccATAToken* tokens, uint32_t* token_locations, uint32_t* token_values, uint32_t tokens_count, uint32_t token_values_count, uint32_t macro_params_count) {
+	uint32_t token_value_idx = 0;
+	for (uint32_t token_idx = 0; token_idx < tokens_count; token_idx += 1) {
+		if (
+			tokens[token_idx] >= HCC_ATA_TOKEN_COUNT ||
+			(token_locations[token_idx] & ~HCC_ATA_PCH_TOKEN_LOCATION_IS_PREEXPANDED_MACRO_ARG) >= header->locations_count
+		) {
+			return false;
+		}
+
+		uint32_t values_count = hcc_ata_token_num_values(tokens[token_idx]);
+		if (values_count > token_values_count - token_value_idx) {
+			return false;
+		}
+
+		for (uint32_t value_idx = 0; value_idx < values_count; value_idx += 1) {
+			uint32_t value = token_values[token_value_idx];
+			uint32_t value_end;
+			switch (hcc_ata_token_value_type(tokens[token_idx], value_idx)) {
+				case HCC_ATA_VALUE_TYPE_STRING_ID: value_end = header->strings_count; break;
+				case HCC_ATA_VALUE_TYPE_CONSTANT_ID: value_end = header->constants_count; break;
+				case HCC_ATA_VALUE_TYPE_MACRO_PARAM_IDX: value_end = macro_params_count; break;
+				default: value_end = 0; break;
+			}
+			if (value >= value_end) {
+				return false;
+			}
+			token_value_idx += 1;
+		}
+	}
+
+	return token_value_idx == token_values_count;
+}
+
+void hcc_atagen_pch_load_tokens(HccWorker* w, HccATATokenBag* bag, HccATAToken* tokens, uint32_t* token_locations, uint32_t* token_values, uint32_t tokens_count) {
+	HccATAGenPCH* pch = &w->atagen.pch;
+	HCC_COPY_ELMT_MANY(hcc_stack_push_many(bag->tokens, tokens_count), tokens, tokens_count);
+
+	HccLocation** locations = hcc_stack_push_many(bag->locations, tokens_count);
+	for (uint32_t token_idx = 0; token_idx < tokens_count; token_idx += 1) {
+		uint32_t location_idx = token_locations[token_idx];
+		HccLocation* location = *hcc_stack_get(pch->src_locations, location_idx & ~HCC_ATA_PCH_TOKEN_LOCATION_IS_PREEXPANDED_MACRO_ARG);
+		locations[token_idx] = location_idx & HCC_ATA_PCH_TOKEN_LOCATION_IS_PREEXPANDED_MACRO_ARG
+			? HCC_PP_TOKEN_SET_PREEXPANDED_MACRO_ARG(location)
+			: location;
+
+		uint32_t values_count = hcc_ata_token_num_values(tokens[token_idx]);
+		for (uint32_t value_idx = 0; value_idx < values_count; value_idx += 1) {
+			HccATAValue* value = hcc_stack_push(bag->values);
+			switch (hcc_ata_token_value_type(tokens[token_idx], value_idx)) {
+				case HCC_ATA_VALUE_TYPE_STRING_ID: value->string_id = *hcc_stack_get(pch->string_ids, *token_values); break;
+				case HCC_ATA_VALUE_TYPE_CONSTANT_ID: value->constant_id = *hcc_stack_get(pch->constant_ids, *token_values); break;
+				case HCC_ATA_VALUE_TYPE_MACRO_PARAM_IDX: value->macro_param_idx = *token_values; break;
+			}
+			token_values += 1;
+		}
+	}
+}
+
+void hcc_atagen_token_merge_append_string(HccWorker* w, HccATATokenBag* bag, HccString append_string) {
+	HCC_DEBUG_ASSERT(hcc_stack_count(bag->tokens) > 0 && *hcc_stack_get_last(bag->tokens) == HCC_ATA_TOKEN_STRING, "expected string token");
+
+	HccString prepend_string = hcc_string_table_get(hcc_stack_get_last(bag->values)->string_id);
+
+	uint32_t stringify_buffer_start_idx = hcc_stack_count(w->string_buffer);
+	hcc_stack_push_string(w->string_buffer, prepend_string);
+	hcc_stack_pop(w->string_buffer); // remove \0
+	hcc_stack_push_string(w->string_buffer, append_string);
+	HccStringId string_id;
+	hcc_string_table_deduplicate(&w->string_buffer[stringify_buffer_start_idx], hcc_stack_count(w->string_buffer) - stringify_buffer_start_idx, &string_id);
+	hcc_stack_resize(w->string_buffer, stringify_buffer_start_idx);
+
+	hcc_stack_get_last(bag->values)->string_id = string_id;
+}
+
+bool hcc_atagen_consume_backslash(HccWorker* w) {
+	hcc_atagen_advance_column(w, 1);
+	char byte = w->atagen.code[w->atagen.location.code_end_idx];
+	bool found_newline = false;
+	if (byte == '\r') {
+		hcc_atagen_advance_column(w, 1);
+		byte = w->atagen.code[w->atagen.location.code_end_idx];
+		found_newline = true;
+	}
+	if (byte == '\n'){
+		hcc_atagen_advance_column(w, 1);
+		byte = w->atagen.code[w->atagen.location.code_end_idx];
+		found_newline = true;
+	}
+	if (found_newline) {
+		w->atagen.location.line_end += 1;
+		w->atagen.location.column_start = 1;
+		w->atagen.location.column_end = 1;
+		if (w->atagen.we_are_mutator_of_code_file) {
+			uint32_t* dst = hcc_stack_push(w->atagen.location.code_file->line_code_start_indices);
+			*dst = w->atagen.location.code_end_idx;
+		}
+	}
+	return found_newline;
+}
+
+void hcc_atagen_consume_whitespace(HccWorker* w) {
+	uint32_t code_idx = w->atagen.location.code_end_idx;
+	hcc_atagen_advance_column(w, hcc_bytes_count_spaces(&w->atagen.code[code_idx], w->atagen.code_size - code_idx));
+
+	while (w->atagen.location.code_end_idx < w->atagen.code_size) {
+		char byte = w->atagen.code[w->atagen.location.code_end_idx];
+		if (byte != ' ' && byte != '\t') {
+			char next_byte = w->atagen.code[w->atagen.location.code_end_idx + 1];
+			if (byte != '\\' || !hcc_atagen_consume_backslash(w)) {
+				break;
+			}
+		} else {
+			hcc_atagen_advance_column(w, 1);
+		}
+	}
+}
+
+void hcc_atagen_consume_whitespace_and_newlines(HccWorker* w) {
+	while (w->atagen.location.code_end_idx < w->atagen.code_size) {
+		char byte = w->atagen.code[w->atagen.location.code_end_idx];
+		if (byte != ' ' && byte != '\t' && byte != '\r' && byte != '\n' && byte != '\\') {
 			break;
 		} else {
 			if (byte == '\n') {
@@ -2081,7 +3561,18 @@ void hcc_atagen_consume_whitespace_and_newlines(HccWorker* w) {
 
 
 void hcc_atagen_consume_until_any_byte(HccWorker* w, char* terminator_bytes) {
+	bool is_single_terminator_byte = terminator_bytes[0] && !terminator_bytes[1];
 	while (w->atagen.location.code_end_idx < w->atagen.code_size) {
+		if (is_single_terminator_byte) {
+			//
+			// skip over all of the bytes that are not handled below
+			uint32_t code_idx = w->atagen.location.code_end_idx;
+			hcc_atagen_advance_column(w, hcc_bytes_find_any_4(&w->atagen.code[code_idx], w->atagen.code_size - code_idx, terminator_bytes[0], '\\', '\r', '\n'));
+			if (w->atagen.location.code_end_idx == w->atagen.code_size) {
+				break;
+			}
+		}
+
 		char byte = w->atagen.code[w->atagen.location.code_end_idx];
 		if (byte == '\\') {
 			hcc_atagen_consume_backslash(w);
@@ -2108,20 +3599,7 @@ HccString hcc_atagen_parse_ident_from_string(HccWorker* w, HccString string, Hcc
 		hcc_atagen_bail_error_1(w, error_code, byte);
 	}
 
-	HccString ident_string = hcc_string(string.data, 0);
-	while (ident_string.size < string.size) {
-		char ident_byte = ident_string.data[ident_string.size];
-		if (
-			!hcc_ascii_is_alpha(ident_byte) &&
-			!hcc_ascii_is_digit(ident_byte) &&
-			ident_byte != '_'
-		) {
-			break;
-		}
-		ident_string.size += 1;
-	}
-
-	return ident_string;
+	return hcc_string(string.data, hcc_bytes_count_ident(string.data, string.size));
 }
 
 HccString hcc_atagen_parse_ident(HccWorker* w, HccErrorCode error_code) {
@@ -2409,6 +3887,17 @@ NUM_END: {}
 	return token_size;
 }
 
+//
+// copy the bytes up to the next escape sequence, newline or terminator into the string buffer in one go
+void hcc_atagen_parse_string_run(HccWorker* w, char terminator_byte) {
+	uint32_t code_idx = w->atagen.location.code_end_idx;
+	uint32_t run_size = hcc_bytes_find_any_4(&w->atagen.code[code_idx], w->atagen.code_size - code_idx, '\\', '\r', '\n', terminator_byte);
+	if (run_size) {
+		HCC_COPY_ELMT_MANY(hcc_stack_push_many(w->string_buffer, run_size), &w->atagen.code[code_idx], run_size);
+		hcc_atagen_advance_column(w, run_size);
+	}
+}
+
 void hcc_atagen_parse_string(HccWorker* w, char terminator_byte, bool ignore_escape_sequences_except_double_quotes) {
 	w->atagen.location.code_end_idx += 1;
 	w->atagen.location.column_end += 1;
@@ -2418,6 +3907,11 @@ void hcc_atagen_parse_string(HccWorker* w, char terminator_byte, bool ignore_esc
 	if (is_pp) {
 		bool ended_with_terminator = false;
 		while (w->atagen.location.code_end_idx < w->atagen.code_size) {
+			hcc_atagen_parse_string_run(w, terminator_byte);
+			if (w->atagen.location.code_end_idx == w->atagen.code_size) {
+				break;
+			}
+
 			char byte = w->atagen.code[w->atagen.location.code_end_idx];
 			w->atagen.location.column_end += 1;
 			w->atagen.location.code_end_idx += 1;
@@ -2463,6 +3957,11 @@ void hcc_atagen_parse_string(HccWorker* w, char terminator_byte, bool ignore_esc
 	} else {
 		bool ended_with_terminator = false;
 		while (w->atagen.location.code_end_idx < w->atagen.code_size) {
+			hcc_atagen_parse_string_run(w, terminator_byte);
+			if (w->atagen.location.code_end_idx == w->atagen.code_size) {
+				break;
+			}
+
 			char byte = w->atagen.code[w->atagen.location.code_end_idx];
 			w->atagen.location.column_end += 1;
 			w->atagen.location.code_end_idx += 1;
@@ -2738,13 +4237,8 @@ void hcc_atagen_run(HccWorker* w, HccATATokenBag* dst_token_bag, HccATAGenRunMod
 				char next_byte = w->atagen.code[w->atagen.location.code_end_idx + 1];
 				if (next_byte == '/') {
 					w->atagen.location.code_end_idx += 2;
-					while (w->atagen.location.code_end_idx < w->atagen.code_size) {
-						char b = w->atagen.code[w->atagen.location.code_end_idx];
-						if (b == '\n') {
-							break;
-						}
-						w->atagen.location.code_end_idx += 1;
-					}
+					uint32_t code_idx = w->atagen.location.code_end_idx;
+					w->atagen.location.code_end_idx += hcc_bytes_find(&w->atagen.code[code_idx], w->atagen.code_size - code_idx, '\n');
 
 					token_size = w->atagen.location.code_end_idx - w->atagen.location.code_start_idx;
 					w->atagen.location.column_start += token_size;
@@ -2753,18 +4247,16 @@ void hcc_atagen_run(HccWorker* w, HccATATokenBag* dst_token_bag, HccATAGenRunMod
 				} else if (next_byte == '*') {
 					hcc_atagen_advance_column(w, 2);
 					while (w->atagen.location.code_end_idx < w->atagen.code_size) {
-						char b = w->atagen.code[w->atagen.location.code_end_idx];
-						if (b == '\n') {
-							hcc_atagen_advance_newline(w);
-						} else {
+						uint32_t code_idx = w->atagen.location.code_end_idx;
+						hcc_atagen_advance_over_code(w, hcc_bytes_find(&w->atagen.code[code_idx], w->atagen.code_size - code_idx, '*'));
+						if (w->atagen.location.code_end_idx == w->atagen.code_size) {
+							break;
+						}
+
+						hcc_atagen_advance_column(w, 1);
+						if (w->atagen.code[w->atagen.location.code_end_idx] == '/') { // no need to check in bounds see _HCC_TOKENIZER_LOOK_HEAD_SIZE
 							hcc_atagen_advance_column(w, 1);
-							if (b == '*') {
-								b = w->atagen.code[w->atagen.location.code_end_idx];
-								if (b == '/') { // no need to check in bounds see _HCC_TOKENIZER_LOOK_HEAD_SIZE
-									hcc_atagen_advance_column(w, 1);
-									break;
-								}
-							}
+							break;
 						}
 					}
 
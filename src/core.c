@@ -244,6 +244,30 @@ HccString hcc_path_canonicalize(const char* path) {
 	return new_path;
 }
 
+HccString hcc_path_canonicalize_deduplicate(const char* path) {
+	char buf[PATH_MAX];
+	uint32_t size = _hcc_gs.path_canonicalize_fn(path, buf);
+	if (size == 0) {
+		return hcc_string(NULL, 0);
+	}
+	return hcc_path_deduplicate(buf, size);
+}
+
+HccString hcc_path_deduplicate(const char* path, uint32_t path_size) {
+	char buf[PATH_MAX];
+	if (path_size >= sizeof(buf)) {
+		return hcc_string(NULL, 0);
+	}
+	memcpy(buf, path, path_size);
+	buf[path_size] = '\0';
+
+	//
+	// the null terminator is stored in the string table so the path can be passed to the OS
+	HccStringId path_string_id;
+	hcc_string_table_deduplicate(buf, path_size + 1, &path_string_id);
+	return hcc_string(hcc_string_table_get(path_string_id).data, path_size);
+}
+
 bool hcc_path_is_absolute(const char* path) {
 #ifdef __unix__
 	return path[0] == '/';
@@ -279,6 +303,12 @@ char* hcc_file_read_all_the_codes(const char* path, uint64_t* size_out) {
 		if (bytes_read == (ssize_t)-1) {
 			hcc_bail(HCC_ERROR_FILE_READ, errno);
 		}
+		if (bytes_read == 0) {
+			//
+			// the file has shrunk since we got the size, the rest of the bytes are still zeroed.
+			*size_out = offset;
+			break;
+		}
 		offset += bytes_read;
 		remaining_read_size -= bytes_read;
 	}
@@ -399,6 +429,29 @@ bool hcc_file_open_write(const char* path, HccIIO* out) {
 	return true;
 }
 
+bool hcc_file_stat(const char* path, HccFileStat* out) {
+#ifdef HCC_OS_LINUX
+	struct stat s;
+	if (stat(path, &s) != 0 || !S_ISREG(s.st_mode)) {
+		return false;
+	}
+	out->modified_time = (HccTime) { .secs = s.st_mtim.tv_sec, .nanosecs = s.st_mtim.tv_nsec };
+	out->size = s.st_size;
+#elif defined(HCC_OS_WINDOWS)
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data) || (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+		return false;
+	}
+	uint64_t wintime = ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+	wintime -= 116444736000000000ll;  //1jan1601 to 1jan1970
+	out->modified_time = (HccTime) { .secs = wintime / 10000000ll, .nanosecs = wintime % 10000000ll * 100 };
+	out->size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+#else
+#error "unimplemented for this platform"
+#endif
+	return true;
+}
+
 bool hcc_path_is_relative(const char* path) {
 	return !hcc_path_is_absolute(path);
 }
@@ -443,6 +496,27 @@ bool hcc_path_is_directory(const char* path) {
 #endif
 }
 
+bool hcc_directory_modified_time(const char* path, HccTime* out) {
+#ifdef HCC_OS_LINUX
+	struct stat s;
+	if (stat(path, &s) != 0 || !S_ISDIR(s.st_mode)) {
+		return false;
+	}
+	*out = (HccTime) { .secs = s.st_mtim.tv_sec, .nanosecs = s.st_mtim.tv_nsec };
+#elif defined(HCC_OS_WINDOWS)
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data) || !(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+		return false;
+	}
+	uint64_t wintime = ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+	wintime -= 116444736000000000ll;  //1jan1601 to 1jan1970
+	*out = (HccTime) { .secs = wintime / 10000000ll, .nanosecs = wintime % 10000000ll * 100 };
+#else
+#error "unimplemented for this platform"
+#endif
+	return true;
+}
+
 bool hcc_make_directory(const char* path) {
 #ifdef HCC_OS_LINUX
 	if (mkdir(path, 0777) != 0) {
@@ -458,6 +532,48 @@ bool hcc_make_directory(const char* path) {
 	return true;
 }
 
+bool hcc_path_rename(const char* src_path, const char* dst_path) {
+#ifdef HCC_OS_LINUX
+	//
+	// the rename is atomic, so other processes see the old file or the new file and never a partially written file.
+	if (rename(src_path, dst_path) != 0) {
+		return false;
+	}
+#elif defined(HCC_OS_WINDOWS)
+	if (!MoveFileExA(src_path, dst_path, MOVEFILE_REPLACE_EXISTING)) {
+		return false;
+	}
+#else
+#error "unimplemented for this platform"
+#endif
+	return true;
+}
+
+bool hcc_path_remove(const char* path) {
+#ifdef HCC_OS_LINUX
+	if (unlink(path) != 0) {
+		return false;
+	}
+#elif defined(HCC_OS_WINDOWS)
+	if (!DeleteFileA(path)) {
+		return false;
+	}
+#else
+#error "unimplemented for this platform"
+#endif
+	return true;
+}
+
+uint32_t hcc_process_id(void) {
+#ifdef HCC_OS_LINUX
+	return getpid();
+#elif defined(HCC_OS_WINDOWS)
+	return GetCurrentProcessId();
+#else
+#error "unimplemented for this platform"
+#endif
+}
+
 HccString hcc_path_replace_file_name(HccString parent, HccString file_name) {
 	uint32_t parent_copy_size = parent.size;
 	while (parent_copy_size) {
@@ -489,6 +605,61 @@ uint32_t hcc_logical_cores_count(void) {
 #endif
 }
 
+uint32_t hcc_available_logical_cores(uint32_t* core_indices_out, uint32_t core_indices_cap) {
+	uint32_t cores_count = 0;
+#ifdef HCC_OS_LINUX
+	//
+	// a cpu_set_t only has room for 1024 cores, so allocate a set that fits all of the cores this machine has
+	uint32_t configured_cores_count = get_nprocs_conf();
+	cpu_set_t* cpu_set = CPU_ALLOC(configured_cores_count);
+	size_t cpu_set_size = CPU_ALLOC_SIZE(configured_cores_count);
+	if (cpu_set && sched_getaffinity(0, cpu_set_size, cpu_set) == 0) {
+		for (uint32_t core_idx = 0; core_idx < configured_cores_count; core_idx += 1) {
+			if (CPU_ISSET_S(core_idx, cpu_set_size, cpu_set)) {
+				if (cores_count < core_indices_cap) {
+					core_indices_out[cores_count] = core_idx;
+				}
+				cores_count += 1;
+			}
+		}
+	}
+	CPU_FREE(cpu_set);
+#elif defined(HCC_OS_WINDOWS)
+	//
+	// the process affinity mask only covers a single processor group,
+	// so when there is more than one of them all of the cores are used. see hcc_thread_start for how they are numbered.
+	DWORD_PTR process_mask;
+	DWORD_PTR system_mask;
+	if (GetActiveProcessorGroupCount() == 1 && GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+		for (uint32_t core_idx = 0; core_idx < sizeof(process_mask) * 8; core_idx += 1) {
+			if (process_mask & ((DWORD_PTR)1 << core_idx)) {
+				if (cores_count < core_indices_cap) {
+					core_indices_out[cores_count] = core_idx;
+				}
+				cores_count += 1;
+			}
+		}
+	}
+#else
+#error "unimplemented on platform"
+#endif
+
+	//
+	// fall back to all of the cores when the affinity of the process cannot be found
+	if (cores_count == 0) {
+		cores_count = hcc_logical_cores_count();
+		for (uint32_t core_idx = 0; core_idx < HCC_MIN(cores_count, core_indices_cap); core_idx += 1) {
+			core_indices_out[core_idx] = core_idx;
+		}
+	}
+
+	return cores_count;
+}
+
+uint32_t hcc_available_logical_cores_count(void) {
+	return hcc_available_logical_cores(NULL, 0);
+}
+
 int hcc_execute_shell_command(const char* shell_command) {
 	return system(shell_command);
 }
@@ -686,6 +857,25 @@ void hcc_thread_start(HccThread* thread, HccThreadSetup* setup) {
 	}
 #endif
 
+	//
+	// pin the thread before it starts, so the pages it touches first are placed by the operating system while it runs on that core
+	if (setup->core_idx_plus_one) {
+		uint32_t core_idx = setup->core_idx_plus_one - 1;
+		cpu_set_t* cpu_set = CPU_ALLOC(core_idx + 1);
+		if (cpu_set == NULL) {
+			hcc_bail(HCC_ERROR_THREAD_INIT, ENOMEM);
+		}
+		size_t cpu_set_size = CPU_ALLOC_SIZE(core_idx + 1);
+		CPU_ZERO_S(cpu_set_size, cpu_set);
+		CPU_SET_S(core_idx, cpu_set_size, cpu_set);
+
+		res = pthread_attr_setaffinity_np(&attr, cpu_set_size, cpu_set);
+		CPU_FREE(cpu_set);
+		if (res) {
+			hcc_bail(HCC_ERROR_THREAD_INIT, res);
+		}
+	}
+
 	if ((res = pthread_create(&thread->handle, &attr, (void*(*)(void*))setup->thread_main_fn, setup->arg))) {
 		hcc_bail(HCC_ERROR_THREAD_INIT, res);
 	}
@@ -700,12 +890,35 @@ void hcc_thread_start(HccThread* thread, HccThreadSetup* setup) {
 		0,                                      // use default stack size
 		(DWORD(HCC_STDCALL *)(void*))setup->thread_main_fn, // thread function name
 		setup->arg,                             // argument to thread function
-		0,                                      // use default creation flags
+		CREATE_SUSPENDED,                       // resumed after the affinity is set
 		&thread_id);                            // returns the thread identifier
 
 	if (thread->handle == NULL) {
 		hcc_bail(HCC_ERROR_THREAD_INIT, GetLastError());
 	}
+
+	if (setup->core_idx_plus_one) {
+		//
+		// the cores are numbered through each of the processor groups in order
+		uint32_t core_idx = setup->core_idx_plus_one - 1;
+		WORD group = 0;
+		WORD groups_count = GetActiveProcessorGroupCount();
+		while (group + 1 < groups_count && core_idx >= GetActiveProcessorCount(group)) {
+			core_idx -= GetActiveProcessorCount(group);
+			group += 1;
+		}
+
+		GROUP_AFFINITY group_affinity = {0};
+		group_affinity.Group = group;
+		group_affinity.Mask = (KAFFINITY)1 << core_idx;
+		if (!SetThreadGroupAffinity(thread->handle, &group_affinity, NULL)) {
+			hcc_bail(HCC_ERROR_THREAD_INIT, GetLastError());
+		}
+	}
+
+	if (ResumeThread(thread->handle) == (DWORD)-1) {
+		hcc_bail(HCC_ERROR_THREAD_INIT, GetLastError());
+	}
 #else
 #error "unimplemented API for this platform"
 #endif // HCC_OS_LINUX
@@ -732,41 +945,43 @@ void hcc_thread_wait_for_termination(HccThread* thread) {
 //
 // ===========================================
 
-void hcc_semaphore_init(HccSemaphore* semaphore, uint32_t initial_value) {
-	atomic_store(&semaphore->value, initial_value);
-}
-
-void hcc_semaphore_set(HccSemaphore* semaphore, uint32_t value) {
-	atomic_store(&semaphore->value, value);
-	if (value) {
-#ifdef HCC_OS_LINUX
-		uint32_t wake_count = 1;
-		long res = syscall(SYS_futex, &semaphore->value, FUTEX_WAKE, wake_count, NULL, NULL, 0);
-		if (res == -1) {
-			hcc_bail(HCC_ERROR_SEMAPHORE_GIVE, errno);
+//
+// the number of times a thread checks the semaphore/mutex again before it goes to sleep in the kernel.
+// most AMLOPT and BACKENDGEN jobs only take a few microseconds, so a worker that has just run out of work
+// will usually get a new one in this time and does not have to pay for a sleep and wake up round trip.
+// there is no point spinning when there is only one core, as the thread we are waiting on cannot run until we sleep.
+#define HCC_SEMAPHORE_SPIN_COUNT 256
+#define HCC_MUTEX_SPIN_COUNT 128
+#define HCC_SPIN_COUNT(count) (_hcc_gs.logical_cores_count > 1 ? (count) : 0)
+
+static bool hcc_semaphore_try_take(HccSemaphore* semaphore) {
+	uint32_t counter = atomic_load(&semaphore->value);
+	while (counter) {
+		uint32_t next_counter = counter - 1;
+		if (atomic_compare_exchange_weak(&semaphore->value, &counter, next_counter)) {
+			return true;
 		}
-#elif defined(HCC_OS_WINDOWS)
-		WakeByAddressSingle(&semaphore->value);
-#else
-#error "unimplemented API for this platform"
-#endif // HCC_OS_LINUX
 	}
+	return false;
 }
 
-void hcc_semaphore_give(HccSemaphore* semaphore, uint32_t count) {
-	if (count == 0) {
+static void hcc_semaphore_wake(HccSemaphore* semaphore, uint32_t count) {
+	//
+	// only go into the kernel when there is a thread sleeping on the semaphore, and only wake up as many as there are new values.
+	// the sleepers count is incremented before a thread checks the value in the kernel, so a sleeper cannot be missed here.
+	uint32_t sleepers_count = atomic_load(&semaphore->sleepers_count);
+	if (sleepers_count == 0) {
 		return;
 	}
 
-	atomic_fetch_add(&semaphore->value, count);
+	uint32_t wake_count = HCC_MIN(count, sleepers_count);
 #ifdef HCC_OS_LINUX
-	uint32_t wake_count = count;
-	long res = syscall(SYS_futex, &semaphore->value, FUTEX_WAKE, wake_count, NULL, NULL, 0);
+	long res = syscall(SYS_futex, &semaphore->value, FUTEX_WAKE_PRIVATE, wake_count, NULL, NULL, 0);
 	if (res == -1) {
 		hcc_bail(HCC_ERROR_SEMAPHORE_GIVE, errno);
 	}
 #elif defined(HCC_OS_WINDOWS)
-	if (count > 1) {
+	if (wake_count > 1) {
 		WakeByAddressAll(&semaphore->value);
 	} else {
 		WakeByAddressSingle(&semaphore->value);
@@ -776,42 +991,58 @@ void hcc_semaphore_give(HccSemaphore* semaphore, uint32_t count) {
 #endif // HCC_OS_LINUX
 }
 
+void hcc_semaphore_init(HccSemaphore* semaphore, uint32_t initial_value) {
+	atomic_store(&semaphore->value, initial_value);
+	atomic_store(&semaphore->waiters_count, 0);
+	atomic_store(&semaphore->sleepers_count, 0);
+}
+
+void hcc_semaphore_set(HccSemaphore* semaphore, uint32_t value) {
+	atomic_store(&semaphore->value, value);
+	if (value) {
+		hcc_semaphore_wake(semaphore, 1);
+	}
+}
+
+void hcc_semaphore_give(HccSemaphore* semaphore, uint32_t count) {
+	if (count == 0) {
+		return;
+	}
+
+	atomic_fetch_add(&semaphore->value, count);
+	hcc_semaphore_wake(semaphore, count);
+}
+
 void hcc_semaphore_take_or_wait_then_take(HccSemaphore* semaphore) {
 	atomic_fetch_add(&semaphore->waiters_count, 1);
-#ifdef HCC_OS_LINUX
-	while (1) {
-		uint32_t counter = atomic_load(&semaphore->value);
-		while (counter) {
-			uint32_t next_counter = counter - 1;
-			if (atomic_compare_exchange_weak(&semaphore->value, &counter, next_counter)) {
-				goto RETURN;
-			}
+
+	//
+	// spin for a short while first, the value is likely to be given soon
+	for (uint32_t spin_idx = 0; spin_idx < HCC_SPIN_COUNT(HCC_SEMAPHORE_SPIN_COUNT); spin_idx += 1) {
+		if (hcc_semaphore_try_take(semaphore)) {
+			goto RETURN;
 		}
+		HCC_CPU_RELAX();
+	}
 
+	while (!hcc_semaphore_try_take(semaphore)) {
+		atomic_fetch_add(&semaphore->sleepers_count, 1);
 		uint32_t expected_value = 0;
-		long res = syscall(SYS_futex, &semaphore->value, FUTEX_WAIT, expected_value, NULL, NULL, 0);
-		if (res == -1 && errno != EAGAIN) {
+#ifdef HCC_OS_LINUX
+		long res = syscall(SYS_futex, &semaphore->value, FUTEX_WAIT_PRIVATE, expected_value, NULL, NULL, 0);
+		if (res == -1 && errno != EAGAIN && errno != EINTR) {
 			hcc_bail(HCC_ERROR_SEMAPHORE_TAKE, errno);
 		}
-	}
 #elif defined(HCC_OS_WINDOWS)
-	while (1) {
-		uint32_t counter = atomic_load(&semaphore->value);
-		while (counter) {
-			uint32_t next_counter = counter - 1;
-			if (atomic_compare_exchange_weak(&semaphore->value, &counter, next_counter)) {
-				goto RETURN;
-			}
-		}
-
-		uint32_t expected_value = 0;
 		if (!WaitOnAddress(&semaphore->value, &expected_value, sizeof(expected_value), INFINITE)) {
 			hcc_bail(HCC_ERROR_SEMAPHORE_TAKE, GetLastError());
 		}
-	}
 #else
 #error "unimplemented API for this platform"
 #endif // HCC_OS_LINUX
+		atomic_fetch_sub(&semaphore->sleepers_count, 1);
+	}
+
 RETURN:
 	atomic_fetch_sub(&semaphore->waiters_count, 1);
 }
@@ -859,58 +1090,59 @@ void hcc_spin_mutex_unlock(HccSpinMutex* mutex) {
 // ===========================================
 
 void hcc_mutex_init(HccMutex* mutex) {
-	atomic_store(&mutex->is_locked, false);
+	atomic_store(&mutex->state, HCC_MUTEX_STATE_UNLOCKED);
 }
 
 bool hcc_mutex_is_locked(HccMutex* mutex) {
-	return atomic_load(&mutex->is_locked);
+	return atomic_load(&mutex->state) != HCC_MUTEX_STATE_UNLOCKED;
 }
 
 void hcc_mutex_lock(HccMutex* mutex) {
-#ifdef HCC_OS_LINUX
-	while (1) {
-		uint32_t is_locked = atomic_load(&mutex->is_locked);
-		while (!is_locked) {
-			if (atomic_compare_exchange_weak(&mutex->is_locked, &is_locked, true)) {
-				return;
-			}
+	//
+	// spin for a short while first, most of the time the mutex is only held for a moment
+	for (uint32_t spin_idx = 0; spin_idx < HCC_SPIN_COUNT(HCC_MUTEX_SPIN_COUNT); spin_idx += 1) {
+		uint32_t state = HCC_MUTEX_STATE_UNLOCKED;
+		if (atomic_compare_exchange_weak(&mutex->state, &state, HCC_MUTEX_STATE_LOCKED)) {
+			return;
 		}
+		HCC_CPU_RELAX();
+	}
 
-		uint32_t expected_value = true;
-		long res = syscall(SYS_futex, &mutex->is_locked, FUTEX_WAIT, expected_value, NULL, NULL, 0);
-		if (res == -1 && errno != EAGAIN) {
+	//
+	// mark the mutex as having sleepers so the unlock knows it has to wake one of us up.
+	// if it was unlocked in the meantime then we now hold the lock, but we may not be the last sleeper so leave it marked.
+	while (atomic_exchange(&mutex->state, HCC_MUTEX_STATE_LOCKED_WITH_SLEEPERS) != HCC_MUTEX_STATE_UNLOCKED) {
+		uint32_t expected_value = HCC_MUTEX_STATE_LOCKED_WITH_SLEEPERS;
+#ifdef HCC_OS_LINUX
+		long res = syscall(SYS_futex, &mutex->state, FUTEX_WAIT_PRIVATE, expected_value, NULL, NULL, 0);
+		if (res == -1 && errno != EAGAIN && errno != EINTR) {
 			hcc_bail(HCC_ERROR_MUTEX_LOCK, errno);
 		}
-	}
 #elif defined(HCC_OS_WINDOWS)
-	while (1) {
-		uint32_t is_locked = atomic_load(&mutex->is_locked);
-		while (!is_locked) {
-			if (atomic_compare_exchange_weak(&mutex->is_locked, &is_locked, true)) {
-				return;
-			}
-		}
-
-		uint32_t expected_value = true;
-		if (!WaitOnAddress(&mutex->is_locked, &expected_value, sizeof(expected_value), INFINITE)) {
+		if (!WaitOnAddress(&mutex->state, &expected_value, sizeof(expected_value), INFINITE)) {
 			hcc_bail(HCC_ERROR_MUTEX_LOCK, GetLastError());
 		}
-	}
 #else
 #error "unimplemented API for this platform"
 #endif // HCC_OS_LINUX
+	}
 }
 
 void hcc_mutex_unlock(HccMutex* mutex) {
-	atomic_store(&mutex->is_locked, false);
+	if (atomic_exchange(&mutex->state, HCC_MUTEX_STATE_UNLOCKED) != HCC_MUTEX_STATE_LOCKED_WITH_SLEEPERS) {
+		//
+		// nobody is sleeping on the mutex, so there is no need to go into the kernel
+		return;
+	}
+
 #ifdef HCC_OS_LINUX
 	uint32_t wake_count = 1;
-	long res = syscall(SYS_futex, &mutex->is_locked, FUTEX_WAKE, wake_count, NULL, NULL, 0);
+	long res = syscall(SYS_futex, &mutex->state, FUTEX_WAKE_PRIVATE, wake_count, NULL, NULL, 0);
 	if (res == -1) {
 		hcc_bail(HCC_ERROR_MUTEX_UNLOCK, errno);
 	}
 #elif defined(HCC_OS_WINDOWS)
-	WakeByAddressSingle(&mutex->is_locked);
+	WakeByAddressSingle(&mutex->state);
 #else
 #error "unimplemented API for this platform"
 #endif // HCC_OS_LINUX
@@ -925,44 +1157,345 @@ void hcc_mutex_unlock(HccMutex* mutex) {
 // ===========================================
 
 const char* hcc_alloc_tag_strings[HCC_ALLOC_TAG_COUNT] = {
-	[HCC_ALLOC_TAG_NONE] = "NONE",
-	[HCC_ALLOC_TAG_CODE] = "CODE",
+	[HCC_ALLOC_TAG_NONE]                                            = "NONE",
+	[HCC_ALLOC_TAG_GLOBAL_MEM_ARENA]                                = "GLOBAL_MEM_ARENA",
+	[HCC_ALLOC_TAG_CODE]                                            = "CODE",
+	[HCC_ALLOC_TAG_MEM_TRACKER]                                     = "MEM_TRACKER",
+	[HCC_ALLOC_TAG_VIRT_MEM_PREFAULTER]                             = "VIRT_MEM_PREFAULTER",
+	[HCC_ALLOC_TAG_STRING_TABLE_ENTRIES]                            = "STRING_TABLE_ENTRIES",
+	[HCC_ALLOC_TAG_STRING_TABLE_DATA]                               = "STRING_TABLE_DATA",
+	[HCC_ALLOC_TAG_STRING_TABLE_ID_TO_ENTRY_MAP]                    = "STRING_TABLE_ID_TO_ENTRY_MAP",
+	[HCC_ALLOC_TAG_WORKERS]                                         = "WORKERS",
+	[HCC_ALLOC_TAG_WORKER_CALL_STACKS]                              = "WORKER_CALL_STACKS",
+	[HCC_ALLOC_TAG_WORKER_JOB_QUEUE]                                = "WORKER_JOB_QUEUE",
+	[HCC_ALLOC_TAG_ATA_TEXT]                                        = "ATA_TEXT",
+	[HCC_ALLOC_TAG_ATA_BINARY]                                      = "ATA_BINARY",
+	[HCC_ALLOC_TAG_ATA]                                             = "ATA",
+	[HCC_ALLOC_TAG_AST_TEXT]                                        = "AST_TEXT",
+	[HCC_ALLOC_TAG_AST_BINARY]                                      = "AST_BINARY",
+	[HCC_ALLOC_TAG_AST]                                             = "AST",
+	[HCC_ALLOC_TAG_AML_TEXT]                                        = "AML_TEXT",
+	[HCC_ALLOC_TAG_AML_BINARY]                                      = "AML_BINARY",
+	[HCC_ALLOC_TAG_AML]                                             = "AML",
+	[HCC_ALLOC_TAG_WORKER_STRING_BUFFER]                            = "WORKER_STRING_BUFFER",
+	[HCC_ALLOC_TAG_WORKER_ARENA]                                    = "WORKER_ARENA",
+	[HCC_ALLOC_TAG_OPTION_DEFINES]                                  = "OPTION_DEFINES",
+	[HCC_ALLOC_TAG_TASK_INCLUDE_PATH_STRINGS]                       = "TASK_INCLUDE_PATH_STRINGS",
+	[HCC_ALLOC_TAG_MESSAGE_SYS_ELMTS]                               = "MESSAGE_SYS_ELMTS",
+	[HCC_ALLOC_TAG_MESSAGE_SYS_LOCATIONS]                           = "MESSAGE_SYS_LOCATIONS",
+	[HCC_ALLOC_TAG_MESSAGE_SYS_STRINGS]                             = "MESSAGE_SYS_STRINGS",
+	[HCC_ALLOC_TAG_PATH_TO_CODE_FILE_MAP]                           = "PATH_TO_CODE_FILE_MAP",
+	[HCC_ALLOC_TAG_INCLUDE_RESOLVE_CACHE]                           = "INCLUDE_RESOLVE_CACHE",
+	[HCC_ALLOC_TAG_INCLUDE_RESOLVE_DIRS]                            = "INCLUDE_RESOLVE_DIRS",
+	[HCC_ALLOC_TAG_CODE_FILE_LINE_CODE_START_INDICES]               = "CODE_FILE_LINE_CODE_START_INDICES",
+	[HCC_ALLOC_TAG_CODE_FILE_PP_IF_SPANS]                           = "CODE_FILE_PP_IF_SPANS",
+	[HCC_ALLOC_TAG_CONSTANT_TABLE_ENTRIES]                          = "CONSTANT_TABLE_ENTRIES",
+	[HCC_ALLOC_TAG_CONSTANT_TABLE_DATA]                             = "CONSTANT_TABLE_DATA",
+	[HCC_ALLOC_TAG_CU_SHADER_FUNCTION_DECLS]                        = "CU_SHADER_FUNCTION_DECLS",
+	[HCC_ALLOC_TAG_CU_RESOURCE_STRUCTS]                             = "CU_RESOURCE_STRUCTS",
+	[HCC_ALLOC_TAG_CU_GLOBAL_DECLARATIONS]                          = "CU_GLOBAL_DECLARATIONS",
+	[HCC_ALLOC_TAG_CU_STRUCT_DECLARATIONS]                          = "CU_STRUCT_DECLARATIONS",
+	[HCC_ALLOC_TAG_CU_UNION_DECLARATIONS]                           = "CU_UNION_DECLARATIONS",
+	[HCC_ALLOC_TAG_CU_ENUM_DECLARATIONS]                            = "CU_ENUM_DECLARATIONS",
+	[HCC_ALLOC_TAG_CU_WORKER_STACK_CHUNKS]                          = "CU_WORKER_STACK_CHUNKS",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_ARRAYS]                          = "DATA_TYPE_TABLE_ARRAYS",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_COMPOUNDS]                       = "DATA_TYPE_TABLE_COMPOUNDS",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_COMPOUND_FIELDS]                 = "DATA_TYPE_TABLE_COMPOUND_FIELDS",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_TYPEDEFS]                        = "DATA_TYPE_TABLE_TYPEDEFS",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_ENUMS]                           = "DATA_TYPE_TABLE_ENUMS",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_ENUM_VALUES]                     = "DATA_TYPE_TABLE_ENUM_VALUES",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_POINTERS]                        = "DATA_TYPE_TABLE_POINTERS",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_FUNCTIONS]                       = "DATA_TYPE_TABLE_FUNCTIONS",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_FUNCTION_PARAMS]                 = "DATA_TYPE_TABLE_FUNCTION_PARAMS",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_BUFFERS]                         = "DATA_TYPE_TABLE_BUFFERS",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_ARRAYS_DEDUP_HASH_TABLE]         = "DATA_TYPE_TABLE_ARRAYS_DEDUP_HASH_TABLE",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_POINTERS_DEDUP_HASH_TABLE]       = "DATA_TYPE_TABLE_POINTERS_DEDUP_HASH_TABLE",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_FUNCTIONS_DEDUP_HASH_TABLE]      = "DATA_TYPE_TABLE_FUNCTIONS_DEDUP_HASH_TABLE",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_BUFFERS_DEDUP_HASH_TABLE]        = "DATA_TYPE_TABLE_BUFFERS_DEDUP_HASH_TABLE",
+	[HCC_ALLOC_TAG_DATA_TYPE_TABLE_ANON_COMPOUND_DEDUP_HASH_TABLE]  = "DATA_TYPE_TABLE_ANON_COMPOUND_DEDUP_HASH_TABLE",
+	[HCC_ALLOC_TAG_ATA_TOKEN_BAG_TOKENS]                            = "ATA_TOKEN_BAG_TOKENS",
+	[HCC_ALLOC_TAG_ATA_TOKEN_BAG_LOCATIONS]                         = "ATA_TOKEN_BAG_LOCATIONS",
+	[HCC_ALLOC_TAG_ATA_TOKEN_BAG_VALUES]                            = "ATA_TOKEN_BAG_VALUES",
+	[HCC_ALLOC_TAG_AST_FILE_MACROS]                                 = "AST_FILE_MACROS",
+	[HCC_ALLOC_TAG_AST_FILE_MACRO_PARAMS]                           = "AST_FILE_MACRO_PARAMS",
+	[HCC_ALLOC_TAG_AST_FILE_PRAGMA_ONCED_FILES]                     = "AST_FILE_PRAGMA_ONCED_FILES",
+	[HCC_ALLOC_TAG_AST_FILE_UNIQUE_INCLUDED_FILES]                  = "AST_FILE_UNIQUE_INCLUDED_FILES",
+	[HCC_ALLOC_TAG_AST_FORWARD_DECLARTIONS_TO_LINK]                 = "AST_FORWARD_DECLARTIONS_TO_LINK",
+	[HCC_ALLOC_TAG_AST_FILE_INCLUDE_EFFECTS]                        = "AST_FILE_INCLUDE_EFFECTS",
+	[HCC_ALLOC_TAG_AST_FILE_GLOBAL_DECLARATIONS]                    = "AST_FILE_GLOBAL_DECLARATIONS",
+	[HCC_ALLOC_TAG_AST_FILE_STRUCT_DECLARATIONS]                    = "AST_FILE_STRUCT_DECLARATIONS",
+	[HCC_ALLOC_TAG_AST_FILE_UNION_DECLARATIONS]                     = "AST_FILE_UNION_DECLARATIONS",
+	[HCC_ALLOC_TAG_AST_FILE_ENUM_DECLARATIONS]                      = "AST_FILE_ENUM_DECLARATIONS",
+	[HCC_ALLOC_TAG_AST_FILES_HASH_TABLE]                            = "AST_FILES_HASH_TABLE",
+	[HCC_ALLOC_TAG_AST_FILES]                                       = "AST_FILES",
+	[HCC_ALLOC_TAG_AST_FUNCTION_PARAMS_AND_VARIABLES]               = "AST_FUNCTION_PARAMS_AND_VARIABLES",
+	[HCC_ALLOC_TAG_AST_FUNCTIONS]                                   = "AST_FUNCTIONS",
+	[HCC_ALLOC_TAG_AST_EXPRS]                                       = "AST_EXPRS",
+	[HCC_ALLOC_TAG_AST_GLOBAL_VARIBALES]                            = "AST_GLOBAL_VARIBALES",
+	[HCC_ALLOC_TAG_AST_FORWARD_DECLARTIONS]                         = "AST_FORWARD_DECLARTIONS",
+	[HCC_ALLOC_TAG_AST_DESIGNATED_INITIALIZER_ELMT_INDICES]         = "AST_DESIGNATED_INITIALIZER_ELMT_INDICES",
+	[HCC_ALLOC_TAG_AST_FUNCTION_CALLEES]                            = "AST_FUNCTION_CALLEES",
+	[HCC_ALLOC_TAG_AST_REACHABLE_FUNCTION_DECLS]                    = "AST_REACHABLE_FUNCTION_DECLS",
+	[HCC_ALLOC_TAG_AST_UNLINKED_REACHABLE_FUNCTION_DECLS]           = "AST_UNLINKED_REACHABLE_FUNCTION_DECLS",
+	[HCC_ALLOC_TAG_AST_INCLUDE_CACHE]                               = "AST_INCLUDE_CACHE",
+	[HCC_ALLOC_TAG_AML_FUNCTION_ALCTOR_NODES_POOL]                  = "AML_FUNCTION_ALCTOR_NODES_POOL",
+	[HCC_ALLOC_TAG_AML_FUNCTION_ALCTOR_WORDS_POOL]                  = "AML_FUNCTION_ALCTOR_WORDS_POOL",
+	[HCC_ALLOC_TAG_AML_FUNCTION_ALCTOR_VALUES_POOL]                 = "AML_FUNCTION_ALCTOR_VALUES_POOL",
+	[HCC_ALLOC_TAG_AML_FUNCTION_ALCTOR_BASIC_BLOCKS_POOL]           = "AML_FUNCTION_ALCTOR_BASIC_BLOCKS_POOL",
+	[HCC_ALLOC_TAG_AML_FUNCTION_ALCTOR_BASIC_BLOCK_PARAMS_POOL]     = "AML_FUNCTION_ALCTOR_BASIC_BLOCK_PARAMS_POOL",
+	[HCC_ALLOC_TAG_AML_FUNCTION_ALCTOR_BASIC_BLOCK_PARAM_SRCS_POOL] = "AML_FUNCTION_ALCTOR_BASIC_BLOCK_PARAM_SRCS_POOL",
+	[HCC_ALLOC_TAG_AML_FUNCTIONS]                                   = "AML_FUNCTIONS",
+	[HCC_ALLOC_TAG_AML_LOCATIONS]                                   = "AML_LOCATIONS",
+	[HCC_ALLOC_TAG_AML_CALL_GRAPH_NODES]                            = "AML_CALL_GRAPH_NODES",
+	[HCC_ALLOC_TAG_AML_OPIMIZE_FUNCTIONS]                           = "AML_OPIMIZE_FUNCTIONS",
+	[HCC_ALLOC_TAG_AML_FUNCTION_CALL_NODE_LISTS]                    = "AML_FUNCTION_CALL_NODE_LISTS",
+	[HCC_ALLOC_TAG_AML_CALL_GRAPH_DEPS]                             = "AML_CALL_GRAPH_DEPS",
+	[HCC_ALLOC_TAG_AML_CALL_GRAPH_WAITING_NODES]                    = "AML_CALL_GRAPH_WAITING_NODES",
+	[HCC_ALLOC_TAG_AML_CALL_GRAPH_MADE_DECLS]                       = "AML_CALL_GRAPH_MADE_DECLS",
+	[HCC_ALLOC_TAG_SPIRV_FUNCTIONS]                                 = "SPIRV_FUNCTIONS",
+	[HCC_ALLOC_TAG_SPIRV_FUNCTION_WORDS]                            = "SPIRV_FUNCTION_WORDS",
+	[HCC_ALLOC_TAG_SPIRV_TYPE_TABLE]                                = "SPIRV_TYPE_TABLE",
+	[HCC_ALLOC_TAG_SPIRV_DECL_TABLE]                                = "SPIRV_DECL_TABLE",
+	[HCC_ALLOC_TAG_SPIRV_DESCRIPTOR_BINDING_TABLE]                  = "SPIRV_DESCRIPTOR_BINDING_TABLE",
+	[HCC_ALLOC_TAG_SPIRV_CONSTANT_TABLE]                            = "SPIRV_CONSTANT_TABLE",
+	[HCC_ALLOC_TAG_SPIRV_TYPES_AND_CONSTANTS]                       = "SPIRV_TYPES_AND_CONSTANTS",
+	[HCC_ALLOC_TAG_SPIRV_TYPE_ELMT_IDS]                             = "SPIRV_TYPE_ELMT_IDS",
+	[HCC_ALLOC_TAG_SPIRV_ENTRY_POINTS]                              = "SPIRV_ENTRY_POINTS",
+	[HCC_ALLOC_TAG_SPIRV_ENTRY_POINT_GLOBAL_VARIABLE_IDS]           = "SPIRV_ENTRY_POINT_GLOBAL_VARIABLE_IDS",
+	[HCC_ALLOC_TAG_SPIRV_GLOBAL_VARIABLE_WORDS]                     = "SPIRV_GLOBAL_VARIABLE_WORDS",
+	[HCC_ALLOC_TAG_SPIRV_NAME_WORDS]                                = "SPIRV_NAME_WORDS",
+	[HCC_ALLOC_TAG_SPIRV_DECORATE_WORDS]                            = "SPIRV_DECORATE_WORDS",
+	[HCC_ALLOC_TAG_PPGEN_EXPAND_STACK]                              = "PPGEN_EXPAND_STACK",
+	[HCC_ALLOC_TAG_PPGEN_EXPAND_MACRO_IDX_STACK]                    = "PPGEN_EXPAND_MACRO_IDX_STACK",
+	[HCC_ALLOC_TAG_PPGEN_STRINGIFY_BUFFER]                          = "PPGEN_STRINGIFY_BUFFER",
+	[HCC_ALLOC_TAG_PPGEN_IF_STACK]                                  = "PPGEN_IF_STACK",
+	[HCC_ALLOC_TAG_PPGEN_MACRO_DECLARATIONS]                        = "PPGEN_MACRO_DECLARATIONS",
+	[HCC_ALLOC_TAG_PPGEN_MACRO_ARGS_STACK]                          = "PPGEN_MACRO_ARGS_STACK",
+	[HCC_ALLOC_TAG_ATAGEN_PAUSED_FILE_STACK]                        = "ATAGEN_PAUSED_FILE_STACK",
+	[HCC_ALLOC_TAG_ATAGEN_OPEN_BRACKET_STACK]                       = "ATAGEN_OPEN_BRACKET_STACK",
+	[HCC_ALLOC_TAG_ATAGEN_INCLUDE_RECORDING_STACK]                  = "ATAGEN_INCLUDE_RECORDING_STACK",
+	[HCC_ALLOC_TAG_ASTGEN_VARIABLE_STACK_STRINGS]                   = "ASTGEN_VARIABLE_STACK_STRINGS",
+	[HCC_ALLOC_TAG_ASTGEN_VARIABLE_STACK]                           = "ASTGEN_VARIABLE_STACK",
+	[HCC_ALLOC_TAG_ASTGEN_COMPOUND_FIELD_NAMES]                     = "ASTGEN_COMPOUND_FIELD_NAMES",
+	[HCC_ALLOC_TAG_ASTGEN_COMPOUND_FIELD_LOCATIONS]                 = "ASTGEN_COMPOUND_FIELD_LOCATIONS",
+	[HCC_ALLOC_TAG_ASTGEN_COMPOUND_TYPE_FIND_FIELDS]                = "ASTGEN_COMPOUND_TYPE_FIND_FIELDS",
+	[HCC_ALLOC_TAG_ASTGEN_COMPOUND_FIELDS]                          = "ASTGEN_COMPOUND_FIELDS",
+	[HCC_ALLOC_TAG_ASTGEN_FUNCTION_PARAMS_AND_VARIABLES]            = "ASTGEN_FUNCTION_PARAMS_AND_VARIABLES",
+	[HCC_ALLOC_TAG_ASTGEN_ENUM_VALUES]                              = "ASTGEN_ENUM_VALUES",
+	[HCC_ALLOC_TAG_ASTGEN_FUNCTION_CALLEES]                         = "ASTGEN_FUNCTION_CALLEES",
+	[HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_NESTED]                 = "ASTGEN_CURLY_INITIALIZER_NESTED",
+	[HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_NESTED_CURLYS]          = "ASTGEN_CURLY_INITIALIZER_NESTED_CURLYS",
+	[HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_NESTED_ELMTS]           = "ASTGEN_CURLY_INITIALIZER_NESTED_ELMTS",
+	[HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_COMPOSITE_CONSTANT_IDS] = "ASTGEN_CURLY_INITIALIZER_COMPOSITE_CONSTANT_IDS",
+	[HCC_ALLOC_TAG_SPIRVLINK_WORDS]                                 = "SPIRVLINK_WORDS",
 };
 
-//
-// CONTRIBUTOR: we want track virtual memory reserves and releases so the user can
-// call a log and iterate over the allocated memory.
-//
-HCC_CONTRIBUTOR_TASK(memory tracking system)
-
 void hcc_mem_tracker_init(void) {
+	HccMemTracker* mt = &_hcc_gs.mem_tracker;
+	hcc_spin_mutex_init(&mt->mutex);
+
+	//
+	// the records are not set up yet so this reservation only makes it into the tag stats,
+	// so add the record for it by hand afterwards.
+	uintptr_t size = HCC_INT_ROUND_UP_ALIGN(HCC_MEM_TRACKER_RECORDS_CAP * sizeof(HccTrackedMem), _hcc_gs.virt_mem_reserve_align);
+	HccTrackedMem* records;
+	hcc_virt_mem_reserve_commit(HCC_ALLOC_TAG_MEM_TRACKER, NULL, size, HCC_VIRT_MEM_PROTECTION_READ_WRITE, (void**)&records);
+
+	hcc_spin_mutex_lock(&mt->mutex);
+	mt->records = records;
+	mt->records_cap = size / sizeof(HccTrackedMem);
+	mt->records_count = 1;
+	mt->records[0] = (HccTrackedMem) {
+		.tag = HCC_ALLOC_TAG_MEM_TRACKER,
+		.addr = records,
+		.size = size,
+		.committed_size = size,
+	};
+	hcc_spin_mutex_unlock(&mt->mutex);
 }
 
 void hcc_mem_tracker_deinit(void) {
+	HccMemTracker* mt = &_hcc_gs.mem_tracker;
+	if (mt->records) {
+		hcc_virt_mem_release(HCC_ALLOC_TAG_MEM_TRACKER, mt->records, HCC_INT_ROUND_UP_ALIGN(mt->records_cap * sizeof(HccTrackedMem), _hcc_gs.virt_mem_reserve_align));
+		mt->records = NULL;
+		mt->records_count = 0;
+		mt->records_cap = 0;
+	}
+}
+
+static uint32_t hcc_mem_tracker_record_search(HccMemTracker* mt, void* addr) {
+	//
+	// the records are sorted from the highest address to the lowest.
+	// the OS tends to hand out lower addresses for each new reservation, so new records usually go on the end.
+	// returns the index of the first record with an address less than or equal to addr.
+	uint32_t start_idx = 0;
+	uint32_t end_idx = mt->records_count;
+	while (start_idx < end_idx) {
+		uint32_t mid_idx = start_idx + (end_idx - start_idx) / 2;
+		if ((uintptr_t)mt->records[mid_idx].addr > (uintptr_t)addr) {
+			start_idx = mid_idx + 1;
+		} else {
+			end_idx = mid_idx;
+		}
+	}
+	return start_idx;
+}
+
+static void hcc_mem_tracker_tag_stats_change(HccMemTracker* mt, HccAllocTag tag, intptr_t reserved_size_change, intptr_t committed_size_change) {
+	HccMemTrackerTagStats* stats = &mt->tag_stats[tag];
+	stats->reserved_size += reserved_size_change;
+	stats->committed_size += committed_size_change;
+	stats->reserved_size_high_water_mark = HCC_MAX(stats->reserved_size_high_water_mark, stats->reserved_size);
+	stats->committed_size_high_water_mark = HCC_MAX(stats->committed_size_high_water_mark, stats->committed_size);
 }
 
 void hcc_mem_tracker_update(HccAllocMode mode, HccAllocTag tag, void* addr, uintptr_t size) {
+	HccMemTracker* mt = &_hcc_gs.mem_tracker;
+	hcc_spin_mutex_lock(&mt->mutex);
+
+	switch (mode) {
+		case HCC_ALLOC_MODE_ALLOC:
+			mt->tag_stats[tag].reservations_count += 1;
+			hcc_mem_tracker_tag_stats_change(mt, tag, size, 0);
+			if (mt->records_count < mt->records_cap) {
+				uint32_t idx = hcc_mem_tracker_record_search(mt, addr);
+				HCC_COPY_OVERLAP_ELMT_MANY(&mt->records[idx + 1], &mt->records[idx], (mt->records_count - idx));
+				mt->records[idx] = (HccTrackedMem) {
+					.tag = tag,
+					.addr = addr,
+					.size = size,
+					.committed_size = 0,
+				};
+				mt->records_count += 1;
+			} else if (mt->records) {
+				mt->untracked_count += 1;
+			}
+			break;
+		case HCC_ALLOC_MODE_DEALLOC: {
+			uintptr_t committed_size;
+			uint32_t idx = hcc_mem_tracker_record_search(mt, addr);
+			if (idx < mt->records_count && mt->records[idx].addr == addr) {
+				committed_size = mt->records[idx].committed_size;
+				HCC_COPY_OVERLAP_ELMT_MANY(&mt->records[idx], &mt->records[idx + 1], (mt->records_count - idx - 1));
+				mt->records_count -= 1;
+			} else {
+				//
+				// this reservation did not fit in the records, so we have to guess how much of it was committed
+				committed_size = HCC_MIN(size, mt->tag_stats[tag].committed_size);
+				if (mt->untracked_count) {
+					mt->untracked_count -= 1;
+				}
+			}
+			mt->tag_stats[tag].reservations_count -= 1;
+			hcc_mem_tracker_tag_stats_change(mt, tag, -(intptr_t)size, -(intptr_t)committed_size);
+			break;
+		};
+	}
+
+	hcc_spin_mutex_unlock(&mt->mutex);
+
 	if (_hcc_gs.alloc_event_fn) {
 		_hcc_gs.alloc_event_fn(_hcc_gs.alloc_event_userdata, mode, tag, addr, size);
 	}
 }
 
+void hcc_mem_tracker_update_committed(HccAllocTag tag, void* addr, uintptr_t size, bool is_commit) {
+	HccMemTracker* mt = &_hcc_gs.mem_tracker;
+	hcc_spin_mutex_lock(&mt->mutex);
+
+	intptr_t change = is_commit ? (intptr_t)size : -(intptr_t)size;
+	uint32_t idx = hcc_mem_tracker_record_search(mt, addr);
+	if (idx < mt->records_count && (uintptr_t)addr < (uintptr_t)mt->records[idx].addr + mt->records[idx].size) {
+		HccTrackedMem* record = &mt->records[idx];
+		if (!is_commit && size > record->committed_size) {
+			change = -(intptr_t)record->committed_size;
+		}
+		record->committed_size += change;
+	} else if (!is_commit) {
+		change = -(intptr_t)HCC_MIN(size, mt->tag_stats[tag].committed_size);
+	}
+	hcc_mem_tracker_tag_stats_change(mt, tag, 0, change);
+
+	hcc_spin_mutex_unlock(&mt->mutex);
+}
+
+void hcc_mem_tracker_tag_stats(HccAllocTag tag, HccMemTrackerTagStats* out) {
+	HccMemTracker* mt = &_hcc_gs.mem_tracker;
+	hcc_spin_mutex_lock(&mt->mutex);
+	*out = mt->tag_stats[tag];
+	hcc_spin_mutex_unlock(&mt->mutex);
+}
+
 HccMemTrackerIter* hcc_mem_tracker_iter_start(void) {
-	return NULL;
+	HccMemTracker* mt = &_hcc_gs.mem_tracker;
+	hcc_spin_mutex_lock(&mt->mutex);
+	mt->iter.next_idx = 0;
+	return &mt->iter;
 }
 
 void hcc_mem_tracker_iter_finish(HccMemTrackerIter* iter) {
 	HCC_UNUSED(iter);
+	hcc_spin_mutex_unlock(&_hcc_gs.mem_tracker.mutex);
 }
 
 bool hcc_mem_tracker_iter_next(HccMemTrackerIter* iter, HccTrackedMem* out) {
-	HCC_UNUSED(iter);
-	HCC_UNUSED(out);
+	HccMemTracker* mt = &_hcc_gs.mem_tracker;
+	if (iter->next_idx >= mt->records_count) {
+		return false;
+	}
+
+	*out = mt->records[iter->next_idx];
+	iter->next_idx += 1;
 	return true;
 }
 
 void hcc_mem_tracker_log(HccIIO* iio) {
-	HCC_UNUSED(iio);
+	HccMemTracker* mt = &_hcc_gs.mem_tracker;
+
+	//
+	// copy out the stats so the tracker is not locked while we write out to the iio
+	hcc_spin_mutex_lock(&mt->mutex);
+	HccMemTrackerTagStats tag_stats[HCC_ALLOC_TAG_COUNT];
+	HCC_COPY_ARRAY(tag_stats, mt->tag_stats);
+	uint32_t records_count = mt->records_count;
+	uint32_t untracked_count = mt->untracked_count;
+	hcc_spin_mutex_unlock(&mt->mutex);
+
+	HccMemTrackerTagStats total = {0};
+	hcc_iio_write_fmt(iio, "%-56s %8s %14s %14s %14s %14s\n", "TAG", "COUNT", "RESERVED KB", "COMMITTED KB", "PEAK RES KB", "PEAK COM KB");
+	for (HccAllocTag tag = 0; tag < HCC_ALLOC_TAG_COUNT; tag += 1) {
+		HccMemTrackerTagStats* stats = &tag_stats[tag];
+		if (stats->reserved_size_high_water_mark == 0) {
+			continue;
+		}
+
+		hcc_iio_write_fmt(
+			iio, "%-56s %8u %14zu %14zu %14zu %14zu\n",
+			hcc_alloc_tag_strings[tag], stats->reservations_count,
+			stats->reserved_size / 1024, stats->committed_size / 1024,
+			stats->reserved_size_high_water_mark / 1024, stats->committed_size_high_water_mark / 1024
+		);
+
+		total.reservations_count += stats->reservations_count;
+		total.reserved_size += stats->reserved_size;
+		total.committed_size += stats->committed_size;
+		total.reserved_size_high_water_mark += stats->reserved_size_high_water_mark;
+		total.committed_size_high_water_mark += stats->committed_size_high_water_mark;
+	}
+
+	//
+	// the total peaks are the sum of the peaks of each tag, they may not have all happened at the same time
+	hcc_iio_write_fmt(
+		iio, "%-56s %8u %14zu %14zu %14zu %14zu\n",
+		"TOTAL", total.reservations_count,
+		total.reserved_size / 1024, total.committed_size / 1024,
+		total.reserved_size_high_water_mark / 1024, total.committed_size_high_water_mark / 1024
+	);
+
+	if (untracked_count) {
+		hcc_iio_write_fmt(iio, "%u of the %u live reservations did not fit in the memory tracker records\n", untracked_count, records_count + untracked_count);
+	}
 }
 
 // ===========================================
@@ -983,20 +1516,63 @@ HccArenaHeader* hcc_arena_alloc(HccAllocTag tag, uint32_t arena_size) {
 	return arena;
 }
 
+//
+// when rolling back more than this many bytes of an arena, reset the virtual memory
+// instead of zeroing it so the pages are given back to the operating system.
+#define HCC_ARENA_RESET_MIN_SIZE (64 * 1024)
+
 void hcc_arena_alctor_init(HccArenaAlctor* alctor, HccAllocTag tag, uint32_t arena_size) {
 	HccArenaHeader* arena = hcc_arena_alloc(tag, arena_size);
 	alctor->arena = arena;
 	alctor->tag = tag;
+	alctor->free_arenas = NULL;
 }
 
 void hcc_arena_alctor_deinit(HccArenaAlctor* alctor) {
-	uint32_t arena_size = alctor->arena->size;
-	while (alctor->arena) {
-		alctor->arena = alctor->arena->prev;
-		HccArenaHeader* arena = alctor->arena;
+	HccArenaHeader* arena = alctor->arena;
+	while (arena) {
+		HccArenaHeader* prev = arena->prev;
+		hcc_virt_mem_release(alctor->tag, arena, arena->size);
+		arena = prev;
+	}
+
+	arena = alctor->free_arenas;
+	while (arena) {
+		HccArenaHeader* prev = arena->prev;
 		hcc_virt_mem_release(alctor->tag, arena, arena->size);
+		arena = prev;
 	}
+
 	alctor->arena = NULL;
+	alctor->free_arenas = NULL;
+}
+
+static HccArenaHeader* hcc_arena_alctor_next_arena(HccArenaAlctor* alctor, HccArenaHeader* arena) {
+	HccArenaHeader* new_arena = alctor->free_arenas;
+	if (new_arena) {
+		alctor->free_arenas = new_arena->prev;
+	} else {
+		new_arena = hcc_arena_alloc(alctor->tag, arena->size);
+	}
+
+	new_arena->prev = arena;
+	return new_arena;
+}
+
+static void hcc_arena_rollback(HccAllocTag tag, HccArenaHeader* arena, uint32_t pos) {
+	//
+	// zero what has been allocated since pos, so the memory is zeroed like a fresh arena when it is handed out again.
+	uint32_t end_pos = atomic_load(&arena->pos);
+	if (end_pos - pos >= HCC_ARENA_RESET_MIN_SIZE) {
+		uintptr_t reset_start = HCC_INT_ROUND_UP_ALIGN((uintptr_t)pos, _hcc_gs.virt_mem_page_size);
+		uintptr_t reset_end = HCC_INT_ROUND_UP_ALIGN((uintptr_t)end_pos, _hcc_gs.virt_mem_page_size);
+		memset(HCC_PTR_ADD(arena, pos), 0, reset_start - pos);
+		hcc_virt_mem_reset(tag, HCC_PTR_ADD(arena, reset_start), reset_end - reset_start);
+	} else {
+		memset(HCC_PTR_ADD(arena, pos), 0, end_pos - pos);
+	}
+
+	atomic_store(&arena->pos, pos);
 }
 
 void* hcc_arena_alctor_alloc(HccArenaAlctor* alctor, uint32_t size, uint32_t align) {
@@ -1015,8 +1591,7 @@ void* hcc_arena_alctor_alloc(HccArenaAlctor* alctor, uint32_t size, uint32_t ali
 		uint32_t new_pos = HCC_PTR_DIFF(end_ptr, arena);
 
 		if (new_pos > arena->size) {
-			HccArenaHeader* new_arena = hcc_arena_alloc(alctor->tag, arena->size);
-			new_arena->prev = arena;
+			HccArenaHeader* new_arena = hcc_arena_alctor_next_arena(alctor, arena);
 			*(HccArenaHeader**)&alctor->arena = new_arena;
 			arena = new_arena;
 			pos = *(uint32_t*)&arena->pos;
@@ -1048,8 +1623,7 @@ void* hcc_arena_alctor_alloc_thread_safe(HccArenaAlctor* alctor, uint32_t size,
 					//
 					// this thread managed to claim the role of allocating the next arena for the arena allocator
 					// and another thread has not just finished allocating a new arena.
-					HccArenaHeader* new_arena = hcc_arena_alloc(alctor->tag, arena->size);
-					new_arena->prev = arena;
+					HccArenaHeader* new_arena = hcc_arena_alctor_next_arena(alctor, arena);
 					atomic_store(&alctor->arena, new_arena);
 					arena = new_arena;
 				}
@@ -1075,10 +1649,42 @@ void* hcc_arena_alctor_alloc_thread_safe(HccArenaAlctor* alctor, uint32_t size,
 	}
 }
 
+HccArenaMarker hcc_arena_alctor_save(HccArenaAlctor* alctor) {
+	HccArenaHeader* arena = atomic_load(&alctor->arena);
+	return (HccArenaMarker) {
+		.arena = arena,
+		.pos = atomic_load(&arena->pos),
+	};
+}
+
+void hcc_arena_alctor_restore(HccArenaAlctor* alctor, HccArenaMarker marker) {
+	//
+	// put the arenas that came after the marker on the free list
+	HccArenaHeader* arena = atomic_load(&alctor->arena);
+	while (arena != marker.arena) {
+		HCC_DEBUG_ASSERT(arena, "arena marker does not belong to this arena allocator or it has already been rolled back past");
+		HccArenaHeader* prev = arena->prev;
+		hcc_arena_rollback(alctor->tag, arena, sizeof(HccArenaHeader));
+		arena->prev = alctor->free_arenas;
+		alctor->free_arenas = arena;
+		arena = prev;
+	}
+
+	hcc_arena_rollback(alctor->tag, arena, marker.pos);
+	atomic_store(&alctor->arena, arena);
+}
+
 void hcc_arena_alctor_reset(HccArenaAlctor* alctor) {
-	uint32_t arena_size = alctor->arena->size;
-	hcc_arena_alctor_deinit(alctor);
-	alctor->arena = hcc_arena_alloc(alctor->tag, arena_size);
+	HccArenaHeader* first_arena = atomic_load(&alctor->arena);
+	while (first_arena->prev) {
+		first_arena = first_arena->prev;
+	}
+
+	HccArenaMarker marker = {
+		.arena = first_arena,
+		.pos = sizeof(HccArenaHeader),
+	};
+	hcc_arena_alctor_restore(alctor, marker);
 }
 
 // ===========================================
@@ -1139,6 +1745,27 @@ void hcc_virt_mem_update_page_size_reserve_align(void) {
 uintptr_t hcc_virt_mem_page_size(void) { return _hcc_gs.virt_mem_page_size; }
 uintptr_t hcc_virt_mem_reserve_align(void) { return _hcc_gs.virt_mem_reserve_align; }
 
+//
+// reservations of atleast this size are backed by huge pages when HCC_FLAGS_ENABLE_HUGE_PAGES is set
+#define HCC_VIRT_MEM_HUGE_PAGES_MIN_SIZE (4 * 1024 * 1024)
+
+//
+// commits of atleast this size are given to the prefaulter when HCC_FLAGS_ENABLE_PREFAULT is set
+#define HCC_VIRT_MEM_PREFAULT_MIN_SIZE (256 * 1024)
+
+static void hcc_virt_mem_advise_huge_pages(void* addr, uintptr_t size) {
+#if defined(HCC_OS_LINUX) && defined(MADV_HUGEPAGE)
+	if ((_hcc_gs.flags & HCC_FLAGS_ENABLE_HUGE_PAGES) && size >= HCC_VIRT_MEM_HUGE_PAGES_MIN_SIZE) {
+		//
+		// this is only advice, so a kernel that has transparent huge pages turned off is not an error
+		madvise(addr, size, MADV_HUGEPAGE);
+	}
+#else
+	HCC_UNUSED(addr);
+	HCC_UNUSED(size);
+#endif
+}
+
 void hcc_virt_mem_reserve_commit(HccAllocTag tag, void* requested_addr, uintptr_t size, HccVirtMemProtection protection, void** addr_out) {
 	HCC_DEBUG_ASSERT_RESERVE_ALIGN_OR_ZERO(requested_addr);
 	HCC_DEBUG_ASSERT_RESERVE_ALIGN(size);
@@ -1153,6 +1780,7 @@ void hcc_virt_mem_reserve_commit(HccAllocTag tag, void* requested_addr, uintptr_
 	if (addr == MAP_FAILED) {
 		hcc_bail(HCC_ERROR_ALLOCATION_FAILURE, tag);
 	}
+	hcc_virt_mem_advise_huge_pages(addr, size);
 #elif defined(HCC_OS_WINDOWS)
 	DWORD prot = _hcc_virt_mem_prot_windows(protection);
 	void* addr = VirtualAlloc(requested_addr, size, MEM_RESERVE | MEM_COMMIT, prot);
@@ -1164,6 +1792,7 @@ void hcc_virt_mem_reserve_commit(HccAllocTag tag, void* requested_addr, uintptr_
 #endif
 
 	hcc_mem_tracker_update(HCC_ALLOC_MODE_ALLOC, tag, addr, size);
+	hcc_mem_tracker_update_committed(tag, addr, size, true);
 	*addr_out = addr;
 }
 
@@ -1183,6 +1812,7 @@ void hcc_virt_mem_reserve(HccAllocTag tag, void* requested_addr, uintptr_t size,
 	if (addr == MAP_FAILED) {
 		hcc_bail(HCC_ERROR_ALLOCATION_FAILURE, tag);
 	}
+	hcc_virt_mem_advise_huge_pages(addr, size);
 #elif defined(HCC_OS_WINDOWS)
 	void* addr = VirtualAlloc(requested_addr, size, MEM_RESERVE, PAGE_NOACCESS);
 	if (addr == NULL) {
@@ -1218,6 +1848,11 @@ void hcc_virt_mem_commit(HccAllocTag tag, void* addr, uintptr_t size, HccVirtMem
 #else
 #error "TODO implement virtual memory for this platform"
 #endif
+
+	hcc_mem_tracker_update_committed(tag, addr, size, true);
+	if (size >= HCC_VIRT_MEM_PREFAULT_MIN_SIZE) {
+		hcc_virt_mem_prefault(addr, size);
+	}
 }
 
 void hcc_virt_mem_protection_set(HccAllocTag tag, void* addr, uintptr_t size, HccVirtMemProtection protection) {
@@ -1266,6 +1901,8 @@ void hcc_virt_mem_decommit(HccAllocTag tag, void* addr, uintptr_t size) {
 #else
 #error "TODO implement virtual memory for this platform"
 #endif
+
+	hcc_mem_tracker_update_committed(tag, addr, size, false);
 }
 
 void hcc_virt_mem_release(HccAllocTag tag, void* addr, uintptr_t size) {
@@ -1324,11 +1961,105 @@ void hcc_virt_mem_force_physical_page_allocation(void* addr, uintptr_t size) {
 	HCC_DEBUG_ASSERT_PAGE_SIZE(addr);
 	HCC_DEBUG_ASSERT_PAGE_SIZE(size);
 
+#if defined(HCC_OS_LINUX) && defined(MADV_POPULATE_WRITE)
+	//
+	// reading the pages only maps in the shared zero page, so have the kernel allocate writable pages instead.
+	if (madvise(addr, size, MADV_POPULATE_WRITE) == 0) {
+		return;
+	}
+#endif
+
 	for (uintptr_t offset = 0; offset < size; offset += _hcc_gs.virt_mem_page_size) {
 		uintptr_t word = *(volatile uintptr_t*)HCC_PTR_ADD(addr, offset);
 	}
 }
 
+static void hcc_virt_mem_prefaulter_main(void* arg) {
+	HccVirtMemPrefaulter* p = arg;
+	while (1) {
+		hcc_semaphore_take_or_wait_then_take(&p->semaphore);
+
+		hcc_spin_mutex_lock(&p->mutex);
+		if (!atomic_load(&p->is_running)) {
+			hcc_spin_mutex_unlock(&p->mutex);
+			return;
+		}
+
+		HccVirtMemPrefaultRange range = p->queue[p->queue_head_idx];
+		p->queue_head_idx = (p->queue_head_idx + 1) % HCC_VIRT_MEM_PREFAULTER_QUEUE_CAP;
+		p->queue_count -= 1;
+		hcc_spin_mutex_unlock(&p->mutex);
+
+#if defined(HCC_OS_LINUX) && defined(MADV_POPULATE_WRITE)
+		//
+		// unlike touching the pages, this leaves the memory as it is, so it is safe when another thread is already writing to it.
+		// it fails without harm when the range has been decommitted or released since it was queued.
+		madvise(range.addr, range.size, MADV_POPULATE_WRITE);
+#endif
+	}
+}
+
+void hcc_virt_mem_prefaulter_init(void) {
+	HccVirtMemPrefaulter* p = &_hcc_gs.virt_mem_prefaulter;
+	atomic_store(&p->is_running, false);
+	if (!(_hcc_gs.flags & HCC_FLAGS_ENABLE_PREFAULT)) {
+		return;
+	}
+
+#if defined(HCC_OS_LINUX) && defined(MADV_POPULATE_WRITE)
+	hcc_semaphore_init(&p->semaphore, 0);
+	hcc_spin_mutex_init(&p->mutex);
+	p->queue_head_idx = 0;
+	p->queue_count = 0;
+	hcc_virt_mem_reserve_commit(HCC_ALLOC_TAG_VIRT_MEM_PREFAULTER, NULL, HCC_VIRT_MEM_PREFAULTER_CALL_STACK_SIZE, HCC_VIRT_MEM_PROTECTION_READ_WRITE, &p->call_stack);
+	atomic_store(&p->is_running, true);
+
+	HccThreadSetup thread_setup = {
+		.thread_main_fn = hcc_virt_mem_prefaulter_main,
+		.arg = p,
+		.call_stack = p->call_stack,
+		.call_stack_size = HCC_VIRT_MEM_PREFAULTER_CALL_STACK_SIZE,
+	};
+	hcc_thread_start(&p->thread, &thread_setup);
+#endif
+}
+
+void hcc_virt_mem_prefaulter_deinit(void) {
+	HccVirtMemPrefaulter* p = &_hcc_gs.virt_mem_prefaulter;
+	if (!atomic_load(&p->is_running)) {
+		return;
+	}
+
+	hcc_spin_mutex_lock(&p->mutex);
+	atomic_store(&p->is_running, false);
+	hcc_spin_mutex_unlock(&p->mutex);
+	hcc_semaphore_give(&p->semaphore, 1);
+	hcc_thread_wait_for_termination(&p->thread);
+	hcc_virt_mem_release(HCC_ALLOC_TAG_VIRT_MEM_PREFAULTER, p->call_stack, HCC_VIRT_MEM_PREFAULTER_CALL_STACK_SIZE);
+}
+
+void hcc_virt_mem_prefault(void* addr, uintptr_t size) {
+	HccVirtMemPrefaulter* p = &_hcc_gs.virt_mem_prefaulter;
+	if (!atomic_load(&p->is_running)) {
+		return;
+	}
+
+	bool is_queued = false;
+	hcc_spin_mutex_lock(&p->mutex);
+	if (atomic_load(&p->is_running) && p->queue_count < HCC_VIRT_MEM_PREFAULTER_QUEUE_CAP) {
+		uint32_t idx = (p->queue_head_idx + p->queue_count) % HCC_VIRT_MEM_PREFAULTER_QUEUE_CAP;
+		p->queue[idx].addr = addr;
+		p->queue[idx].size = size;
+		p->queue_count += 1;
+		is_queued = true;
+	}
+	hcc_spin_mutex_unlock(&p->mutex);
+
+	if (is_queued) {
+		hcc_semaphore_give(&p->semaphore, 1);
+	}
+}
+
 void hcc_virt_mem_magic_ring_buffer_alloc(HccAllocTag tag, void* requested_addr, uintptr_t size, void** addr_out) {
 #ifdef HCC_OS_WINDOWS
 	BOOL result;
@@ -1443,6 +2174,8 @@ void hcc_virt_mem_magic_ring_buffer_alloc(HccAllocTag tag, void* requested_addr,
 		CloseHandle(section);
 	}
 
+	hcc_mem_tracker_update(HCC_ALLOC_MODE_ALLOC, tag, ringBuffer, size * 2);
+	hcc_mem_tracker_update_committed(tag, ringBuffer, size * 2, true);
 	*addr_out = ringBuffer;
 	return;
 ERR:
@@ -1498,6 +2231,8 @@ ERR:
 	}
 #endif
 
+	hcc_mem_tracker_update(HCC_ALLOC_MODE_ALLOC, tag, addr, size * 2);
+	hcc_mem_tracker_update_committed(tag, addr, size * 2, true);
 	*addr_out = addr;
 	return;
 
@@ -1519,6 +2254,7 @@ REMAP_ERROR:
 }
 
 void hcc_virt_mem_magic_ring_buffer_dealloc(HccAllocTag tag, void* addr, uintptr_t size) {
+	hcc_mem_tracker_update(HCC_ALLOC_MODE_DEALLOC, tag, addr, size * 2);
 #ifdef HCC_OS_WINDOWS
 	VirtualFree(addr, 0, MEM_RELEASE);
 	VirtualFree(HCC_PTR_ADD(addr, size), 0, MEM_RELEASE);
@@ -1539,6 +2275,58 @@ void hcc_virt_mem_magic_ring_buffer_dealloc(HccAllocTag tag, void* addr, uintptr
 #endif
 }
 
+bool hcc_virt_mem_map_file(HccAllocTag tag, const char* path, uintptr_t zeroed_tail_size, void** addr_out, uint64_t* size_out) {
+#ifdef HCC_OS_LINUX
+	int fd = open(path, O_CLOEXEC | O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+
+	struct stat s;
+	if (fstat(fd, &s) != 0 || !S_ISREG(s.st_mode)) {
+		close(fd);
+		return false;
+	}
+
+	//
+	// reserve the whole range as zeroed anonymous memory first, then map the file over the start of it.
+	// the OS zeroes the rest of the last page of the file, so the zeroed tail only needs
+	// the anonymous pages when it spills over into the next page.
+	uintptr_t size = HCC_INT_ROUND_UP_ALIGN(s.st_size + zeroed_tail_size, _hcc_gs.virt_mem_reserve_align);
+	void* addr;
+	hcc_virt_mem_reserve_commit(tag, NULL, size, HCC_VIRT_MEM_PROTECTION_READ_WRITE, &addr);
+
+	if (s.st_size) {
+		uintptr_t file_pages_size = HCC_INT_ROUND_UP_ALIGN(s.st_size, _hcc_gs.virt_mem_page_size);
+		if (mmap(addr, file_pages_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+			hcc_virt_mem_release(tag, addr, size);
+			close(fd);
+			return false;
+		}
+	}
+
+	//
+	// the mapping keeps its own reference to the file
+	close(fd);
+
+	*addr_out = addr;
+	*size_out = s.st_size;
+	return true;
+#elif defined(HCC_OS_WINDOWS)
+	//
+	// TODO: a file view cannot be placed inside of a VirtualAlloc reservation without the placeholder APIs,
+	// so for now the caller will fall back to reading the file.
+	HCC_UNUSED(tag);
+	HCC_UNUSED(path);
+	HCC_UNUSED(zeroed_tail_size);
+	HCC_UNUSED(addr_out);
+	HCC_UNUSED(size_out);
+	return false;
+#else
+#error "unimplemented virtual memory API for this platform"
+#endif
+}
+
 // ===========================================
 //
 //
@@ -1552,6 +2340,197 @@ bool hcc_string_key_cmp(void* a, void* b, uintptr_t size) {
 	return hcc_string_eq(*(HccString*)a, *(HccString*)b);
 }
 
+//
+// HccBytesChunk is a SIMD register of bytes that the hcc_bytes_* functions below are written on top of.
+// the comparisons set every bit of a matching byte and hcc_bytes_chunk_mask returns a bit per byte.
+//
+#if defined(HCC_ARCH_X86_64) && defined(__AVX2__)
+
+#define HCC_BYTES_CHUNK_SIZE 32
+#define HCC_BYTES_CHUNK_MASK_ALL 0xffffffff
+typedef __m256i HccBytesChunk;
+
+static inline HccBytesChunk hcc_bytes_chunk_load(const char* data) { return _mm256_loadu_si256((const __m256i*)data); }
+static inline HccBytesChunk hcc_bytes_chunk_splat(char byte) { return _mm256_set1_epi8(byte); }
+static inline HccBytesChunk hcc_bytes_chunk_eq(HccBytesChunk a, HccBytesChunk b) { return _mm256_cmpeq_epi8(a, b); }
+static inline HccBytesChunk hcc_bytes_chunk_or(HccBytesChunk a, HccBytesChunk b) { return _mm256_or_si256(a, b); }
+static inline uint32_t hcc_bytes_chunk_mask(HccBytesChunk a) { return (uint32_t)_mm256_movemask_epi8(a); }
+static inline HccBytesChunk hcc_bytes_chunk_in_range(HccBytesChunk a, char start, char count) {
+	//
+	// (a - start) < count as an unsigned compare. there is only a signed compare, so flip the sign bit of both sides.
+	HccBytesChunk sign_bit = _mm256_set1_epi8((char)0x80);
+	HccBytesChunk offset = _mm256_xor_si256(_mm256_sub_epi8(a, _mm256_set1_epi8(start)), sign_bit);
+	return _mm256_cmpgt_epi8(_mm256_xor_si256(_mm256_set1_epi8(count), sign_bit), offset);
+}
+
+#elif defined(HCC_ARCH_X86_64)
+
+#define HCC_BYTES_CHUNK_SIZE 16
+#define HCC_BYTES_CHUNK_MASK_ALL 0xffff
+typedef __m128i HccBytesChunk;
+
+static inline HccBytesChunk hcc_bytes_chunk_load(const char* data) { return _mm_loadu_si128((const __m128i*)data); }
+static inline HccBytesChunk hcc_bytes_chunk_splat(char byte) { return _mm_set1_epi8(byte); }
+static inline HccBytesChunk hcc_bytes_chunk_eq(HccBytesChunk a, HccBytesChunk b) { return _mm_cmpeq_epi8(a, b); }
+static inline HccBytesChunk hcc_bytes_chunk_or(HccBytesChunk a, HccBytesChunk b) { return _mm_or_si128(a, b); }
+static inline uint32_t hcc_bytes_chunk_mask(HccBytesChunk a) { return (uint32_t)_mm_movemask_epi8(a); }
+static inline HccBytesChunk hcc_bytes_chunk_in_range(HccBytesChunk a, char start, char count) {
+	//
+	// (a - start) < count as an unsigned compare. there is only a signed compare, so flip the sign bit of both sides.
+	HccBytesChunk sign_bit = _mm_set1_epi8((char)0x80);
+	HccBytesChunk offset = _mm_xor_si128(_mm_sub_epi8(a, _mm_set1_epi8(start)), sign_bit);
+	return _mm_cmpgt_epi8(_mm_xor_si128(_mm_set1_epi8(count), sign_bit), offset);
+}
+
+#elif defined(HCC_ARCH_AARCH64)
+
+#define HCC_BYTES_CHUNK_SIZE 16
+#define HCC_BYTES_CHUNK_MASK_ALL 0xffff
+typedef uint8x16_t HccBytesChunk;
+
+static inline HccBytesChunk hcc_bytes_chunk_load(const char* data) { return vld1q_u8((const uint8_t*)data); }
+static inline HccBytesChunk hcc_bytes_chunk_splat(char byte) { return vdupq_n_u8((uint8_t)byte); }
+static inline HccBytesChunk hcc_bytes_chunk_eq(HccBytesChunk a, HccBytesChunk b) { return vceqq_u8(a, b); }
+static inline HccBytesChunk hcc_bytes_chunk_or(HccBytesChunk a, HccBytesChunk b) { return vorrq_u8(a, b); }
+static inline uint32_t hcc_bytes_chunk_mask(HccBytesChunk a) {
+	//
+	// there is no movemask on NEON, so keep a different bit in each byte of each half and add them up.
+	static const uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	uint8x16_t masked = vandq_u8(a, vld1q_u8(bits));
+	return (uint32_t)vaddv_u8(vget_low_u8(masked)) | ((uint32_t)vaddv_u8(vget_high_u8(masked)) << 8);
+}
+static inline HccBytesChunk hcc_bytes_chunk_in_range(HccBytesChunk a, char start, char count) {
+	return vcltq_u8(vsubq_u8(a, vdupq_n_u8((uint8_t)start)), vdupq_n_u8((uint8_t)count));
+}
+
+#else
+
+#define HCC_BYTES_CHUNK_SIZE 0
+
+#endif
+
+uint32_t hcc_bytes_find_any_4(const char* data, uint32_t size, char a, char b, char c, char d) {
+	uint32_t idx = 0;
+#if HCC_BYTES_CHUNK_SIZE
+	HccBytesChunk a_chunk = hcc_bytes_chunk_splat(a);
+	HccBytesChunk b_chunk = hcc_bytes_chunk_splat(b);
+	HccBytesChunk c_chunk = hcc_bytes_chunk_splat(c);
+	HccBytesChunk d_chunk = hcc_bytes_chunk_splat(d);
+	for (; idx + HCC_BYTES_CHUNK_SIZE <= size; idx += HCC_BYTES_CHUNK_SIZE) {
+		HccBytesChunk chunk = hcc_bytes_chunk_load(&data[idx]);
+		HccBytesChunk found = hcc_bytes_chunk_or(
+			hcc_bytes_chunk_or(hcc_bytes_chunk_eq(chunk, a_chunk), hcc_bytes_chunk_eq(chunk, b_chunk)),
+			hcc_bytes_chunk_or(hcc_bytes_chunk_eq(chunk, c_chunk), hcc_bytes_chunk_eq(chunk, d_chunk))
+		);
+		uint32_t mask = hcc_bytes_chunk_mask(found);
+		if (mask) {
+			return idx + hcc_leastsetbitidx32(mask);
+		}
+	}
+#endif
+
+	for (; idx < size; idx += 1) {
+		char byte = data[idx];
+		if (byte == a || byte == b || byte == c || byte == d) {
+			return idx;
+		}
+	}
+	return size;
+}
+
+uint32_t hcc_bytes_count_spaces(const char* data, uint32_t size) {
+	uint32_t idx = 0;
+#if HCC_BYTES_CHUNK_SIZE
+	HccBytesChunk space_chunk = hcc_bytes_chunk_splat(' ');
+	HccBytesChunk tab_chunk = hcc_bytes_chunk_splat('\t');
+	for (; idx + HCC_BYTES_CHUNK_SIZE <= size; idx += HCC_BYTES_CHUNK_SIZE) {
+		HccBytesChunk chunk = hcc_bytes_chunk_load(&data[idx]);
+		HccBytesChunk found = hcc_bytes_chunk_or(hcc_bytes_chunk_eq(chunk, space_chunk), hcc_bytes_chunk_eq(chunk, tab_chunk));
+		uint32_t mask = ~hcc_bytes_chunk_mask(found) & HCC_BYTES_CHUNK_MASK_ALL;
+		if (mask) {
+			return idx + hcc_leastsetbitidx32(mask);
+		}
+	}
+#endif
+
+	for (; idx < size; idx += 1) {
+		char byte = data[idx];
+		if (byte != ' ' && byte != '\t') {
+			return idx;
+		}
+	}
+	return size;
+}
+
+uint32_t hcc_bytes_count_ident(const char* data, uint32_t size) {
+	uint32_t idx = 0;
+#if HCC_BYTES_CHUNK_SIZE
+	HccBytesChunk lower_case_bit_chunk = hcc_bytes_chunk_splat(32);
+	HccBytesChunk underscore_chunk = hcc_bytes_chunk_splat('_');
+	for (; idx + HCC_BYTES_CHUNK_SIZE <= size; idx += HCC_BYTES_CHUNK_SIZE) {
+		HccBytesChunk chunk = hcc_bytes_chunk_load(&data[idx]);
+		HccBytesChunk found = hcc_bytes_chunk_or(
+			hcc_bytes_chunk_or(
+				hcc_bytes_chunk_in_range(hcc_bytes_chunk_or(chunk, lower_case_bit_chunk), 'a', 26), // see hcc_ascii_is_alpha
+				hcc_bytes_chunk_in_range(chunk, '0', 10)
+			),
+			hcc_bytes_chunk_eq(chunk, underscore_chunk)
+		);
+		uint32_t mask = ~hcc_bytes_chunk_mask(found) & HCC_BYTES_CHUNK_MASK_ALL;
+		if (mask) {
+			return idx + hcc_leastsetbitidx32(mask);
+		}
+	}
+#endif
+
+	for (; idx < size; idx += 1) {
+		char byte = data[idx];
+		if (!hcc_ascii_is_alpha(byte) && !hcc_ascii_is_digit(byte) && byte != '_') {
+			return idx;
+		}
+	}
+	return size;
+}
+
+uint32_t hcc_bytes_push_line_starts(const char* data, uint32_t size, uint32_t base_idx, uint32_t* line_starts, uint32_t* last_line_start_idx_out) {
+	uint32_t newlines_count = 0;
+	uint32_t idx = 0;
+#if HCC_BYTES_CHUNK_SIZE
+	HccBytesChunk newline_chunk = hcc_bytes_chunk_splat('\n');
+	for (; idx + HCC_BYTES_CHUNK_SIZE <= size; idx += HCC_BYTES_CHUNK_SIZE) {
+		uint32_t mask = hcc_bytes_chunk_mask(hcc_bytes_chunk_eq(hcc_bytes_chunk_load(&data[idx]), newline_chunk));
+		if (mask == 0) {
+			continue;
+		}
+
+		//
+		// push all of the line starts in this chunk at once, straight from the bits of the mask
+		uint32_t chunk_newlines_count = hcc_onebitscount32(mask);
+		newlines_count += chunk_newlines_count;
+		uint32_t* dst = line_starts ? hcc_stack_push_many(line_starts, chunk_newlines_count) : NULL;
+		while (mask) {
+			*last_line_start_idx_out = base_idx + idx + hcc_leastsetbitidx32(mask) + 1;
+			if (dst) {
+				*dst = *last_line_start_idx_out;
+				dst += 1;
+			}
+			mask = HCC_LEAST_SET_BIT_REMOVE(mask);
+		}
+	}
+#endif
+
+	for (; idx < size; idx += 1) {
+		if (data[idx] == '\n') {
+			newlines_count += 1;
+			*last_line_start_idx_out = base_idx + idx + 1;
+			if (line_starts) {
+				*hcc_stack_push(line_starts) = base_idx + idx + 1;
+			}
+		}
+	}
+	return newlines_count;
+}
+
 // ===========================================
 //
 //
@@ -1739,6 +2718,84 @@ HccHash64 hcc_hash_fnv_64(const void* data, uintptr_t size, HccHash64 hash) {
 	return hash;
 }
 
+static inline uint64_t hcc_hash_wy_mum(uint64_t a, uint64_t b) {
+	//
+	// multiply to 128 bits and fold the halves together
+#ifdef __SIZEOF_INT128__
+	__uint128_t r = (__uint128_t)a * b;
+	return (uint64_t)r ^ (uint64_t)(r >> 64);
+#elif defined(HCC_OS_WINDOWS)
+	uint64_t hi;
+	uint64_t lo = _umul128(a, b, &hi);
+	return lo ^ hi;
+#else
+#error "unimplemented 128 bit multiply for this platform"
+#endif
+}
+
+static inline uint64_t hcc_hash_wy_read_64(const uint8_t* p) {
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t hcc_hash_wy_read_32(const uint8_t* p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+HccHash64 hcc_hash_wy_64(const void* data, uintptr_t size, HccHash64 seed) {
+	static const uint64_t secret[4] = { 0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull };
+	const uint8_t* p = data;
+	seed ^= hcc_hash_wy_mum(seed ^ secret[0], secret[1]);
+
+	uint64_t a;
+	uint64_t b;
+	if (size <= 16) {
+		if (size >= 4) {
+			//
+			// read the first and last 4 or 8 bytes, the reads overlap for the sizes in between
+			uintptr_t offset = (size >> 3) << 2;
+			a = (hcc_hash_wy_read_32(p) << 32) | hcc_hash_wy_read_32(p + offset);
+			b = (hcc_hash_wy_read_32(p + size - 4) << 32) | hcc_hash_wy_read_32(p + size - 4 - offset);
+		} else if (size > 0) {
+			a = ((uint64_t)p[0] << 16) | ((uint64_t)p[size >> 1] << 8) | p[size - 1];
+			b = 0;
+		} else {
+			a = 0;
+			b = 0;
+		}
+	} else {
+		uintptr_t remaining = size;
+		if (remaining > 48) {
+			uint64_t seed_1 = seed;
+			uint64_t seed_2 = seed;
+			do {
+				seed = hcc_hash_wy_mum(hcc_hash_wy_read_64(p) ^ secret[1], hcc_hash_wy_read_64(p + 8) ^ seed);
+				seed_1 = hcc_hash_wy_mum(hcc_hash_wy_read_64(p + 16) ^ secret[2], hcc_hash_wy_read_64(p + 24) ^ seed_1);
+				seed_2 = hcc_hash_wy_mum(hcc_hash_wy_read_64(p + 32) ^ secret[3], hcc_hash_wy_read_64(p + 40) ^ seed_2);
+				p += 48;
+				remaining -= 48;
+			} while (remaining > 48);
+			seed ^= seed_1 ^ seed_2;
+		}
+
+		while (remaining > 16) {
+			seed = hcc_hash_wy_mum(hcc_hash_wy_read_64(p) ^ secret[1], hcc_hash_wy_read_64(p + 8) ^ seed);
+			p += 16;
+			remaining -= 16;
+		}
+
+		//
+		// the last 16 bytes, which overlap with the bytes already hashed when there are less than 16 left
+		a = hcc_hash_wy_read_64(p + remaining - 16);
+		b = hcc_hash_wy_read_64(p + remaining - 8);
+	}
+
+	return hcc_hash_wy_mum(secret[1] ^ size, hcc_hash_wy_mum(a ^ secret[1], b ^ seed));
+}
+
 void hcc_generate_enum_hashes(char* array_name, char** strings, char** enum_strings, uint32_t enums_count) {
 	uint32_t used_hashes[128];
 	HCC_ASSERT(enums_count <= HCC_ARRAY_COUNT(used_hashes), "internal error: used_hashes needs to be atleast %u", enums_count);
@@ -1791,6 +2848,11 @@ uint32_t hcc_string_to_enum_hashed_find(HccString string, uint32_t* enum_hashes,
 	HCC_DEBUG_ASSERT(header->magic_number == HCC_STACK_MAGIC_NUMBER, "address '%p' is not a stack", header + 1); \
 	HCC_DEBUG_ASSERT(header->elmt_size == elmt_size_, "stack element size mismatch. expected '%zu' but got '%zu'", header->elmt_size == elmt_size_)
 
+//
+// when a reset has more than this many bytes of elements to zero, reset the virtual memory
+// instead so the pages are given back to the operating system.
+#define HCC_STACK_RESET_MIN_SIZE (64 * 1024)
+
 HccStack(void) _hcc_stack_init(HccAllocTag tag, uintptr_t grow_count, uintptr_t reserve_cap, uintptr_t elmt_size) {
 	HCC_DEBUG_ASSERT_NON_ZERO(grow_count);
 	HCC_DEBUG_ASSERT_NON_ZERO(reserve_cap);
@@ -1823,6 +2885,26 @@ void _hcc_stack_deinit(HccStack(void) stack, uintptr_t elmt_size) {
 	hcc_virt_mem_release(header->tag, header, reserve_size);
 }
 
+void _hcc_stack_reset(HccStack(void) stack, uintptr_t elmt_size) {
+	HccStackHeader* header = hcc_stack_header(stack);
+	HCC_DEBUG_ASSERT_STACK(header, elmt_size);
+
+	//
+	// elements past the count may have been written before they were popped,
+	// so zero everything that has been committed and not just up to the count.
+	uintptr_t size = header->cap * elmt_size;
+	if (size >= HCC_STACK_RESET_MIN_SIZE) {
+		uintptr_t commit_size = HCC_INT_ROUND_UP_ALIGN(sizeof(HccStackHeader) + size, _hcc_gs.virt_mem_page_size);
+		HccStackHeader h = *header;
+		hcc_virt_mem_reset(h.tag, header, commit_size);
+		*header = h;
+	} else {
+		memset(stack, 0, size);
+	}
+
+	atomic_store(&header->count, 0);
+}
+
 uintptr_t _hcc_stack_resize(HccStack(void) stack, uintptr_t new_count, uintptr_t elmt_size) {
 	HccStackHeader* header = hcc_stack_header(stack);
 	HCC_DEBUG_ASSERT_STACK(header, elmt_size);
@@ -1887,6 +2969,25 @@ uintptr_t _hcc_stack_push_many_thread_safe(HccStack(void) stack, uintptr_t amoun
 	return insert_idx;
 }
 
+uintptr_t _hcc_stack_push_many_chunked(HccStack(void) stack, HccStackChunk* chunk, uintptr_t amount, uintptr_t chunk_cap, uintptr_t elmt_size) {
+	//
+	// big pushes go straight to the stack so they do not throw away most of a chunk
+	if (chunk == NULL || amount > chunk_cap / 4) {
+		return _hcc_stack_push_many_thread_safe(stack, amount, elmt_size);
+	}
+
+	if (chunk->end_idx - chunk->idx < amount) {
+		uintptr_t idx = _hcc_stack_push_many_thread_safe(stack, chunk_cap, elmt_size);
+		HCC_DEBUG_ASSERT(idx + chunk_cap <= UINT32_MAX, "stack is too big to be pushed in chunks");
+		chunk->idx = idx;
+		chunk->end_idx = idx + chunk_cap;
+	}
+
+	uintptr_t insert_idx = chunk->idx;
+	chunk->idx += amount;
+	return insert_idx;
+}
+
 void _hcc_stack_pop_many(HccStack(void) stack, uintptr_t amount, uintptr_t elmt_size) {
 	HccStackHeader* header = hcc_stack_header(stack);
 	HCC_DEBUG_ASSERT_STACK(header, elmt_size);
@@ -2131,95 +3232,176 @@ enum {
 	HCC_HASH_TABLE_HASH_START =        3,
 };
 
-#if UINTPTR_MAX == 0xFFFFFFFF
+//
+// each slot in the index also has a tag byte, with the top bit set and 7 bits of the hash for a used slot.
+// the tags of a bucket are compared all at once with SIMD to find the slots worth looking at.
+enum {
+	HCC_HASH_TABLE_TAG_EMPTY =     0,
+	HCC_HASH_TABLE_TAG_TOMBSTONE = 1,
+	HCC_HASH_TABLE_TAG_USED_BIT =  0x80,
+};
+
+//
+// a bucket is the 16 tags that fit in a single SSE2 or NEON register
 #define HCC_HASH_TABLE_BUCKET_ENTRIES_COUNT 16
 #define HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT 4
-#elif UINTPTR_MAX == 0xFFFFFFFFFFFFFFFFu
-#define HCC_HASH_TABLE_BUCKET_ENTRIES_COUNT 8
-#define HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT 3
-#endif
 static_assert(HCC_HASH_TABLE_BUCKET_ENTRIES_COUNT * sizeof(HccHash) % HCC_CACHE_LINE_SIZE == 0, "bucket must be a multiple of a cache line");
 
-HccHashTable(void) _hcc_hash_table_init(HccAllocTag tag, HccHashTableKeyCmpFn key_cmp_fn, HccHashTableKeyHashFn key_hash_fn, uintptr_t cap, uintptr_t elmt_size) {
-	HCC_DEBUG_ASSERT_POWER_OF_TWO(cap);
-	uintptr_t size = HCC_INT_ROUND_UP_ALIGN(HCC_INT_ROUND_UP_ALIGN(sizeof(HccHashTableHeader) + (cap * elmt_size), HCC_CACHE_LINE_ALIGN) + (cap * sizeof(HccHash)), _hcc_gs.virt_mem_reserve_align);
-	HccHashTableHeader* header;
-	hcc_virt_mem_reserve_commit(tag, NULL, size, HCC_VIRT_MEM_PROTECTION_READ_WRITE, (void**)&header);
+//
+// the number of slots the index of a hash table starts with before it has to grow
+#define HCC_HASH_TABLE_INDEX_START_CAP 128
 
-	//
-	// initialize the header and pass out the where the elements of the array start
-	header->count = 0;
-	header->cap = cap;
-	header->key_cmp_fn = key_cmp_fn;
-	header->key_hash_fn = key_hash_fn;
-	header->hashes = HCC_PTR_ROUND_UP_ALIGN(HCC_PTR_ADD((header + 1), cap * elmt_size), HCC_CACHE_LINE_ALIGN);
-	header->tag = tag;
-#if HCC_ENABLE_DEBUG_ASSERTIONS
-	header->magic_number = HCC_HASH_TABLE_MAGIC_NUMBER;
-	header->elmt_size = elmt_size;
-#endif
+//
+// when more than 1 / HCC_HASH_TABLE_CLEAR_RESET_DIRTY_DIVISOR of the index buckets have been used,
+// a clear resets all of the virtual memory instead of zeroing the dirty buckets one by one.
+#define HCC_HASH_TABLE_CLEAR_RESET_DIRTY_DIVISOR 4
+
+//
+// when a clear has more than this many bytes of elements to zero, reset the virtual memory
+// instead so the pages are given back to the operating system.
+#define HCC_HASH_TABLE_CLEAR_RESET_MIN_SIZE (64 * 1024)
 
-	HccHashTable(void) table = header + 1;
-	_hcc_hash_table_clear(table, elmt_size);
-	return table;
+static uintptr_t hcc_hash_table_elmts_size(uintptr_t cap, uintptr_t elmt_size, uintptr_t align) {
+	return HCC_INT_ROUND_UP_ALIGN(sizeof(HccHashTableHeader) + (cap * elmt_size), align);
 }
 
-void _hcc_hash_table_deinit(HccHashTable(void) table, uintptr_t elmt_size) {
-	HccHashTableHeader* header = hcc_hash_table_header(table);
-	HCC_DEBUG_ASSERT_HASH_TABLE(header, elmt_size);
-	uintptr_t size = HCC_INT_ROUND_UP_ALIGN(HCC_INT_ROUND_UP_ALIGN(sizeof(HccHashTableHeader) + (header->cap * elmt_size), HCC_CACHE_LINE_ALIGN) + (header->cap * sizeof(HccHash)), _hcc_gs.virt_mem_reserve_align);
-	hcc_virt_mem_release(header->tag, header, size);
+static uintptr_t hcc_hash_table_elmt_hashes_size(uintptr_t cap, uintptr_t align) {
+	return HCC_INT_ROUND_UP_ALIGN(cap * sizeof(HccHash), align);
 }
 
-void _hcc_hash_table_clear(HccHashTable(void) table, uintptr_t elmt_size) {
-	HccHashTableHeader* header = hcc_hash_table_header(table);
-	HCC_DEBUG_ASSERT_HASH_TABLE(header, elmt_size);
-	uintptr_t size = HCC_INT_ROUND_UP_ALIGN(HCC_INT_ROUND_UP_ALIGN(sizeof(HccHashTableHeader) + (header->cap * elmt_size), HCC_CACHE_LINE_ALIGN) + (header->cap * sizeof(HccHash)), _hcc_gs.virt_mem_reserve_align);
-	HccHashTableHeader h = *header;
-	hcc_virt_mem_reset(header->tag, header, size);
-	*header = h;
-	header->count = 0;
+static uintptr_t hcc_hash_table_free_elmt_indices_size(uintptr_t cap, uintptr_t align) {
+	return HCC_INT_ROUND_UP_ALIGN(cap * sizeof(uint32_t), align);
 }
 
-uintptr_t _hcc_hash_table_find_idx(HccHashTable(void) table, void* key, uintptr_t key_size, uintptr_t elmt_size) {
-	HccHashTableHeader* header = hcc_hash_table_header(table);
-	HCC_DEBUG_ASSERT_HASH_TABLE(header, elmt_size);
+static uintptr_t hcc_hash_table_index_dirty_bucket_bitset_count(uintptr_t cap) {
+	return HCC_DIV_ROUND_UP(cap >> HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT, 32);
+}
 
+static uintptr_t hcc_hash_table_index_reserve_size(uintptr_t cap) {
+	uintptr_t size = HCC_INT_ROUND_UP_ALIGN(sizeof(HccHashTableIndex), HCC_CACHE_LINE_ALIGN);
+	size += cap * sizeof(HccHash);
+	size += cap * sizeof(uint32_t);
+	size += cap * sizeof(uint8_t);
+	size += hcc_hash_table_index_dirty_bucket_bitset_count(cap) * sizeof(uint32_t);
+	return HCC_INT_ROUND_UP_ALIGN(size, _hcc_gs.virt_mem_reserve_align);
+}
+
+static HccHashTableIndex* hcc_hash_table_index_init(HccAllocTag tag, uintptr_t cap) {
+	HCC_DEBUG_ASSERT_POWER_OF_TWO(cap);
+	HccHashTableIndex* index;
+	hcc_virt_mem_reserve_commit(tag, NULL, hcc_hash_table_index_reserve_size(cap), HCC_VIRT_MEM_PROTECTION_READ_WRITE, (void**)&index);
+
+	index->retired_next = NULL;
+	index->cap = cap;
+	index->hashes = HCC_PTR_ROUND_UP_ALIGN(index + 1, HCC_CACHE_LINE_ALIGN);
+	index->elmt_indices = HCC_PTR_ADD(index->hashes, cap * sizeof(HccHash));
+	index->tags = HCC_PTR_ADD(index->elmt_indices, cap * sizeof(uint32_t));
+	index->dirty_bucket_bitset = HCC_PTR_ADD(index->tags, cap * sizeof(uint8_t));
+	index->tombstones_count = 0;
+	return index;
+}
+
+static void hcc_hash_table_index_deinit(HccAllocTag tag, HccHashTableIndex* index) {
+	while (index) {
+		HccHashTableIndex* retired_next = index->retired_next;
+		hcc_virt_mem_release(tag, index, hcc_hash_table_index_reserve_size(index->cap));
+		index = retired_next;
+	}
+}
+
+static inline HccHash hcc_hash_table_fix_hash(HccHash hash) {
 	//
-	// hash the key and ensure it is no one of the special marker hash values.
-	HccHash hash = header->key_hash_fn(key, key_size);
+	// ensure the hash of the key is not one of the special marker hash values.
 	if (hash < HCC_HASH_TABLE_HASH_START) hash += HCC_HASH_TABLE_HASH_START;
+	return hash;
+}
+
+static inline uint8_t hcc_hash_table_tag(HccHash hash) {
+	//
+	// the low bits of the hash pick the bucket and some of the key hash functions return the key,
+	// so mix all of the bits together and take the top 7 bits.
+	return HCC_HASH_TABLE_TAG_USED_BIT | (uint8_t)(((uint64_t)hash * 0x9e3779b97f4a7c15ull) >> 57);
+}
+
+//
+// returns a bit for each slot in the bucket where the tag is equal to the one passed in
+static inline uint32_t hcc_hash_table_bucket_tags_match(const uint8_t* bucket_tags, uint8_t tag) {
+#if defined(HCC_ARCH_X86_64)
+	__m128i tags = _mm_load_si128((const __m128i*)bucket_tags);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8((char)tag)));
+#elif defined(HCC_ARCH_AARCH64)
+	return hcc_bytes_chunk_mask(hcc_bytes_chunk_eq(hcc_bytes_chunk_load((const char*)bucket_tags), hcc_bytes_chunk_splat((char)tag)));
+#else
+	uint32_t mask = 0;
+	for (uint32_t idx = 0; idx < HCC_HASH_TABLE_BUCKET_ENTRIES_COUNT; idx += 1) {
+		mask |= (uint32_t)(bucket_tags[idx] == tag) << idx;
+	}
+	return mask;
+#endif
+}
+
+static inline bool hcc_hash_table_key_cmp(HccHashTableKeyCmpFn key_cmp_fn, void* key, void* entry_ptr, uintptr_t key_size) {
+	//
+	// compare the common keys directly instead of calling through the function pointer
+	if (key_cmp_fn == hcc_u32_key_cmp) {
+		return *(uint32_t*)key == *(uint32_t*)entry_ptr;
+	} else if (key_cmp_fn == hcc_u64_key_cmp) {
+		return *(uint64_t*)key == *(uint64_t*)entry_ptr;
+	} else if (key_cmp_fn == hcc_string_key_cmp) {
+		return hcc_string_eq(*(HccString*)key, *(HccString*)entry_ptr);
+	}
+	return key_cmp_fn(key, entry_ptr, key_size);
+}
 
+static void hcc_hash_table_index_mark_dirty(HccHashTableIndex* index, uintptr_t slot_idx) {
+	//
+	// mark the bucket as dirty so it gets zeroed on the next clear.
+	// check before setting so the cache line is not written to by every insert.
+	uintptr_t bucket_idx = slot_idx >> HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT;
+	HccAtomic(uint32_t)* dirty_bitset = &index->dirty_bucket_bitset[bucket_idx / 32];
+	uint32_t dirty_bit = 1u << (bucket_idx % 32);
+	if (!(atomic_load(dirty_bitset) & dirty_bit)) {
+		atomic_fetch_or(dirty_bitset, dirty_bit);
+	}
+}
+
+static uintptr_t hcc_hash_table_index_find_slot(HccHashTableIndex* index, HccHashTable(void) table, HccHashTableKeyCmpFn key_cmp_fn, void* key, uintptr_t key_size, HccHash hash, uintptr_t elmt_size) {
 	//
 	// divide the entry capacity by the number of entries in a bucket
 	// and see what bucket we should start our search in.
-	uintptr_t buckets_count = header->cap >> HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT;
+	uintptr_t buckets_count = index->cap >> HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT;
 	uintptr_t bucket_idx = hash & (buckets_count - 1);
+	uint8_t tag = hcc_hash_table_tag(hash);
 
 	uintptr_t step = 1;
-	HccAtomic(HccHash)* hashes = header->hashes;
+	HccAtomic(HccHash)* hashes = index->hashes;
 	while (1) {
 		//
 		// multiply by the number of entries in a bucket to get the position in the entry arrays.
 		uintptr_t bucket_entry_start_idx = bucket_idx << HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT;
-		for (uintptr_t entry_idx = bucket_entry_start_idx; entry_idx < bucket_entry_start_idx + HCC_HASH_TABLE_BUCKET_ENTRIES_COUNT; entry_idx += 1) {
+		uint32_t match_mask = hcc_hash_table_bucket_tags_match(&index->tags[bucket_entry_start_idx], tag);
+		while (match_mask) {
+			uintptr_t slot_idx = bucket_entry_start_idx + hcc_leastsetbitidx32(match_mask);
 			HccHash existing_hash;
-			while ((existing_hash = atomic_load(&hashes[entry_idx])) == HCC_HASH_TABLE_HASH_IS_INSERTING) {
+			while ((existing_hash = atomic_load(&hashes[slot_idx])) == HCC_HASH_TABLE_HASH_IS_INSERTING) {
 				HCC_CPU_RELAX();
 			}
 
 			if (existing_hash == hash) {
 				//
 				// hash matches, check if the key matches
-				void* entry_ptr = HCC_PTR_ADD(table, entry_idx * elmt_size);
-				if (header->key_cmp_fn(key, entry_ptr, key_size)) {
+				void* entry_ptr = HCC_PTR_ADD(table, index->elmt_indices[slot_idx] * elmt_size);
+				if (hcc_hash_table_key_cmp(key_cmp_fn, key, entry_ptr, key_size)) {
 					// key matches, success!
-					return entry_idx;
+					return slot_idx;
 				}
-			} else if (existing_hash == HCC_HASH_TABLE_HASH_EMPTY) {
-				// found an empty hash, no other entries have been inserted past this point
-				return UINTPTR_MAX;
 			}
+			match_mask = HCC_LEAST_SET_BIT_REMOVE(match_mask);
+		}
+
+		if (hcc_hash_table_bucket_tags_match(&index->tags[bucket_entry_start_idx], HCC_HASH_TABLE_TAG_EMPTY)) {
+			// found an empty slot, no other entries have been inserted past this point
+			return UINTPTR_MAX;
 		}
 
 		//
@@ -2230,65 +3412,377 @@ uintptr_t _hcc_hash_table_find_idx(HccHashTable(void) table, void* key, uintptr_
 	}
 }
 
+//
+// inserts all of the elements that have not been removed into a new empty index.
+static void hcc_hash_table_index_fill(HccHashTableHeader* header, HccHashTableIndex* new_index) {
+	uintptr_t buckets_count = new_index->cap >> HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT;
+	uintptr_t elmts_count = HCC_MIN(atomic_load(&header->count), header->cap);
+	for (uintptr_t elmt_idx = 0; elmt_idx < elmts_count; elmt_idx += 1) {
+		HccHash hash = atomic_load(&header->elmt_hashes[elmt_idx]);
+		if (hash < HCC_HASH_TABLE_HASH_START) {
+			// the element has been removed
+			continue;
+		}
+
+		//
+		// the keys are already unique, so just find the first empty slot
+		uintptr_t bucket_idx = hash & (buckets_count - 1);
+		uintptr_t step = 1;
+		while (1) {
+			uintptr_t bucket_entry_start_idx = bucket_idx << HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT;
+			uint32_t empty_mask = hcc_hash_table_bucket_tags_match(&new_index->tags[bucket_entry_start_idx], HCC_HASH_TABLE_TAG_EMPTY);
+			if (empty_mask) {
+				uintptr_t slot_idx = bucket_entry_start_idx + hcc_leastsetbitidx32(empty_mask);
+				new_index->hashes[slot_idx] = hash;
+				new_index->elmt_indices[slot_idx] = elmt_idx;
+				new_index->tags[slot_idx] = hcc_hash_table_tag(hash);
+				hcc_hash_table_index_mark_dirty(new_index, slot_idx);
+				break;
+			}
+
+			bucket_idx += step;
+			step += 1;
+			bucket_idx &= (buckets_count - 1);
+		}
+	}
+}
+
+//
+// commits the pages for at least the element at elmt_idx, doubling the committed capacity.
+// this blocks the other threads that need an element past the committed capacity until it is done,
+// the threads that are using elements below it carry on as the elements never move.
+static void hcc_hash_table_elmts_grow(HccHashTableHeader* header, uintptr_t elmt_idx, uintptr_t elmt_size) {
+	hcc_spin_mutex_lock(&header->grow_mutex);
+	uintptr_t cap = atomic_load(&header->cap);
+	if (elmt_idx >= cap) {
+		uintptr_t new_cap = HCC_MIN(HCC_MAX(cap * 2, elmt_idx + 1), header->reserve_cap);
+		uintptr_t page_size = _hcc_gs.virt_mem_page_size;
+
+		uintptr_t commit_size = hcc_hash_table_elmts_size(cap, elmt_size, page_size);
+		uintptr_t new_commit_size = hcc_hash_table_elmts_size(new_cap, elmt_size, page_size);
+		if (commit_size < new_commit_size) {
+			hcc_virt_mem_commit(header->tag, HCC_PTR_ADD(header, commit_size), new_commit_size - commit_size, HCC_VIRT_MEM_PROTECTION_READ_WRITE);
+		}
+
+		commit_size = hcc_hash_table_elmt_hashes_size(cap, page_size);
+		new_commit_size = hcc_hash_table_elmt_hashes_size(new_cap, page_size);
+		if (commit_size < new_commit_size) {
+			hcc_virt_mem_commit(header->tag, HCC_PTR_ADD(header->elmt_hashes, commit_size), new_commit_size - commit_size, HCC_VIRT_MEM_PROTECTION_READ_WRITE);
+		}
+
+		commit_size = hcc_hash_table_free_elmt_indices_size(cap, page_size);
+		new_commit_size = hcc_hash_table_free_elmt_indices_size(new_cap, page_size);
+		if (commit_size < new_commit_size) {
+			hcc_virt_mem_commit(header->tag, HCC_PTR_ADD(header->free_elmt_indices, commit_size), new_commit_size - commit_size, HCC_VIRT_MEM_PROTECTION_READ_WRITE);
+		}
+
+		atomic_store(&header->cap, new_cap);
+	}
+	hcc_spin_mutex_unlock(&header->grow_mutex);
+}
+
+//
+// replaces the index with one that has double the slots.
+// all the inserting threads are waited on, and the new index is built from the dense element hashes.
+// threads that are only searching carry on using the old index, which is why it is not released until the next clear.
+static void hcc_hash_table_index_grow(HccHashTableHeader* header, HccHashTableIndex* index) {
+	bool is_resizing = false;
+	if (!atomic_compare_exchange_strong(&header->is_resizing, &is_resizing, true)) {
+		//
+		// another thread is already growing the index, wait for it to finish.
+		while (atomic_load(&header->is_resizing)) {
+			HCC_CPU_RELAX();
+		}
+		return;
+	}
+
+	if (atomic_load(&header->index) != index) {
+		//
+		// another thread has grown the index since we looked at it
+		atomic_store(&header->is_resizing, false);
+		return;
+	}
+
+	while (atomic_load(&header->inserting_count)) {
+		HCC_CPU_RELAX();
+	}
+
+	HccHashTableIndex* new_index = hcc_hash_table_index_init(header->tag, index->cap * 2);
+	hcc_hash_table_index_fill(header, new_index);
+
+	new_index->retired_next = index;
+	atomic_store(&header->index, new_index);
+	atomic_store(&header->is_resizing, false);
+}
+
+HccHashTable(void) _hcc_hash_table_init(HccAllocTag tag, HccHashTableKeyCmpFn key_cmp_fn, HccHashTableKeyHashFn key_hash_fn, uintptr_t cap, uintptr_t elmt_size) {
+	HCC_DEBUG_ASSERT_POWER_OF_TWO(cap);
+	HCC_DEBUG_ASSERT(cap * 2 >= HCC_HASH_TABLE_BUCKET_ENTRIES_COUNT, "hash table capacity must be at least '%u'", HCC_HASH_TABLE_BUCKET_ENTRIES_COUNT / 2);
+	uintptr_t reserve_cap = HCC_MAX(cap, HCC_HASH_TABLE_RESERVE_CAP);
+	uintptr_t reserve_align = _hcc_gs.virt_mem_reserve_align;
+	uintptr_t page_size = _hcc_gs.virt_mem_page_size;
+
+	//
+	// reserve enough address space for the table to grow to reserve_cap and only commit the starting capacity.
+	HccHashTableHeader* header;
+	hcc_virt_mem_reserve(tag, NULL, hcc_hash_table_elmts_size(reserve_cap, elmt_size, reserve_align), (void**)&header);
+	hcc_virt_mem_commit(tag, header, hcc_hash_table_elmts_size(cap, elmt_size, page_size), HCC_VIRT_MEM_PROTECTION_READ_WRITE);
+
+	//
+	// initialize the header and pass out the where the elements of the array start
+	header->count = 0;
+	header->cap = cap;
+	header->reserve_cap = reserve_cap;
+	hcc_spin_mutex_init(&header->grow_mutex);
+	header->key_cmp_fn = key_cmp_fn;
+	header->key_hash_fn = key_hash_fn;
+	hcc_virt_mem_reserve(tag, NULL, hcc_hash_table_elmt_hashes_size(reserve_cap, reserve_align), (void**)&header->elmt_hashes);
+	hcc_virt_mem_commit(tag, (void*)header->elmt_hashes, hcc_hash_table_elmt_hashes_size(cap, page_size), HCC_VIRT_MEM_PROTECTION_READ_WRITE);
+	header->index = hcc_hash_table_index_init(tag, HCC_MIN(HCC_HASH_TABLE_INDEX_START_CAP, cap * 2));
+	header->inserting_count = 0;
+	header->is_resizing = false;
+	hcc_virt_mem_reserve(tag, NULL, hcc_hash_table_free_elmt_indices_size(reserve_cap, reserve_align), (void**)&header->free_elmt_indices);
+	hcc_virt_mem_commit(tag, header->free_elmt_indices, hcc_hash_table_free_elmt_indices_size(cap, page_size), HCC_VIRT_MEM_PROTECTION_READ_WRITE);
+	header->free_count = 0;
+	hcc_spin_mutex_init(&header->free_mutex);
+	header->tag = tag;
+#if HCC_ENABLE_DEBUG_ASSERTIONS
+	header->magic_number = HCC_HASH_TABLE_MAGIC_NUMBER;
+	header->elmt_size = elmt_size;
+#endif
+
+	//
+	// the memory is already zeroed so there is nothing to clear
+	return header + 1;
+}
+
+void _hcc_hash_table_deinit(HccHashTable(void) table, uintptr_t elmt_size) {
+	HccHashTableHeader* header = hcc_hash_table_header(table);
+	HCC_DEBUG_ASSERT_HASH_TABLE(header, elmt_size);
+	hcc_hash_table_index_deinit(header->tag, header->index);
+	uintptr_t reserve_align = _hcc_gs.virt_mem_reserve_align;
+	hcc_virt_mem_release(header->tag, (void*)header->elmt_hashes, hcc_hash_table_elmt_hashes_size(header->reserve_cap, reserve_align));
+	hcc_virt_mem_release(header->tag, header->free_elmt_indices, hcc_hash_table_free_elmt_indices_size(header->reserve_cap, reserve_align));
+	hcc_virt_mem_release(header->tag, header, hcc_hash_table_elmts_size(header->reserve_cap, elmt_size, reserve_align));
+}
+
+void _hcc_hash_table_clear(HccHashTable(void) table, uintptr_t elmt_size) {
+	HccHashTableHeader* header = hcc_hash_table_header(table);
+	HCC_DEBUG_ASSERT_HASH_TABLE(header, elmt_size);
+
+	//
+	// the elements are packed at the start of the table, so only zero the ones that have been used.
+	uintptr_t elmts_count = HCC_MIN(atomic_load(&header->count), header->cap);
+	if (elmts_count * elmt_size >= HCC_HASH_TABLE_CLEAR_RESET_MIN_SIZE) {
+		uintptr_t size = HCC_INT_ROUND_UP_ALIGN(sizeof(HccHashTableHeader) + (elmts_count * elmt_size), _hcc_gs.virt_mem_page_size);
+		HccHashTableHeader h = *header;
+		hcc_virt_mem_reset(h.tag, header, size);
+		*header = h;
+
+		size = HCC_INT_ROUND_UP_ALIGN(elmts_count * sizeof(HccHash), _hcc_gs.virt_mem_page_size);
+		hcc_virt_mem_reset(header->tag, (void*)header->elmt_hashes, size);
+	} else {
+		memset(table, 0, elmts_count * elmt_size);
+		memset((void*)header->elmt_hashes, 0, elmts_count * sizeof(HccHash));
+	}
+
+	//
+	// the threads that were searching the older indices have finished, so they can be released now.
+	HccHashTableIndex* index = header->index;
+	hcc_hash_table_index_deinit(header->tag, index->retired_next);
+	index->retired_next = NULL;
+
+	uintptr_t buckets_count = index->cap >> HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT;
+	uintptr_t bitset_count = hcc_hash_table_index_dirty_bucket_bitset_count(index->cap);
+	uintptr_t dirty_buckets_count = 0;
+	for (uintptr_t bitset_idx = 0; bitset_idx < bitset_count; bitset_idx += 1) {
+		dirty_buckets_count += hcc_onebitscount32(index->dirty_bucket_bitset[bitset_idx]);
+	}
+
+	if (dirty_buckets_count > buckets_count / HCC_HASH_TABLE_CLEAR_RESET_DIRTY_DIVISOR) {
+		//
+		// most of the index has been used so give the pages back to the operating system
+		HccHashTableIndex i = *index;
+		hcc_virt_mem_reset(header->tag, index, hcc_hash_table_index_reserve_size(index->cap));
+		*index = i;
+	} else {
+		//
+		// only zero the buckets that have been used since the last clear,
+		// so a clear costs the same as the number of entries instead of the capacity of the index.
+		for (uintptr_t bitset_idx = 0; bitset_idx < bitset_count; bitset_idx += 1) {
+			uint32_t bitset = index->dirty_bucket_bitset[bitset_idx];
+			while (bitset) {
+				uintptr_t bucket_idx = (bitset_idx * 32) + hcc_leastsetbitidx32(bitset);
+				uintptr_t bucket_entry_start_idx = bucket_idx << HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT;
+				memset((void*)&index->hashes[bucket_entry_start_idx], 0, HCC_HASH_TABLE_BUCKET_ENTRIES_COUNT * sizeof(HccHash));
+				memset(&index->tags[bucket_entry_start_idx], 0, HCC_HASH_TABLE_BUCKET_ENTRIES_COUNT * sizeof(uint8_t));
+				bitset = HCC_LEAST_SET_BIT_REMOVE(bitset);
+			}
+			index->dirty_bucket_bitset[bitset_idx] = 0;
+		}
+	}
+
+	index->tombstones_count = 0;
+	header->count = 0;
+	header->free_count = 0;
+}
+
+uintptr_t _hcc_hash_table_find_idx(HccHashTable(void) table, void* key, uintptr_t key_size, uintptr_t elmt_size) {
+	HccHashTableHeader* header = hcc_hash_table_header(table);
+	return _hcc_hash_table_find_idx_hashed(table, key, key_size, header->key_hash_fn(key, key_size), elmt_size);
+}
+
+uintptr_t _hcc_hash_table_find_idx_hashed(HccHashTable(void) table, void* key, uintptr_t key_size, HccHash hash, uintptr_t elmt_size) {
+	HccHashTableHeader* header = hcc_hash_table_header(table);
+	HCC_DEBUG_ASSERT_HASH_TABLE(header, elmt_size);
+#if HCC_ENABLE_DEBUG_ASSERTIONS
+	HCC_ASSERT(hash == header->key_hash_fn(key, key_size), "the hash passed in does not match the hash of the key");
+#endif
+
+	hash = hcc_hash_table_fix_hash(hash);
+	HccHashTableIndex* index = atomic_load(&header->index);
+	uintptr_t slot_idx = hcc_hash_table_index_find_slot(index, table, header->key_cmp_fn, key, key_size, hash, elmt_size);
+	return slot_idx == UINTPTR_MAX ? UINTPTR_MAX : index->elmt_indices[slot_idx];
+}
+
 HccHashTableInsert _hcc_hash_table_find_insert_idx(HccHashTable(void) table, void* key, uintptr_t key_size, uintptr_t elmt_size) {
+	HccHashTableHeader* header = hcc_hash_table_header(table);
+	return _hcc_hash_table_find_insert_idx_hashed(table, key, key_size, header->key_hash_fn(key, key_size), elmt_size);
+}
+
+HccHashTableInsert _hcc_hash_table_find_insert_idx_hashed(HccHashTable(void) table, void* key, uintptr_t key_size, HccHash hash, uintptr_t elmt_size) {
 	HccHashTableHeader* header = hcc_hash_table_header(table);
 	HCC_DEBUG_ASSERT_HASH_TABLE(header, elmt_size);
-	if (atomic_load(&header->count) >= header->cap) {
+#if HCC_ENABLE_DEBUG_ASSERTIONS
+	HCC_ASSERT(hash == header->key_hash_fn(key, key_size), "the hash passed in does not match the hash of the key");
+#endif
+	if (atomic_load(&header->count) >= header->reserve_cap && atomic_load(&header->free_count) == 0) {
 		hcc_bail(HCC_ERROR_COLLECTION_FULL, header->tag);
 	}
 
-	//
-	// hash the key and ensure it is no one of the special marker hash values.
-	HccHash hash = header->key_hash_fn(key, key_size);
-	if (hash < HCC_HASH_TABLE_HASH_START) hash += HCC_HASH_TABLE_HASH_START;
+	hash = hcc_hash_table_fix_hash(hash);
+
+TRY_THIS_INDEX_AGAIN: {}
+	HccHashTableIndex* index = atomic_load(&header->index);
 
 	//
 	// divide the entry capacity by the number of entries in a bucket
 	// and see what bucket we should start our search in.
-	uintptr_t buckets_count = header->cap >> HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT;
+	uintptr_t buckets_count = index->cap >> HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT;
 	uintptr_t bucket_idx = hash & (buckets_count - 1);
+	uint8_t tag = hcc_hash_table_tag(hash);
 
 	uintptr_t step = 1;
-	HccAtomic(HccHash)* hashes = header->hashes;
+	HccAtomic(HccHash)* hashes = index->hashes;
 	while (1) {
 		//
 		// multiply by the number of entries in a bucket to get the position in the entry arrays.
 		uintptr_t bucket_entry_start_idx = bucket_idx << HCC_HASH_TABLE_BUCKET_ENTRIES_SHIFT;
-		for (uintptr_t entry_idx = bucket_entry_start_idx; entry_idx < bucket_entry_start_idx + HCC_HASH_TABLE_BUCKET_ENTRIES_COUNT; entry_idx += 1) {
-TRY_THIS_HASH_AGAIN: {}
+TRY_THIS_BUCKET_AGAIN: {}
+		uint32_t match_mask = hcc_hash_table_bucket_tags_match(&index->tags[bucket_entry_start_idx], tag);
+		while (match_mask) {
+			uintptr_t slot_idx = bucket_entry_start_idx + hcc_leastsetbitidx32(match_mask);
 			HccHash existing_hash;
-			while ((existing_hash = atomic_load(&hashes[entry_idx])) == HCC_HASH_TABLE_HASH_IS_INSERTING) {
+			while ((existing_hash = atomic_load(&hashes[slot_idx])) == HCC_HASH_TABLE_HASH_IS_INSERTING) {
 				HCC_CPU_RELAX();
 			}
 
 			if (existing_hash == hash) {
 				// hash matches, check if the key matches
-				void* entry_ptr = HCC_PTR_ADD(table, entry_idx * elmt_size);
-				if (header->key_cmp_fn(key, entry_ptr, key_size)) {
+				uintptr_t elmt_idx = index->elmt_indices[slot_idx];
+				void* entry_ptr = HCC_PTR_ADD(table, elmt_idx * elmt_size);
+				if (hcc_hash_table_key_cmp(header->key_cmp_fn, key, entry_ptr, key_size)) {
 					// key matches, success!
-					return (HccHashTableInsert) { .idx = entry_idx, .is_new = false };
+					return (HccHashTableInsert) { .idx = elmt_idx, .is_new = false };
+				}
+			}
+			match_mask = HCC_LEAST_SET_BIT_REMOVE(match_mask);
+		}
+
+		//
+		// only empty slots are used for new entries. reusing a tombstone could insert the key a second time
+		// when it is further along the probe sequence. the tombstones are dropped when the index grows.
+		uint32_t empty_mask = hcc_hash_table_bucket_tags_match(&index->tags[bucket_entry_start_idx], HCC_HASH_TABLE_TAG_EMPTY);
+		if (empty_mask) {
+			uintptr_t slot_idx = bucket_entry_start_idx + hcc_leastsetbitidx32(empty_mask);
+
+			//
+			// let any thread that is growing the index know we are about to insert into this one.
+			// if the index is being grown or has been replaced, wait for it and search the new index instead.
+			atomic_fetch_add(&header->inserting_count, 1);
+			if (atomic_load(&header->is_resizing) || atomic_load(&header->index) != index) {
+				atomic_fetch_sub(&header->inserting_count, 1);
+				while (atomic_load(&header->is_resizing)) {
+					HCC_CPU_RELAX();
 				}
-			} else if (existing_hash == HCC_HASH_TABLE_HASH_EMPTY || existing_hash == HCC_HASH_TABLE_HASH_TOMBSTONE) {
+				goto TRY_THIS_INDEX_AGAIN;
+			}
+
+			//
+			// keep the index at most half full so the probing stays short.
+			// the tombstones are counted too as they take up slots until the index is rebuilt.
+			if (atomic_load(&header->count) + index->tombstones_count >= index->cap / 2 && index->cap < header->reserve_cap * 2) {
+				atomic_fetch_sub(&header->inserting_count, 1);
+				hcc_hash_table_index_grow(header, index);
+				goto TRY_THIS_INDEX_AGAIN;
+			}
+
+			//
+			// found an empty slot that we can use for our value.
+			// but lets fight all the other threads to see if we can take this slot first.
+			HccHash existing_hash = HCC_HASH_TABLE_HASH_EMPTY;
+			if (atomic_compare_exchange_strong(&hashes[slot_idx], &existing_hash, HCC_HASH_TABLE_HASH_IS_INSERTING)) {
 				//
-				// found an empty or tombstone hash that we can use for our value.
-				// but lets fight all the other threads to see if we can take this hash first.
-				do {
-					if (atomic_compare_exchange_weak(&hashes[entry_idx], &existing_hash, HCC_HASH_TABLE_HASH_IS_INSERTING)) {
-						//
-						// we won against the other threads, so claim the slot.
-						void* entry_ptr = HCC_PTR_ADD(table, entry_idx * elmt_size);
-						atomic_fetch_add(&header->count, 1);
-						memcpy(entry_ptr, key, key_size ? key_size : sizeof(HccString));
-						atomic_store(&hashes[entry_idx], hash);
-						return (HccHashTableInsert){ .idx = entry_idx, .is_new = true };
+				// we won against the other threads, so reuse an element that has been removed
+				// or claim the next element at the end of the table.
+				uintptr_t elmt_idx = UINTPTR_MAX;
+				if (atomic_load(&header->free_count)) {
+					hcc_spin_mutex_lock(&header->free_mutex);
+					uint32_t free_count = atomic_load(&header->free_count);
+					if (free_count) {
+						elmt_idx = header->free_elmt_indices[free_count - 1];
+						atomic_store(&header->free_count, free_count - 1);
 					}
-				} while (existing_hash == HCC_HASH_TABLE_HASH_EMPTY || existing_hash == HCC_HASH_TABLE_HASH_TOMBSTONE);
+					hcc_spin_mutex_unlock(&header->free_mutex);
+				}
 
-				//
-				// another thread stole our entry slot,
-				// lets try again to see if it inserted the hash we are looking for.
-				goto TRY_THIS_HASH_AGAIN;
+				void* entry_ptr;
+				if (elmt_idx != UINTPTR_MAX) {
+					//
+					// a new element is expected to be zeroed like it is when it comes fresh from the operating system
+					entry_ptr = HCC_PTR_ADD(table, elmt_idx * elmt_size);
+					memset(entry_ptr, 0, elmt_size);
+				} else {
+					elmt_idx = atomic_fetch_add(&header->count, 1);
+					if (elmt_idx >= atomic_load(&header->cap)) {
+						if (elmt_idx >= header->reserve_cap) {
+							atomic_store(&hashes[slot_idx], HCC_HASH_TABLE_HASH_EMPTY);
+							atomic_fetch_sub(&header->inserting_count, 1);
+							hcc_bail(HCC_ERROR_COLLECTION_FULL, header->tag);
+						}
+						hcc_hash_table_elmts_grow(header, elmt_idx, elmt_size);
+					}
+					entry_ptr = HCC_PTR_ADD(table, elmt_idx * elmt_size);
+				}
+
+				memcpy(entry_ptr, key, key_size ? key_size : sizeof(HccString));
+				atomic_store(&header->elmt_hashes[elmt_idx], hash);
+				index->elmt_indices[slot_idx] = elmt_idx;
+				index->tags[slot_idx] = tag;
+				hcc_hash_table_index_mark_dirty(index, slot_idx);
+				atomic_store(&hashes[slot_idx], hash);
+				atomic_fetch_sub(&header->inserting_count, 1);
+				return (HccHashTableInsert){ .idx = elmt_idx, .is_new = true };
+			}
+			atomic_fetch_sub(&header->inserting_count, 1);
+
+			//
+			// another thread stole our slot and it may have inserted the key we are looking for.
+			// wait for it to finish so its tag is set and look through the bucket again.
+			while (atomic_load(&hashes[slot_idx]) == HCC_HASH_TABLE_HASH_IS_INSERTING) {
+				HCC_CPU_RELAX();
 			}
+			goto TRY_THIS_BUCKET_AGAIN;
 		}
 
 		//
@@ -2297,21 +3791,54 @@ TRY_THIS_HASH_AGAIN: {}
 		step += 1;
 		bucket_idx &= (buckets_count - 1);
 	}
-
 }
 
 bool _hcc_hash_table_remove(HccHashTable(void) table, void* key, uintptr_t key_size, uintptr_t elmt_size) {
-	uintptr_t entry_idx = _hcc_hash_table_find_idx(table, key, key_size, elmt_size);
-	if (entry_idx == UINTPTR_MAX) {
+	HccHashTableHeader* header = hcc_hash_table_header(table);
+	HCC_DEBUG_ASSERT_HASH_TABLE(header, elmt_size);
+
+	HccHash hash = hcc_hash_table_fix_hash(header->key_hash_fn(key, key_size));
+	HccHashTableIndex* index = atomic_load(&header->index);
+	uintptr_t slot_idx = hcc_hash_table_index_find_slot(index, table, header->key_cmp_fn, key, key_size, hash, elmt_size);
+	if (slot_idx == UINTPTR_MAX) {
 		return false;
 	}
 
-	HccHashTableHeader* header = hcc_hash_table_header(table);
-	atomic_store(&header->hashes[entry_idx], HCC_HASH_TABLE_HASH_TOMBSTONE);
+	//
+	// tombstone the element hash too, so it is left out when the index is grown.
+	// then put the element on the free list so the next insert can use it again.
+	uint32_t elmt_idx = index->elmt_indices[slot_idx];
+	atomic_store(&header->elmt_hashes[elmt_idx], HCC_HASH_TABLE_HASH_TOMBSTONE);
+	index->tags[slot_idx] = HCC_HASH_TABLE_TAG_TOMBSTONE;
+	atomic_store(&index->hashes[slot_idx], HCC_HASH_TABLE_HASH_TOMBSTONE);
+	index->tombstones_count += 1;
+
+	uint32_t free_count = atomic_load(&header->free_count);
+	header->free_elmt_indices[free_count] = elmt_idx;
+	atomic_store(&header->free_count, free_count + 1);
+
+	if (index->tombstones_count >= index->cap / 4) {
+		//
+		// the reused elements keep the count from going up, so the index would never grow and drop the tombstones.
+		// rebuild it at the same size instead, no other thread is using the table so the old one is released right away.
+		HccHashTableIndex* new_index = hcc_hash_table_index_init(header->tag, index->cap);
+		hcc_hash_table_index_fill(header, new_index);
+		new_index->retired_next = index->retired_next;
+		index->retired_next = NULL;
+		atomic_store(&header->index, new_index);
+		hcc_hash_table_index_deinit(header->tag, index);
+	}
 
 	return true;
 }
 
+bool _hcc_hash_table_is_elmt_used(HccHashTable(void) table, uintptr_t idx, uintptr_t elmt_size) {
+	HccHashTableHeader* header = hcc_hash_table_header(table);
+	HCC_DEBUG_ASSERT_HASH_TABLE(header, elmt_size);
+	HCC_DEBUG_ASSERT_ARRAY_BOUNDS(idx, hcc_hash_table_count(table));
+	return atomic_load(&header->elmt_hashes[idx]) >= HCC_HASH_TABLE_HASH_START;
+}
+
 bool hcc_u32_key_cmp(void* a, void* b, uintptr_t size) {
 	HCC_UNUSED(size);
 	return *(uint32_t*)a == *(uint32_t*)b;
@@ -2323,14 +3850,14 @@ bool hcc_u64_key_cmp(void* a, void* b, uintptr_t size) {
 }
 
 HccHash hcc_data_key_hash(void* key, uintptr_t size) {
-	return hcc_hash_fnv(key, size, HCC_HASH_FNV_INIT);
+	return hcc_hash_wy(key, size, 0);
 }
 
 HccHash hcc_string_key_hash(void* key, uintptr_t size) {
 	HCC_UNUSED(size);
 
 	HccString string = *(HccString*)key;
-	return hcc_hash_fnv(string.data, string.size, HCC_HASH_FNV_INIT);
+	return hcc_string_hash(string.data, string.size);
 }
 
 HccHash hcc_u32_key_hash(void* key, uintptr_t size) {
@@ -2622,22 +4149,9 @@ HccLocation* hcc_decl_location(HccCU* cu, HccDecl decl) {
 //
 // ===========================================
 
-void hcc_data_type_table_init(HccCU* cu, HccCUSetup* setup) {
-	cu->dtt.arrays = hcc_stack_init(HccArrayDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_ARRAYS, setup->dtt.arrays_grow_count, setup->dtt.arrays_reserve_cap);
-	cu->dtt.compounds = hcc_stack_init(HccCompoundDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_COMPOUNDS, setup->dtt.compounds_grow_count, setup->dtt.compounds_reserve_cap);
-	cu->dtt.compound_fields = hcc_stack_init(HccCompoundField, HCC_ALLOC_TAG_DATA_TYPE_TABLE_COMPOUND_FIELDS, setup->dtt.compound_fields_grow_count, setup->dtt.compound_fields_reserve_cap);
-	cu->dtt.typedefs = hcc_stack_init(HccTypedef, HCC_ALLOC_TAG_DATA_TYPE_TABLE_TYPEDEFS, setup->dtt.typedefs_grow_count, setup->dtt.typedefs_reserve_cap);
-	cu->dtt.enums = hcc_stack_init(HccEnumDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_ENUMS, setup->dtt.enums_grow_count, setup->dtt.enums_reserve_cap);
-	cu->dtt.enum_values = hcc_stack_init(HccEnumValue, HCC_ALLOC_TAG_DATA_TYPE_TABLE_ENUM_VALUES, setup->dtt.enum_values_grow_count, setup->dtt.enum_values_reserve_cap);
-	cu->dtt.pointers = hcc_stack_init(HccPointerDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_POINTERS, setup->dtt.pointers_grow_count, setup->dtt.pointers_reserve_cap);
-	cu->dtt.functions = hcc_stack_init(HccFunctionDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_FUNCTIONS, setup->functions_grow_count, setup->functions_reserve_cap);
-	cu->dtt.function_params = hcc_stack_init(HccDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_FUNCTION_PARAMS, setup->function_params_and_variables_grow_count, setup->function_params_and_variables_reserve_cap);
-	cu->dtt.buffers = hcc_stack_init(HccBufferDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_BUFFERS, setup->dtt.buffers_grow_count, setup->dtt.buffers_reserve_cap);
-	cu->dtt.arrays_dedup_hash_table = hcc_hash_table_init(HccDataTypeDedupEntry, HCC_ALLOC_TAG_DATA_TYPE_TABLE_ARRAYS_DEDUP_HASH_TABLE, hcc_u64_key_cmp, hcc_u64_key_hash, setup->dtt.arrays_reserve_cap);
-	cu->dtt.pointers_dedup_hash_table = hcc_hash_table_init(HccDataTypeDedupEntry, HCC_ALLOC_TAG_DATA_TYPE_TABLE_POINTERS_DEDUP_HASH_TABLE, hcc_u64_key_cmp, hcc_u64_key_hash, setup->dtt.pointers_reserve_cap);
-	cu->dtt.functions_dedup_hash_table = hcc_hash_table_init(HccDataTypeDedupEntry, HCC_ALLOC_TAG_DATA_TYPE_TABLE_FUNCTIONS_DEDUP_HASH_TABLE, hcc_u64_key_cmp, hcc_u64_key_hash, setup->functions_reserve_cap);
-	cu->dtt.buffers_dedup_hash_table = hcc_hash_table_init(HccDataTypeDedupEntry, HCC_ALLOC_TAG_DATA_TYPE_TABLE_BUFFERS_DEDUP_HASH_TABLE, hcc_u64_key_cmp, hcc_u64_key_hash, setup->dtt.buffers_reserve_cap);
-
+//
+// sets up the parts of the data type table that depend on the options and get filled in again after a reset
+static void hcc_data_type_table_prepare(HccCU* cu) {
 	switch (hcc_options_get_u32(cu->options, HCC_OPTION_KEY_TARGET_ARCH)) {
 		case HCC_TARGET_ARCH_X86_64:
 			switch (hcc_options_get_u32(cu->options, HCC_OPTION_KEY_TARGET_OS)) {
@@ -2657,6 +4171,24 @@ void hcc_data_type_table_init(HccCU* cu, HccCUSetup* setup) {
 	hcc_stack_resize(cu->dtt.compounds, HCC_COMPOUND_DATA_TYPE_IDX_USER_START);
 }
 
+void hcc_data_type_table_init(HccCU* cu, HccCUSetup* setup) {
+	cu->dtt.arrays = hcc_stack_init(HccArrayDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_ARRAYS, setup->dtt.arrays_grow_count, setup->dtt.arrays_reserve_cap);
+	cu->dtt.compounds = hcc_stack_init(HccCompoundDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_COMPOUNDS, setup->dtt.compounds_grow_count, setup->dtt.compounds_reserve_cap);
+	cu->dtt.compound_fields = hcc_stack_init(HccCompoundField, HCC_ALLOC_TAG_DATA_TYPE_TABLE_COMPOUND_FIELDS, setup->dtt.compound_fields_grow_count, setup->dtt.compound_fields_reserve_cap);
+	cu->dtt.typedefs = hcc_stack_init(HccTypedef, HCC_ALLOC_TAG_DATA_TYPE_TABLE_TYPEDEFS, setup->dtt.typedefs_grow_count, setup->dtt.typedefs_reserve_cap);
+	cu->dtt.enums = hcc_stack_init(HccEnumDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_ENUMS, setup->dtt.enums_grow_count, setup->dtt.enums_reserve_cap);
+	cu->dtt.enum_values = hcc_stack_init(HccEnumValue, HCC_ALLOC_TAG_DATA_TYPE_TABLE_ENUM_VALUES, setup->dtt.enum_values_grow_count, setup->dtt.enum_values_reserve_cap);
+	cu->dtt.pointers = hcc_stack_init(HccPointerDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_POINTERS, setup->dtt.pointers_grow_count, setup->dtt.pointers_reserve_cap);
+	cu->dtt.functions = hcc_stack_init(HccFunctionDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_FUNCTIONS, setup->functions_grow_count, setup->functions_reserve_cap);
+	cu->dtt.function_params = hcc_stack_init(HccDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_FUNCTION_PARAMS, setup->function_params_and_variables_grow_count, setup->function_params_and_variables_reserve_cap);
+	cu->dtt.buffers = hcc_stack_init(HccBufferDataType, HCC_ALLOC_TAG_DATA_TYPE_TABLE_BUFFERS, setup->dtt.buffers_grow_count, setup->dtt.buffers_reserve_cap);
+	cu->dtt.arrays_dedup_hash_table = hcc_hash_table_init(HccDataTypeDedupEntry, HCC_ALLOC_TAG_DATA_TYPE_TABLE_ARRAYS_DEDUP_HASH_TABLE, hcc_u64_key_cmp, hcc_u64_key_hash, setup->dtt.arrays_grow_count);
+	cu->dtt.pointers_dedup_hash_table = hcc_hash_table_init(HccDataTypeDedupEntry, HCC_ALLOC_TAG_DATA_TYPE_TABLE_POINTERS_DEDUP_HASH_TABLE, hcc_u64_key_cmp, hcc_u64_key_hash, setup->dtt.pointers_grow_count);
+	cu->dtt.functions_dedup_hash_table = hcc_hash_table_init(HccDataTypeDedupEntry, HCC_ALLOC_TAG_DATA_TYPE_TABLE_FUNCTIONS_DEDUP_HASH_TABLE, hcc_u64_key_cmp, hcc_u64_key_hash, setup->functions_grow_count);
+	cu->dtt.buffers_dedup_hash_table = hcc_hash_table_init(HccDataTypeDedupEntry, HCC_ALLOC_TAG_DATA_TYPE_TABLE_BUFFERS_DEDUP_HASH_TABLE, hcc_u64_key_cmp, hcc_u64_key_hash, setup->dtt.buffers_grow_count);
+	hcc_data_type_table_prepare(cu);
+}
+
 void hcc_data_type_table_deinit(HccCU* cu) {
 	hcc_stack_deinit(cu->dtt.arrays);
 	hcc_stack_deinit(cu->dtt.compounds);
@@ -2666,6 +4198,30 @@ void hcc_data_type_table_deinit(HccCU* cu) {
 	hcc_stack_deinit(cu->dtt.enum_values);
 	hcc_stack_deinit(cu->dtt.buffers);
 	hcc_stack_deinit(cu->dtt.pointers);
+	hcc_stack_deinit(cu->dtt.functions);
+	hcc_stack_deinit(cu->dtt.function_params);
+	hcc_hash_table_deinit(cu->dtt.arrays_dedup_hash_table);
+	hcc_hash_table_deinit(cu->dtt.pointers_dedup_hash_table);
+	hcc_hash_table_deinit(cu->dtt.functions_dedup_hash_table);
+	hcc_hash_table_deinit(cu->dtt.buffers_dedup_hash_table);
+}
+
+void hcc_data_type_table_reset(HccCU* cu) {
+	hcc_stack_reset(cu->dtt.arrays);
+	hcc_stack_reset(cu->dtt.compounds);
+	hcc_stack_reset(cu->dtt.compound_fields);
+	hcc_stack_reset(cu->dtt.typedefs);
+	hcc_stack_reset(cu->dtt.enums);
+	hcc_stack_reset(cu->dtt.enum_values);
+	hcc_stack_reset(cu->dtt.buffers);
+	hcc_stack_reset(cu->dtt.pointers);
+	hcc_stack_reset(cu->dtt.functions);
+	hcc_stack_reset(cu->dtt.function_params);
+	hcc_hash_table_clear(cu->dtt.arrays_dedup_hash_table);
+	hcc_hash_table_clear(cu->dtt.pointers_dedup_hash_table);
+	hcc_hash_table_clear(cu->dtt.functions_dedup_hash_table);
+	hcc_hash_table_clear(cu->dtt.buffers_dedup_hash_table);
+	hcc_data_type_table_prepare(cu);
 }
 
 HccString hcc_data_type_string(HccCU* cu, HccDataType data_type) {
@@ -4162,7 +5718,7 @@ HccDataType hcc_function_data_type_deduplicate(HccCU* cu, HccDataType return_dat
 		return HCC_DATA_TYPE(FUNCTION, id - 1);
 	}
 
-	HccDataType* dst_params = hcc_stack_push_many_thread_safe(cu->dtt.function_params, params_count);
+	HccDataType* dst_params = hcc_cu_stack_push_many(cu, cu->dtt.function_params, HCC_CU_STACK_CHUNK_DTT_FUNCTION_PARAMS, params_count);
 	for (uint32_t param_idx = 0; param_idx < params_count; param_idx += 1) {
 		dst_params[param_idx] = *(HccDataType*)HCC_PTR_ADD(params, param_idx * params_stride);
 	}
@@ -4558,8 +6114,8 @@ HccHash hcc_constant_key_hash(void* key, uintptr_t size) {
 }
 
 void hcc_constant_table_init(HccCU* cu, HccConstantTableSetup* setup) {
-	cu->constant_table.entries_hash_table = hcc_hash_table_init(HccConstantEntry, 0, hcc_constant_entry_key_cmp, hcc_constant_key_hash, setup->entries_cap);
-	cu->constant_table.data = hcc_stack_init(uint8_t, 0, setup->data_grow_size, setup->data_reserve_size);
+	cu->constant_table.entries_hash_table = hcc_hash_table_init(HccConstantEntry, HCC_ALLOC_TAG_CONSTANT_TABLE_ENTRIES, hcc_constant_entry_key_cmp, hcc_constant_key_hash, setup->entries_cap);
+	cu->constant_table.data = hcc_stack_init(uint8_t, HCC_ALLOC_TAG_CONSTANT_TABLE_DATA, setup->data_grow_size, setup->data_reserve_size);
 }
 
 void hcc_constant_table_deinit(HccCU* cu) {
@@ -4567,6 +6123,11 @@ void hcc_constant_table_deinit(HccCU* cu) {
 	hcc_stack_deinit(cu->constant_table.data);
 }
 
+void hcc_constant_table_reset(HccCU* cu) {
+	hcc_hash_table_clear(cu->constant_table.entries_hash_table);
+	hcc_stack_reset(cu->constant_table.data);
+}
+
 HccConstantId _hcc_constant_table_deduplicate_end(HccCU* cu, HccDataType data_type, void* data, uint32_t data_size, uint32_t data_align, bool is_zero) {
 	HCC_UNUSED(data_align);
 	HCC_DEBUG_ASSERT(data_type != 0, "data type must be set to a non void type");
@@ -14,9 +14,10 @@
 // into a single AST and therefore a single binary.
 //
 
-void hcc_cu_init(HccCU* cu, HccCUSetup* setup, HccOptions* options) {
-	cu->options = options;
-
+//
+// sets up the parts of the CU that depend on the options
+static void hcc_cu_prepare(HccCU* cu) {
+	HccOptions* options = cu->options;
 	cu->supported_scalar_data_types_mask
 		= (1 << HCC_AML_INTRINSIC_DATA_TYPE_VOID)
 		| (1 << HCC_AML_INTRINSIC_DATA_TYPE_BOOL)
@@ -43,16 +44,25 @@ void hcc_cu_init(HccCU* cu, HccCUSetup* setup, HccOptions* options) {
 	if (hcc_options_get_bool(options, HCC_OPTION_KEY_FLOAT64_ENABLED)) {
 		cu->supported_scalar_data_types_mask |= (1 << HCC_AML_INTRINSIC_DATA_TYPE_F64);
 	}
+}
 
+void hcc_cu_init(HccCU* cu, HccCUSetup* setup, HccOptions* options) {
+	cu->options = options;
+	cu->worker_stack_chunks = NULL;
+	cu->worker_stack_chunks_count = 0;
+	hcc_cu_prepare(cu);
+
+	//
+	// the declaration tables start at the grow counts of what they hold and grow from there
 	uint32_t global_declarations_cap
-		= setup->dtt.arrays_reserve_cap
-		+ setup->dtt.compounds_reserve_cap
-		+ setup->dtt.typedefs_reserve_cap
-		+ setup->dtt.enums_reserve_cap
-		+ setup->dtt.pointers_reserve_cap
-		+ setup->dtt.buffers_reserve_cap
-		+ setup->functions_reserve_cap
-		+ setup->ast.global_variables_reserve_cap
+		= setup->dtt.arrays_grow_count
+		+ setup->dtt.compounds_grow_count
+		+ setup->dtt.typedefs_grow_count
+		+ setup->dtt.enums_grow_count
+		+ setup->dtt.pointers_grow_count
+		+ setup->dtt.buffers_grow_count
+		+ setup->functions_grow_count
+		+ setup->ast.global_variables_grow_count
 		;
 
 	hcc_constant_table_init(cu, &setup->constant_table);
@@ -63,12 +73,12 @@ void hcc_cu_init(HccCU* cu, HccCUSetup* setup, HccOptions* options) {
 	cu->shader_function_decls = hcc_stack_init(HccDecl, HCC_ALLOC_TAG_CU_SHADER_FUNCTION_DECLS, setup->functions_grow_count, setup->functions_reserve_cap);
 	cu->resource_structs = hcc_stack_init(HccDataType, HCC_ALLOC_TAG_CU_RESOURCE_STRUCTS, setup->dtt.compounds_grow_count, setup->dtt.compounds_reserve_cap);
 	cu->global_declarations = hcc_hash_table_init(HccDeclEntryAtomic, HCC_ALLOC_TAG_CU_GLOBAL_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, global_declarations_cap);
-	cu->struct_declarations = hcc_hash_table_init(HccDeclEntryAtomic, HCC_ALLOC_TAG_CU_STRUCT_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, setup->dtt.compounds_reserve_cap);
-	cu->union_declarations = hcc_hash_table_init(HccDeclEntryAtomic, HCC_ALLOC_TAG_CU_UNION_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, setup->dtt.compounds_reserve_cap);
-	cu->enum_declarations = hcc_hash_table_init(HccDeclEntryAtomic, HCC_ALLOC_TAG_CU_ENUM_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, setup->dtt.enums_reserve_cap);
+	cu->struct_declarations = hcc_hash_table_init(HccDeclEntryAtomic, HCC_ALLOC_TAG_CU_STRUCT_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, setup->dtt.compounds_grow_count);
+	cu->union_declarations = hcc_hash_table_init(HccDeclEntryAtomic, HCC_ALLOC_TAG_CU_UNION_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, setup->dtt.compounds_grow_count);
+	cu->enum_declarations = hcc_hash_table_init(HccDeclEntryAtomic, HCC_ALLOC_TAG_CU_ENUM_DECLARATIONS, hcc_u32_key_cmp, hcc_u32_key_hash, setup->dtt.enums_grow_count);
 	cu->global_declarations_cap = global_declarations_cap;
-	cu->compounds_cap = setup->dtt.compounds_reserve_cap;
-	cu->enums_cap = setup->dtt.enums_reserve_cap;
+	cu->compounds_cap = setup->dtt.compounds_grow_count;
+	cu->enums_cap = setup->dtt.enums_grow_count;
 }
 
 void hcc_cu_deinit(HccCU* cu) {
@@ -76,6 +86,59 @@ void hcc_cu_deinit(HccCU* cu) {
 	hcc_data_type_table_deinit(cu);
 	hcc_ast_deinit(cu);
 	hcc_aml_deinit(cu);
+	hcc_spirv_deinit(cu);
+	hcc_stack_deinit(cu->shader_function_decls);
+	hcc_stack_deinit(cu->resource_structs);
+	hcc_hash_table_deinit(cu->global_declarations);
+	hcc_hash_table_deinit(cu->struct_declarations);
+	hcc_hash_table_deinit(cu->union_declarations);
+	hcc_hash_table_deinit(cu->enum_declarations);
+	if (cu->worker_stack_chunks) {
+		hcc_virt_mem_release(HCC_ALLOC_TAG_CU_WORKER_STACK_CHUNKS, cu->worker_stack_chunks, hcc_cu_worker_stack_chunks_size(cu->worker_stack_chunks_count));
+	}
+}
+
+void hcc_cu_reset(HccCU* cu, HccOptions* options) {
+	cu->options = options;
+	hcc_cu_prepare(cu);
+
+	//
+	// same order as hcc_cu_init, the SPIR-V constants get deduplicated into the constant table again
+	hcc_constant_table_reset(cu);
+	hcc_data_type_table_reset(cu);
+	hcc_ast_reset(cu);
+	hcc_aml_reset(cu);
+	hcc_spirv_reset(cu);
+	hcc_stack_reset(cu->shader_function_decls);
+	hcc_stack_reset(cu->resource_structs);
+	hcc_hash_table_clear(cu->global_declarations);
+	hcc_hash_table_clear(cu->struct_declarations);
+	hcc_hash_table_clear(cu->union_declarations);
+	hcc_hash_table_clear(cu->enum_declarations);
+
+	//
+	// the chunks point into the stacks that have just been reset
+	if (cu->worker_stack_chunks) {
+		HCC_ZERO_ELMT_MANY(cu->worker_stack_chunks, cu->worker_stack_chunks_count);
+	}
+}
+
+uintptr_t hcc_cu_worker_stack_chunks_size(uint32_t workers_count) {
+	return HCC_INT_ROUND_UP_ALIGN((uintptr_t)workers_count * sizeof(HccCUWorkerStackChunks), hcc_virt_mem_reserve_align());
+}
+
+HccStackChunk* hcc_cu_worker_stack_chunk(HccCU* cu, HccCUStackChunk chunk) {
+	HccWorker* w = _hcc_tls.w;
+	if (w == NULL || cu->worker_stack_chunks == NULL) {
+		return NULL;
+	}
+
+	uint32_t worker_idx = w - w->c->workers;
+	if (worker_idx >= cu->worker_stack_chunks_count) {
+		return NULL;
+	}
+
+	return &cu->worker_stack_chunks[worker_idx].chunks[chunk];
 }
 
 // ===========================================
@@ -119,7 +182,7 @@ HccResult hcc_options_init(HccOptionsSetup* setup, HccOptions** o_out) {
 
 	HccOptions* options = HCC_ARENA_ALCTOR_ALLOC_ELMT_THREAD_SAFE(HccOptions, &_hcc_gs.arena_alctor);
 	hcc_options_reset(options);
-	options->defines = hcc_stack_init(HccOptionDefine, 0, setup->defines_grow_count, setup->defines_reserve_cap);
+	options->defines = hcc_stack_init(HccOptionDefine, HCC_ALLOC_TAG_OPTION_DEFINES, setup->defines_grow_count, setup->defines_reserve_cap);
 
 	*o_out = options;
 	hcc_clear_bail_jmp_loc();
@@ -148,7 +211,7 @@ HccResult hcc_options_merge(HccOptions* low_priority, HccOptions* high_priority,
 	uint32_t defines_reserve_cap_h = hcc_stack_reserve_cap(high_priority->defines);
 	uint32_t defines_grow_count = HCC_MAX(defines_grow_count_l, defines_grow_count_h);
 	uint32_t defines_reserve_cap = HCC_MAX(defines_reserve_cap_l, defines_reserve_cap_h);
-	options->defines = hcc_stack_init(HccOptionDefine, 0, defines_grow_count, defines_reserve_cap);
+	options->defines = hcc_stack_init(HccOptionDefine, HCC_ALLOC_TAG_OPTION_DEFINES, defines_grow_count, defines_reserve_cap);
 	uint32_t defines_count_l = hcc_stack_count(low_priority->defines);
 	uint32_t defines_count_h = hcc_stack_count(high_priority->defines);
 	HccOptionDefine* defines = hcc_stack_push_many(options->defines, defines_count_l);
@@ -178,7 +241,7 @@ HccResult hcc_options_clone(HccOptions* src, HccOptions** o_out) {
 	uint32_t defines_count = hcc_stack_count(src->defines);
 	uint32_t defines_grow_count = hcc_stack_grow_count(src->defines);
 	uint32_t defines_reserve_cap = hcc_stack_reserve_cap(src->defines);
-	options->defines = hcc_stack_init(HccOptionDefine, 0, defines_grow_count, defines_reserve_cap);
+	options->defines = hcc_stack_init(HccOptionDefine, HCC_ALLOC_TAG_OPTION_DEFINES, defines_grow_count, defines_reserve_cap);
 	HccOptionDefine* defines = hcc_stack_push_many(options->defines, defines_count);
 	HCC_COPY_ELMT_MANY(defines, src->defines, defines_count);
 
@@ -280,7 +343,7 @@ HccTaskSetup hcc_task_setup_default = {
 		.constant_table = {
 			.data_grow_size = 1048576,   // 1MB
 			.data_reserve_size = 67108864, // 64MB
-			.entries_cap = 1048576,
+			.entries_cap = 65536,
 		},
 		.dtt = {
 			.arrays_grow_count = 1024,
@@ -315,6 +378,8 @@ HccTaskSetup hcc_task_setup_default = {
 				.unique_include_files_reserve_cap = 65546,
 				.forward_declarations_to_link_grow_count = 1024,
 				.forward_declarations_to_link_reserve_cap = 131072,
+				.include_effects_grow_count = 1024,
+				.include_effects_reserve_cap = 131072,
 			},
 			.exprs_grow_count = 1024,
 			.exprs_reserve_cap = 1048576,
@@ -326,6 +391,7 @@ HccTaskSetup hcc_task_setup_default = {
 			.forward_declarations_reserve_cap = 131072,
 			.designated_initializer_elmt_indices_grow_count = 1024,
 			.designated_initializer_elmt_indices_reserve_cap = 131072,
+			.include_cache_cap = 1024,
 		},
 		.aml = {
 			.function_alctor = {
@@ -339,6 +405,8 @@ HccTaskSetup hcc_task_setup_default = {
 		.functions_reserve_cap = 131072,
 		.function_params_and_variables_grow_count = 1024,
 		.function_params_and_variables_reserve_cap = 131072,
+		.function_callees_grow_count = 1024,
+		.function_callees_reserve_cap = 131072,
 	},
 	.options = NULL,
 	.include_paths_cap = 1024,
@@ -474,10 +542,12 @@ void hcc_task_finish(HccTask* t, bool thread_that_set_error) {
 	HccCompiler* c = t->c;
 	HccTime end_time = hcc_time_now(HCC_TIME_MODE_MONOTONIC);
 	t->duration = hcc_time_diff(end_time, t->start_time);
+	//
+	// the workers are kept alive when the compiler has no tasks left,
+	// they only stop when the compiler is deinitialized.
 	bool is_compiler_finished = atomic_fetch_sub(&c->tasks_running_count, 1) == 1;
 	if (is_compiler_finished) {
 		c->duration = hcc_time_diff(end_time, c->start_time);
-		atomic_fetch_or(&c->flags, HCC_COMPILER_FLAGS_IS_STOPPING);
 	}
 
 	if (was_successful) {
@@ -491,8 +561,12 @@ void hcc_task_finish(HccTask* t, bool thread_that_set_error) {
 	if (is_compiler_finished) {
 		hcc_mutex_unlock(&c->wait_for_all_mutex);
 	}
-	hcc_mutex_unlock(&t->is_running_mutex);
+
+	//
+	// let go of the compiler before unlocking, so the task can be dispatched again
+	// as soon as hcc_task_wait_for_complete returns.
 	t->c = NULL;
+	hcc_mutex_unlock(&t->is_running_mutex);
 }
 
 HccResult hcc_task_init(HccTaskSetup* setup, HccTask** t_out) {
@@ -502,10 +576,11 @@ HccResult hcc_task_init(HccTaskSetup* setup, HccTask** t_out) {
 	t->cu_setup = setup->cu;
 	t->options = setup->options;
 	t->final_worker_job_type = HCC_WORKER_JOB_TYPE_BACKENDLINK;
-	t->include_path_strings = hcc_stack_init(HccString, 0, setup->include_paths_cap, setup->include_paths_cap);
-	t->message_sys.elmts = hcc_stack_init(HccMessage, 0, setup->messages_cap, setup->messages_cap);
-	t->message_sys.locations = hcc_stack_init(HccLocation, 0, setup->messages_cap * 2, setup->messages_cap * 2);
-	t->message_sys.strings = hcc_stack_init(char, 0, setup->message_strings_cap, setup->message_strings_cap);
+	t->include_path_strings = hcc_stack_init(HccString, HCC_ALLOC_TAG_TASK_INCLUDE_PATH_STRINGS, setup->include_paths_cap, setup->include_paths_cap);
+	t->include_paths_hash = HCC_HASH_FNV_64_INIT;
+	t->message_sys.elmts = hcc_stack_init(HccMessage, HCC_ALLOC_TAG_MESSAGE_SYS_ELMTS, setup->messages_cap, setup->messages_cap);
+	t->message_sys.locations = hcc_stack_init(HccLocation, HCC_ALLOC_TAG_MESSAGE_SYS_LOCATIONS, setup->messages_cap * 2, setup->messages_cap * 2);
+	t->message_sys.strings = hcc_stack_init(char, HCC_ALLOC_TAG_MESSAGE_SYS_STRINGS, setup->message_strings_cap, setup->message_strings_cap);
 
 	*t_out = t;
 	hcc_clear_bail_jmp_loc();
@@ -518,7 +593,9 @@ void hcc_task_deinit(HccTask* t) {
 	hcc_stack_deinit(t->message_sys.locations);
 	hcc_stack_deinit(t->message_sys.strings);
 
-	hcc_cu_deinit(t->cu);
+	if (t->cu) {
+		hcc_cu_deinit(t->cu);
+	}
 }
 
 void hcc_task_set_final_worker_job_type(HccTask* t, HccWorkerJobType final_worker_job_type) {
@@ -533,6 +610,21 @@ HccResult hcc_task_add_include_path(HccTask* t, HccString path) {
 	}
 
 	*hcc_stack_push(t->include_path_strings) = path;
+	t->include_paths_hash = hcc_hash_fnv_64(&path.size, sizeof(path.size), t->include_paths_hash);
+	t->include_paths_hash = hcc_hash_fnv_64(path.data, path.size, t->include_paths_hash);
+	hcc_clear_bail_jmp_loc();
+	return HCC_RESULT_SUCCESS;
+}
+
+HccResult hcc_task_set_pch_dir(HccTask* t, HccString path) {
+	HCC_SET_BAIL_JMP_LOC_GLOBAL();
+
+	if (!hcc_path_is_directory(path.data)) {
+		hcc_clear_bail_jmp_loc();
+		return HccResult(HCC_ERROR_NOT_A_DIR, 0, NULL);
+	}
+
+	t->pch_dir_path = path;
 	hcc_clear_bail_jmp_loc();
 	return HCC_RESULT_SUCCESS;
 }
@@ -635,25 +727,139 @@ HccDuration hcc_task_worker_job_type_duration(HccTask* t, HccWorkerJobType type)
 //
 // ===========================================
 
+HccWorkerJobRing* _hcc_worker_job_ring_alloc(uint64_t cap) {
+	uintptr_t size = HCC_INT_ROUND_UP_ALIGN(sizeof(HccWorkerJobRing) + cap * sizeof(HccWorkerJob), _hcc_gs.virt_mem_reserve_align);
+
+	HccWorkerJobRing* ring;
+	hcc_virt_mem_reserve_commit(HCC_ALLOC_TAG_WORKER_JOB_QUEUE, NULL, size, HCC_VIRT_MEM_PROTECTION_READ_WRITE, (void**)&ring);
+	ring->prev = NULL;
+	ring->size = size;
+	ring->cap = cap;
+	return ring;
+}
+
+void hcc_worker_job_deque_init(HccWorkerJobDeque* deque, uint32_t cap) {
+	uint64_t ring_cap = 1;
+	while (ring_cap < cap) {
+		ring_cap <<= 1;
+	}
+
+	atomic_store(&deque->top, 0);
+	atomic_store(&deque->bottom, 0);
+	atomic_store(&deque->ring, _hcc_worker_job_ring_alloc(ring_cap));
+}
+
+void hcc_worker_job_deque_deinit(HccWorkerJobDeque* deque) {
+	HccWorkerJobRing* ring = atomic_load(&deque->ring);
+	while (ring) {
+		HccWorkerJobRing* prev = ring->prev;
+		hcc_virt_mem_release(HCC_ALLOC_TAG_WORKER_JOB_QUEUE, ring, ring->size);
+		ring = prev;
+	}
+	atomic_store(&deque->ring, NULL);
+}
+
+void hcc_worker_job_deque_push(HccWorkerJobDeque* deque, HccWorkerJob* job) {
+	int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	HccWorkerJobRing* ring = atomic_load_explicit(&deque->ring, memory_order_relaxed);
+
+	if ((uint64_t)(bottom - top) >= ring->cap) {
+		//
+		// the ring is full, so copy the live jobs into a ring with double the capacity.
+		// the old ring is kept alive as thieves may still be reading from it.
+		HccWorkerJobRing* new_ring = _hcc_worker_job_ring_alloc(ring->cap * 2);
+		for (int64_t idx = top; idx < bottom; idx += 1) {
+			new_ring->jobs[idx & (new_ring->cap - 1)] = ring->jobs[idx & (ring->cap - 1)];
+		}
+		new_ring->prev = ring;
+		atomic_store_explicit(&deque->ring, new_ring, memory_order_release);
+		ring = new_ring;
+	}
+
+	ring->jobs[bottom & (ring->cap - 1)] = *job;
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+}
+
+bool hcc_worker_job_deque_pop(HccWorkerJobDeque* deque, HccWorkerJob* job_out) {
+	int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	HccWorkerJobRing* ring = atomic_load_explicit(&deque->ring, memory_order_relaxed);
+	atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+	if (top > bottom) {
+		//
+		// deque is empty
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+		return false;
+	}
+
+	*job_out = ring->jobs[bottom & (ring->cap - 1)];
+	if (top != bottom) {
+		return true;
+	}
+
+	//
+	// this is the last job in the deque, so race against the thieves for it
+	bool is_taken = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+	return is_taken;
+}
+
+bool hcc_worker_job_deque_steal(HccWorkerJobDeque* deque, HccWorkerJob* job_out) {
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+	if (top >= bottom) {
+		return false;
+	}
+
+	//
+	// pull the data out before we try to claim the job
+	HccWorkerJobRing* ring = atomic_load_explicit(&deque->ring, memory_order_acquire);
+	HccWorkerJob job = ring->jobs[top & (ring->cap - 1)];
+	if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+		return false;
+	}
+
+	*job_out = job;
+	return true;
+}
+
 void hcc_worker_init(HccWorker* w, HccCompiler* c, void* call_stack, uintptr_t call_stack_size, HccCompilerSetup* setup) {
-	HCC_UNUSED(setup);
 	w->c = c;
 
+	hcc_worker_job_deque_init(&w->job_deque, setup->worker_jobs_queue_cap);
+	w->string_table_data = NULL;
+	w->string_table_data_remaining = 0;
+	w->string_table_next_id = 0;
+	w->string_table_end_id = 0;
+
+	uint32_t core_idx_plus_one = 0;
+	if (setup->worker_core_indices_count) {
+		uint32_t worker_idx = w - c->workers;
+		core_idx_plus_one = setup->worker_core_indices[worker_idx % setup->worker_core_indices_count] + 1;
+	}
+
+	//
+	// start the thread last so it never sees the worker half initialized.
+	// the string buffer and arena are allocated by the thread itself, see hcc_worker_main
 	HccThreadSetup thread_setup = {
 		.thread_main_fn = hcc_worker_main,
 		.arg = w,
 		.call_stack = call_stack,
 		.call_stack_size = call_stack_size,
+		.core_idx_plus_one = core_idx_plus_one,
 	};
 	hcc_thread_start(&w->thread, &thread_setup);
-
-	w->string_buffer = hcc_stack_init(char, HCC_ALLOC_TAG_WORKER_STRING_BUFFER, setup->worker_string_buffer_grow_size, setup->worker_string_buffer_reserve_size);
-	hcc_arena_alctor_init(&w->arena_alctor, HCC_ALLOC_TAG_WORKER_ARENA, setup->worker_arena_size);
 }
 
 void hcc_worker_deinit(HccWorker* w) {
 	hcc_stack_deinit(w->string_buffer);
 	hcc_arena_alctor_deinit(&w->arena_alctor);
+	hcc_worker_job_deque_deinit(&w->job_deque);
 }
 
 HccLocation* hcc_worker_alloc_location(HccWorker* w) {
@@ -687,7 +893,44 @@ void hcc_worker_end_job(HccWorker* w) {
 		return;
 	}
 
-	if (atomic_fetch_sub(&t->queued_jobs_count, 1) == 1) {
+	//
+	// give out the jobs that only depend on this job, so they can start
+	// without waiting for every other job of this worker job type to finish.
+	if (!(t->message_sys.used_type_flags & HCC_MESSAGE_TYPE_ERROR)) {
+		switch (w->job.type) {
+			case HCC_WORKER_JOB_TYPE_ASTLINK: {
+				//
+				// the forward declarations in this file have been resolved, so the functions defined in it
+				// can be lowered to AML. only the ones that a shader can call are given out,
+				// the rest (most of libhmaths) never get an AML function, a call graph or SPIR-V.
+				uint32_t start_idx;
+				uint32_t end_idx;
+				hcc_ast_find_reachable_functions(t->cu, w->job.arg, &start_idx, &end_idx);
+				for (uint32_t idx = start_idx; idx < end_idx; idx += 1) {
+					void* arg = (void*)(uintptr_t)t->cu->ast.reachable_function_decls[idx];
+					hcc_compiler_give_worker_job(c, t, HCC_WORKER_JOB_TYPE_AMLGEN, arg);
+				}
+				break;
+			};
+			case HCC_WORKER_JOB_TYPE_AMLGEN:
+				hcc_compiler_give_amlopt_worker_job(c, t, (HccDecl)(uintptr_t)w->job.arg, HCC_AML_OPT_PHASE_0);
+				break;
+			case HCC_WORKER_JOB_TYPE_AMLOPT:
+				//
+				// HCC_AML_OPT_PHASE_1 gives out the HCC_AML_OPT_PHASE_2 jobs itself
+				// as each function is found in the call graph of a shader.
+				if (w->job.aml_opt_phase == HCC_AML_OPT_PHASE_2) {
+					hcc_compiler_give_worker_job(c, t, HCC_WORKER_JOB_TYPE_BACKENDGEN, w->job.arg);
+				}
+				break;
+		}
+	}
+
+	if (atomic_fetch_sub(&t->queued_jobs_count, 1) != 1) {
+		return;
+	}
+
+	while (1) {
 		//
 		// set the worker_job_type duration in the task and add it to the compiler's overall copy
 		HccTime end_time = hcc_time_now(HCC_TIME_MODE_MONOTONIC);
@@ -708,7 +951,20 @@ void hcc_worker_end_job(HccWorker* w) {
 		}
 
 		//
-		// setup the next worker job type
+		// hold the next worker job type open while we give out its jobs.
+		// the jobs can be stolen and finished by other workers before we have given them all out,
+		// so without this the count can hit zero and start the worker job type after this one too early.
+		atomic_fetch_add(&t->queued_jobs_count, 1);
+
+		//
+		// setup the next worker job type.
+		// only the stages that need the whole compilation unit to be finished wait here, which are:
+		// - ASTLINK needs every file's declarations from ASTGEN
+		// - BACKENDLINK needs every function from BACKENDGEN
+		// the jobs in between are given out by the job they depend on,
+		// so the AMLGEN jobs run during ASTLINK, a shader's HCC_AML_OPT_PHASE_1 starts once the call graphs
+		// of the functions it calls are made (see hcc_amlopt_call_graph_made) and the BACKENDGEN jobs run during AMLOPT.
+		// only the shaders in a call cycle wait for the end of AMLGEN, so the recursion can be reported.
 		HccWorkerJobType next_job_type = t->worker_job_type + 1;
 		switch (t->worker_job_type) {
 			case HCC_WORKER_JOB_TYPE_ATAGEN: {
@@ -720,6 +976,17 @@ void hcc_worker_end_job(HccWorker* w) {
 				break;
 			};
 			case HCC_WORKER_JOB_TYPE_ASTGEN: {
+				//
+				// the functions are all known now, so size the per function arrays
+				// before any of the AMLGEN, AMLOPT and BACKENDGEN jobs write into them.
+				uint32_t functions_count = hcc_stack_count(t->cu->ast.functions);
+				hcc_stack_resize(t->cu->aml.functions, functions_count);
+				hcc_stack_resize(t->cu->aml.function_call_node_lists, functions_count);
+				hcc_stack_resize(t->cu->aml.call_graph_deps, functions_count);
+				HCC_ZERO_ELMT_MANY(t->cu->aml.call_graph_deps, functions_count);
+				hcc_stack_resize(t->cu->spirv.functions, functions_count);
+				hcc_ast_seed_reachable_functions(t->cu);
+
 				HccStack(HccASTFile*) ast_files = t->cu->ast.files;
 				uint32_t files_count = hcc_stack_count(ast_files);
 				for (uint32_t file_idx = 0; file_idx < files_count; file_idx += 1) {
@@ -727,56 +994,29 @@ void hcc_worker_end_job(HccWorker* w) {
 				}
 				break;
 			};
-			case HCC_WORKER_JOB_TYPE_ASTLINK: {
-				uint32_t functions_count = hcc_stack_count(t->cu->ast.functions);
-				hcc_stack_resize(t->cu->aml.functions, functions_count);
-
-				for (uint32_t function_idx = HCC_FUNCTION_IDX_USER_START; function_idx < functions_count; function_idx += 1) {
-					HccDecl function_decl = HCC_DECL(FUNCTION, function_idx);
-					void* arg = (void*)(uintptr_t)function_decl;
-					hcc_compiler_give_worker_job(c, w->job.task, HCC_WORKER_JOB_TYPE_AMLGEN, arg);
-				}
+			case HCC_WORKER_JOB_TYPE_ASTLINK:
+				//
+				// the AMLGEN and HCC_AML_OPT_PHASE_0 jobs have already run alongside ASTLINK
+				HCC_DEBUG_ASSERT(hcc_stack_count(t->cu->ast.unlinked_reachable_function_decls) == 0, "internal error: every file has been linked so every reachable function should have been found");
 				break;
-			};
 			case HCC_WORKER_JOB_TYPE_AMLGEN: {
-				uint32_t functions_count = hcc_stack_count(t->cu->aml.functions);
-				hcc_stack_resize(t->cu->aml.function_call_node_lists, functions_count);
-
-				HccStack(HccDecl) optimize_functions = hcc_aml_optimize_functions(w->cu);
-				for (uint32_t idx = 0; idx < hcc_stack_count(optimize_functions); idx += 1) {
-					HccDecl function_decl = optimize_functions[idx];
-					void* arg = (void*)(uintptr_t)function_decl;
-					hcc_compiler_give_worker_job(c, w->job.task, HCC_WORKER_JOB_TYPE_AMLOPT, arg);
-				}
-				hcc_aml_next_optimize_functions_array(w->cu);
-				break;
-			};
-			case HCC_WORKER_JOB_TYPE_AMLOPT: {
-				uint32_t functions_count = hcc_stack_count(t->cu->aml.functions);
-				t->cu->aml.opt_phase += 1;
-
-				HccStack(HccDecl) optimize_functions = hcc_aml_optimize_functions(w->cu);
-				if (t->cu->aml.opt_phase < HCC_AML_OPT_PHASE_COUNT) {
-					HCC_DEBUG_ASSERT(hcc_stack_count(optimize_functions), "we still have optimization phases to go but no functions where listed to be optimized");
-					for (uint32_t idx = 0; idx < hcc_stack_count(optimize_functions); idx += 1) {
-						HccDecl function_decl = optimize_functions[idx];
-						void* arg = (void*)(uintptr_t)function_decl;
-						hcc_compiler_give_worker_job(c, w->job.task, HCC_WORKER_JOB_TYPE_AMLOPT, arg);
-					}
-					next_job_type = HCC_WORKER_JOB_TYPE_AMLOPT;
-					hcc_aml_next_optimize_functions_array(w->cu);
-				} else {
-					hcc_stack_resize(t->cu->spirv.functions, functions_count);
-
-					HCC_DEBUG_ASSERT(hcc_stack_count(optimize_functions), "we have have no functions to output after AMLOPT has completed");
-					for (uint32_t idx = 0; idx < hcc_stack_count(optimize_functions); idx += 1) {
-						HccDecl function_decl = optimize_functions[idx];
-						void* arg = (void*)(uintptr_t)function_decl;
-						hcc_compiler_give_worker_job(c, w->job.task, HCC_WORKER_JOB_TYPE_BACKENDGEN, arg);
+				//
+				// the shaders have been given out to HCC_AML_OPT_PHASE_1 by hcc_amlopt_call_graph_made as soon as their
+				// whole call graph was made. the ones left are part of a call cycle, so give them out now to report the recursion.
+				uint32_t shaders_count = hcc_stack_count(t->cu->shader_function_decls);
+				for (uint32_t shader_idx = 0; shader_idx < shaders_count; shader_idx += 1) {
+					HccDecl decl = t->cu->shader_function_decls[shader_idx];
+					if (!hcc_stack_get(t->cu->aml.call_graph_deps, HCC_DECL_AUX(decl))->is_made) {
+						hcc_compiler_give_amlopt_worker_job(c, w->job.task, decl, HCC_AML_OPT_PHASE_1);
 					}
 				}
 				break;
 			};
+			case HCC_WORKER_JOB_TYPE_AMLOPT:
+				//
+				// the HCC_AML_OPT_PHASE_2 and BACKENDGEN jobs have already run alongside HCC_AML_OPT_PHASE_1
+				HCC_DEBUG_ASSERT(hcc_stack_count(hcc_aml_optimize_functions(t->cu)), "we have have no functions to output after AMLOPT has completed");
+				break;
 			case HCC_WORKER_JOB_TYPE_BACKENDGEN:
 				hcc_compiler_give_worker_job(c, w->job.task, HCC_WORKER_JOB_TYPE_BACKENDLINK, NULL);
 				break;
@@ -785,6 +1025,14 @@ void hcc_worker_end_job(HccWorker* w) {
 		}
 		t->worker_job_type = next_job_type;
 		t->worker_job_type_start_times[t->worker_job_type] = end_time;
+
+		if (atomic_fetch_sub(&t->queued_jobs_count, 1) != 1) {
+			return;
+		}
+
+		//
+		// all of the jobs we gave out have already finished (or none were given),
+		// so carry on and setup the worker job type after this one.
 	}
 }
 
@@ -793,8 +1041,23 @@ HCC_STDCALL void hcc_worker_main(void* arg) {
 	HccCompiler* c = w->c;
 	HCC_SET_BAIL_JMP_LOC_WORKER();
 
+	if (!w->is_mem_allocated) {
+		//
+		// the thread may have been pinned to a core, so the memory is first touched here
+		// by the thread that owns it. where the pages go after that is up to the operating system.
+		// the flag is set first so bailing out while allocating does not try again.
+		w->is_mem_allocated = true;
+		w->string_buffer = hcc_stack_init(char, HCC_ALLOC_TAG_WORKER_STRING_BUFFER, c->setup.worker_string_buffer_grow_size, c->setup.worker_string_buffer_reserve_size);
+		hcc_arena_alctor_init(&w->arena_alctor, HCC_ALLOC_TAG_WORKER_ARENA, c->setup.worker_arena_size);
+	}
+
+	if (!w->is_ready) {
+		w->is_ready = true;
+		hcc_semaphore_give(&c->workers_ready_semaphore, 1);
+	}
+
 	while (1) {
-		if (!hcc_compiler_take_or_wait_then_take_worker_job(c, &w->job)) {
+		if (!hcc_compiler_take_or_wait_then_take_worker_job(c, w, &w->job)) {
 			//
 			// kill the thread when the compiler is stopping
 			return;
@@ -887,7 +1150,7 @@ HccCompilerSetup hcc_compiler_setup_default = {
 			.stringify_buffer_reserve_cap = 32768,
 			.if_stack_grow_count = 256,
 			.if_stack_reserve_cap = 1024,
-			.macro_declarations_cap = 131072,
+			.macro_declarations_cap = 4096,
 			.macro_args_stack_grow_count = 1024,
 			.macro_args_stack_reserve_cap = 131072,
 		},
@@ -895,12 +1158,19 @@ HccCompilerSetup hcc_compiler_setup_default = {
 		.paused_file_stack_reserve_cap = 1024,
 		.open_bracket_stack_grow_count = 256,
 		.open_bracket_stack_reserve_cap = 1024,
+		.include_recording_stack_grow_count = 256,
+		.include_recording_stack_reserve_cap = 1024,
+		.pch_elmts_grow_count = 16384,
+		.pch_elmts_reserve_cap = 1048576,
+		.pch_idx_map_cap = 16384,
 	},
 	.astgen = {
 		.variable_stack_grow_count = 1024,
 		.variable_stack_reserve_cap = 16384,
 		.compound_fields_reserve_cap = 1024,
 		.function_params_and_variables_reserve_cap = 1024,
+		.function_callees_grow_count = 1024,
+		.function_callees_reserve_cap = 16384,
 		.enum_values_reserve_cap = 1024,
 		.curly_initializer_nested_reserve_cap = 2048,
 		.curly_initializer_nested_curlys_reserve_cap = 2048,
@@ -921,65 +1191,92 @@ HccCompilerSetup hcc_compiler_setup_default = {
 	.workers_count = 1,
 	.worker_jobs_queue_cap = 4096,
 	.worker_call_stack_size = 131072,
+	.worker_core_indices = NULL,
+	.worker_core_indices_count = 0,
 };
 
 void hcc_compiler_give_worker_job(HccCompiler* c, HccTask* t, HccWorkerJobType job_type, void* arg) {
-	if (t->final_worker_job_type < job_type) {
+	HccWorkerJob job = {
+		.type = job_type,
+		.task = t,
+		.arg = arg,
+	};
+	_hcc_compiler_give_worker_job(c, &job);
+}
+
+void hcc_compiler_give_amlopt_worker_job(HccCompiler* c, HccTask* t, HccDecl function_decl, HccAMLOptPhase phase) {
+	HccWorkerJob job = {
+		.type = HCC_WORKER_JOB_TYPE_AMLOPT,
+		.aml_opt_phase = phase,
+		.task = t,
+		.arg = (void*)(uintptr_t)function_decl,
+	};
+	_hcc_compiler_give_worker_job(c, &job);
+}
+
+void _hcc_compiler_give_worker_job(HccCompiler* c, HccWorkerJob* job) {
+	if (job->task->final_worker_job_type < job->type) {
 		// job is out of scope for the requested compilation
 		return;
 	}
 
-	//
-	// spin until we are the thread to claim a slot to write the job into
-	uint32_t tail_idx = atomic_load(&c->worker_job_queue.tail_idx);
-	while (1) {
-		uint32_t head_idx = atomic_load(&c->worker_job_queue.head_idx);
-		uint32_t count = tail_idx >= head_idx
-			? tail_idx - head_idx
-			: tail_idx + (c->worker_job_queue.cap - head_idx);
-
-		if (count + 1 >= c->worker_job_queue.cap) {
-			hcc_bail(HCC_ERROR_COLLECTION_FULL, HCC_ALLOC_TAG_WORKER_JOB_QUEUE);
-		}
+	atomic_fetch_add(&job->task->queued_jobs_count, 1);
+	_hcc_compiler_push_worker_job(c, job);
+}
 
-		uint32_t next_tail_idx = (tail_idx + 1) % c->worker_job_queue.cap;
-		if (atomic_compare_exchange_weak(&c->worker_job_queue.tail_idx, &tail_idx, next_tail_idx)) {
-			break;
-		}
+void _hcc_compiler_push_worker_job(HccCompiler* c, HccWorkerJob* job) {
+	//
+	// workers push onto their own deque so the fan out of jobs stay local
+	// until another worker runs out of work and comes to steal them.
+	// any other thread pushes onto the shared injected job deque.
+	HccWorker* w = _hcc_tls.w;
+	if (w && w->c == c) {
+		hcc_worker_job_deque_push(&w->job_deque, job);
+	} else {
+		hcc_spin_mutex_lock(&c->injected_job_deque_mutex);
+		hcc_worker_job_deque_push(&c->injected_job_deque, job);
+		hcc_spin_mutex_unlock(&c->injected_job_deque_mutex);
 	}
 
-	HccWorkerJob* job = &c->worker_job_queue.data[tail_idx];
-	job->type = job_type;
-	job->task = t;
-	job->arg = arg;
-
 	//
 	// tell the worker threads that there is a new job
-	atomic_fetch_add(&t->queued_jobs_count, 1);
-	hcc_semaphore_give(&c->worker_job_queue.semaphore, 1);
+	hcc_semaphore_give(&c->worker_jobs_semaphore, 1);
 }
 
-bool hcc_compiler_take_or_wait_then_take_worker_job(HccCompiler* c, HccWorkerJob* job_out) {
+bool hcc_compiler_take_or_wait_then_take_worker_job(HccCompiler* c, HccWorker* w, HccWorkerJob* job_out) {
 	if (atomic_load(&c->flags) & HCC_COMPILER_FLAGS_IS_STOPPING) {
 		return false;
 	}
 
-	hcc_semaphore_take_or_wait_then_take(&c->worker_job_queue.semaphore);
+	hcc_semaphore_take_or_wait_then_take(&c->worker_jobs_semaphore);
+	if (atomic_load(&c->flags) & HCC_COMPILER_FLAGS_IS_STOPPING) {
+		return false;
+	}
 
 	//
-	// spin until we are the thread to claim this worker job
-	uint32_t head_idx = atomic_load(&c->worker_job_queue.head_idx);
+	// the semaphore value is the number of jobs that nobody has claimed yet,
+	// so now we have taken from it there is a job in one of the deques waiting for us.
+	// look in our own deque first, then the injected jobs and then steal from the other workers
+	// starting with our neighbour so the thieves are spread out across the workers.
+	uint32_t worker_idx = w - c->workers;
 	while (1) {
-		// pull the data out before we store the updated head_idx back
-		*job_out = c->worker_job_queue.data[head_idx];
+		if (hcc_worker_job_deque_pop(&w->job_deque, job_out)) {
+			return true;
+		}
 
-		uint32_t next_head_idx = (head_idx + 1) % c->worker_job_queue.cap;
-		if (atomic_compare_exchange_weak(&c->worker_job_queue.head_idx, &head_idx, next_head_idx)) {
-			break;
+		if (hcc_worker_job_deque_steal(&c->injected_job_deque, job_out)) {
+			return true;
 		}
-	}
 
-	return true;
+		for (uint32_t idx = 1; idx < c->workers_count; idx += 1) {
+			HccWorker* victim = &c->workers[(worker_idx + idx) % c->workers_count];
+			if (hcc_worker_job_deque_steal(&victim->job_deque, job_out)) {
+				return true;
+			}
+		}
+
+		HCC_CPU_RELAX();
+	}
 }
 
 HccResult hcc_compiler_init(HccCompilerSetup* setup, HccCompiler** c_out) {
@@ -992,17 +1289,16 @@ HccResult hcc_compiler_init(HccCompilerSetup* setup, HccCompiler** c_out) {
 
 	uint32_t workers_count = setup->workers_count;
 	if (workers_count == 0) {
-		workers_count = hcc_logical_cores_count();
+		workers_count = hcc_available_logical_cores_count();
 	}
 
 	c->setup = *setup;
+	c->workers_count = workers_count;
 
-	//
-	// allocate the job queue magic ring buffer
-	uint32_t worker_jobs_size = setup->worker_jobs_queue_cap * sizeof(HccWorkerJob);
-	worker_jobs_size = hcc_uint32_round_up_to_multiple(worker_jobs_size, _hcc_gs.virt_mem_page_size);
-	hcc_virt_mem_magic_ring_buffer_alloc(HCC_ALLOC_TAG_WORKER_JOB_QUEUE, NULL, worker_jobs_size, (void**)&c->worker_job_queue.data);
-	c->worker_job_queue.cap = setup->worker_jobs_queue_cap;
+	hcc_semaphore_init(&c->worker_jobs_semaphore, 0);
+	hcc_semaphore_init(&c->workers_ready_semaphore, 0);
+	hcc_spin_mutex_init(&c->injected_job_deque_mutex);
+	hcc_worker_job_deque_init(&c->injected_job_deque, setup->worker_jobs_queue_cap);
 
 	//
 	// reserve address space for all of the worker call stacks separated by a page
@@ -1019,7 +1315,8 @@ HccResult hcc_compiler_init(HccCompilerSetup* setup, HccCompiler** c_out) {
 	hcc_virt_mem_reserve(HCC_ALLOC_TAG_WORKER_CALL_STACKS, NULL, worker_call_stacks_size, (void**)&c->worker_call_stacks_addr);
 
 	void* call_stack = c->worker_call_stacks_addr;
-	c->workers = HCC_ARENA_ALCTOR_ALLOC_ARRAY_THREAD_SAFE(HccWorker, &_hcc_gs.arena_alctor, workers_count);
+	c->workers_size = HCC_INT_ROUND_UP_ALIGN((uintptr_t)workers_count * sizeof(HccWorker), hcc_virt_mem_reserve_align());
+	hcc_virt_mem_reserve_commit(HCC_ALLOC_TAG_WORKERS, NULL, c->workers_size, HCC_VIRT_MEM_PROTECTION_READ_WRITE, (void**)&c->workers);
 	for (uint32_t worker_idx = 0; worker_idx < workers_count; worker_idx += 1) {
 		call_stack = HCC_PTR_ADD(call_stack, page_size);
 		hcc_virt_mem_commit(HCC_ALLOC_TAG_WORKER_CALL_STACKS, call_stack, worker_call_stack_size, HCC_VIRT_MEM_PROTECTION_READ_WRITE);
@@ -1027,9 +1324,18 @@ HccResult hcc_compiler_init(HccCompilerSetup* setup, HccCompiler** c_out) {
 		call_stack = HCC_PTR_ADD(call_stack, worker_call_stack_size);
 	}
 
-	hcc_mutex_init(&c->wait_for_all_mutex);
+	//
+	// wait for the workers to allocate their memory, so the compiler can be deinitialized straight away
+	for (uint32_t worker_idx = 0; worker_idx < workers_count; worker_idx += 1) {
+		hcc_semaphore_take_or_wait_then_take(&c->workers_ready_semaphore);
+	}
 
-	hcc_semaphore_init(&c->worker_job_queue.semaphore, 0);
+	if (atomic_load(&c->flags) & HCC_COMPILER_FLAGS_IS_RESULT_SET) {
+		hcc_clear_bail_jmp_loc();
+		return c->result_data.result;
+	}
+
+	hcc_mutex_init(&c->wait_for_all_mutex);
 
 	*c_out = c;
 	hcc_clear_bail_jmp_loc();
@@ -1039,12 +1345,14 @@ HccResult hcc_compiler_init(HccCompilerSetup* setup, HccCompiler** c_out) {
 HccResult hcc_compiler_deinit(HccCompiler* c) {
 	HCC_SET_BAIL_JMP_LOC_COMPILER();
 
-	atomic_fetch_or(&c->flags, HCC_COMPILER_FLAGS_IS_STOPPING);
-	hcc_semaphore_give(&c->worker_job_queue.semaphore, c->workers_count); // wake up all the workers to make stop their threads
 	HccResult result = hcc_compiler_wait_for_all_tasks(c);
+	atomic_fetch_or(&c->flags, HCC_COMPILER_FLAGS_IS_STOPPING);
+	hcc_semaphore_give(&c->worker_jobs_semaphore, c->workers_count); // wake up all the workers to make stop their threads
 	for (uint32_t idx = 0; idx < c->workers_count; idx += 1) {
 		hcc_worker_deinit(&c->workers[idx]);
 	}
+	hcc_virt_mem_release(HCC_ALLOC_TAG_WORKERS, c->workers, c->workers_size);
+	hcc_worker_job_deque_deinit(&c->injected_job_deque);
 
 	hcc_clear_bail_jmp_loc();
 	return result;
@@ -1060,6 +1368,14 @@ HccResult hcc_compiler_dispatch_task(HccCompiler* c, HccTask* t) {
 
 	t->result = HCC_RESULT_SUCCESS;
 	t->flags &= ~(HCC_TASK_FLAGS_IS_RESULT_SET);
+
+	//
+	// throw away the messages from the last dispatch of this task. otherwise they fill up the message stacks
+	// and the error flag would fail every compile after the first one that had an error.
+	hcc_stack_clear(t->message_sys.elmts);
+	hcc_stack_clear(t->message_sys.locations);
+	hcc_stack_clear(t->message_sys.strings);
+	t->message_sys.used_type_flags = 0;
 	t->worker_job_type = HCC_WORKER_JOB_TYPE_ATAGEN;
 	HCC_ZERO_ARRAY(t->worker_job_type_durations);
 	HCC_ZERO_ELMT(&t->duration);
@@ -1067,12 +1383,25 @@ HccResult hcc_compiler_dispatch_task(HccCompiler* c, HccTask* t) {
 	t->worker_job_type_start_times[HCC_WORKER_JOB_TYPE_ATAGEN] = t->start_time;
 
 	if (t->cu) {
-		hcc_cu_deinit(t->cu);
-		t->cu = NULL;
+		//
+		// the task is being dispatched again, so reuse the CU from last time.
+		// this keeps all of the memory it has committed instead of allocating a new CU out of the global arena.
+		hcc_cu_reset(t->cu, t->options);
+	} else {
+		t->cu = HCC_ARENA_ALCTOR_ALLOC_ELMT_THREAD_SAFE(HccCU, &_hcc_gs.arena_alctor);
+		hcc_cu_init(t->cu, &t->cu_setup, t->options);
 	}
 
-	t->cu = HCC_ARENA_ALCTOR_ALLOC_ELMT_THREAD_SAFE(HccCU, &_hcc_gs.arena_alctor);
-	hcc_cu_init(t->cu, &t->cu_setup, t->options);
+	//
+	// these have their own reservation as there are too many of them for the global arena on machines with lots of cores.
+	// the memory is zeroed when it is committed.
+	if (t->cu->worker_stack_chunks_count < c->workers_count) {
+		if (t->cu->worker_stack_chunks) {
+			hcc_virt_mem_release(HCC_ALLOC_TAG_CU_WORKER_STACK_CHUNKS, t->cu->worker_stack_chunks, hcc_cu_worker_stack_chunks_size(t->cu->worker_stack_chunks_count));
+		}
+		hcc_virt_mem_reserve_commit(HCC_ALLOC_TAG_CU_WORKER_STACK_CHUNKS, NULL, hcc_cu_worker_stack_chunks_size(c->workers_count), HCC_VIRT_MEM_PROTECTION_READ_WRITE, (void**)&t->cu->worker_stack_chunks);
+		t->cu->worker_stack_chunks_count = c->workers_count;
+	}
 
 	if (atomic_fetch_add(&c->tasks_running_count, 1) == 0) {
 		//
@@ -1080,7 +1409,7 @@ HccResult hcc_compiler_dispatch_task(HccCompiler* c, HccTask* t) {
 		//
 		hcc_mutex_lock(&c->wait_for_all_mutex);
 		c->result_data.result = HCC_RESULT_SUCCESS;
-		c->flags &= ~(HCC_COMPILER_FLAGS_IS_RESULT_SET | HCC_COMPILER_FLAGS_IS_STOPPING);
+		c->flags &= ~HCC_COMPILER_FLAGS_IS_RESULT_SET;
 		if (_hcc_gs.flags & HCC_FLAGS_ENABLE_STACKTRACE) {
 			c->result_data.result.stacktrace = c->result_data.result_stacktrace;
 			c->result_data.result_stacktrace[0] = '\0';
@@ -1090,22 +1419,34 @@ HccResult hcc_compiler_dispatch_task(HccCompiler* c, HccTask* t) {
 		c->start_time = t->start_time;
 
 		//
-		// CONTRIBUTOR: we want to keep the code files in future and only
-		// throw them away if the user calls hcc_clear_code_files
-		// and we want to update them when a timestamp mismatches that we can an update from the OS
-		//
-		// - write a timestamp abstraction
-		// - write the code that refetches the file when the timestamp is out of date
+		// keep the code files from the previous compiles around and only reload the ones
+		// that have changed on disk. no tasks are running so nothing is parsing them.
+		hcc_code_files_refresh();
+
 		//
-		HCC_CONTRIBUTOR_TASK(keep code files around between compiles);
-		hcc_clear_code_files();
+		// files may have been created or removed since the last compile, so search for the includes
+		// that were looked for in those directories again.
+		hcc_include_resolve_cache_refresh();
 	}
 
 	{
-		HccTaskInputLocation* il = t->input_locations;
-		while (il) {
-			hcc_compiler_give_worker_job(c, t, HCC_WORKER_JOB_TYPE_ATAGEN, il);
-			il = il->next;
+		//
+		// account for all of the input jobs before any of them are queued.
+		// otherwise a worker can finish the first ATAGEN job before the rest are queued
+		// and move the task on to the next worker job type too early.
+		uint32_t inputs_count = 0;
+		for (HccTaskInputLocation* il = t->input_locations; il; il = il->next) {
+			inputs_count += 1;
+		}
+		atomic_fetch_add(&t->queued_jobs_count, inputs_count);
+
+		for (HccTaskInputLocation* il = t->input_locations; il; il = il->next) {
+			HccWorkerJob job = {
+				.type = HCC_WORKER_JOB_TYPE_ATAGEN,
+				.task = t,
+				.arg = il,
+			};
+			_hcc_compiler_push_worker_job(c, &job);
 		}
 	}
 
@@ -1124,6 +1465,7 @@ HccResult hcc_compiler_wait_for_all_tasks(HccCompiler* c) {
 
 HccResult hcc_compiler_clear_mem_arenas(HccCompiler* c) {
 	HCC_SET_BAIL_JMP_LOC_COMPILER();
+	HCC_DEBUG_ASSERT(atomic_load(&c->tasks_running_count) == 0, "the worker arenas cannot be cleared while tasks are running");
 	for (uint32_t worker_idx = 0; worker_idx < c->workers_count; worker_idx += 1) {
 		hcc_arena_alctor_reset(&c->workers[worker_idx].arena_alctor);
 	}
@@ -1196,8 +1538,17 @@ void hcc_string_intrinsic_decl_add_function(char* buf, uint32_t buf_size, uint32
 }
 
 void hcc_string_table_init(HccStringTable* string_table, uint32_t data_grow_count, uint32_t data_reserve_cap, uint32_t entries_cap) {
-	string_table->entries_hash_table = hcc_hash_table_init(HccStringEntry, HCC_ALLOC_TAG_STRING_TABLE_ENTRIES, hcc_string_key_cmp, hcc_string_key_hash, entries_cap);
-	string_table->id_to_entry_map = hcc_stack_init(uint32_t, HCC_ALLOC_TAG_STRING_TABLE_ID_TO_ENTRY_MAP, entries_cap, entries_cap);
+	//
+	// entries_cap is only where the string table starts, the shards and the identifiers grow as strings are added.
+	// each shard starts with its fair share and can grow up to HCC_HASH_TABLE_RESERVE_CAP entries.
+	uint32_t shard_entries_cap = HCC_MAX(entries_cap / HCC_STRING_TABLE_SHARDS_COUNT, 1024);
+	static_assert(HCC_HASH_TABLE_RESERVE_CAP <= HCC_STRING_TABLE_ENTRY_IDX_MASK, "a string table shard can grow past what its entry index can hold");
+	HCC_ASSERT(shard_entries_cap <= HCC_STRING_TABLE_ENTRY_IDX_MASK, "string table entries cap of '%u' is too large", entries_cap);
+	for (uint32_t shard_idx = 0; shard_idx < HCC_STRING_TABLE_SHARDS_COUNT; shard_idx += 1) {
+		string_table->entries_hash_tables[shard_idx] = hcc_hash_table_init(HccStringEntry, HCC_ALLOC_TAG_STRING_TABLE_ENTRIES, hcc_string_key_cmp, hcc_string_key_hash, shard_entries_cap);
+	}
+	uint32_t ids_reserve_cap = HCC_MAX(entries_cap, HCC_STRING_TABLE_SHARDS_COUNT * HCC_HASH_TABLE_RESERVE_CAP);
+	string_table->id_to_entry_map = hcc_stack_init(uint32_t, HCC_ALLOC_TAG_STRING_TABLE_ID_TO_ENTRY_MAP, entries_cap, ids_reserve_cap);
 	hcc_stack_resize(string_table->id_to_entry_map, entries_cap);
 	string_table->data = hcc_stack_init(char, HCC_ALLOC_TAG_STRING_TABLE_DATA, data_grow_count, data_reserve_cap);
 	string_table->next_id = 1;
@@ -1437,7 +1788,9 @@ void hcc_string_table_init(HccStringTable* string_table, uint32_t data_grow_coun
 }
 
 void hcc_string_table_deinit(HccStringTable* string_table) {
-	hcc_hash_table_deinit(string_table->entries_hash_table);
+	for (uint32_t shard_idx = 0; shard_idx < HCC_STRING_TABLE_SHARDS_COUNT; shard_idx += 1) {
+		hcc_hash_table_deinit(string_table->entries_hash_tables[shard_idx]);
+	}
 	hcc_stack_deinit(string_table->id_to_entry_map);
 	hcc_stack_deinit(string_table->data);
 }
@@ -1450,21 +1803,96 @@ void hcc_string_table_skip_next_ids(HccStringTable* string_table, uint32_t num)
 	HccStringId(atomic_fetch_add(&string_table->next_id, num));
 }
 
+static char* hcc_string_table_alloc_data(HccStringTable* string_table, HccWorker* w, uint32_t size) {
+	//
+	// outside of a worker (eg. at setup) or for big strings go straight to the shared data
+	if (w == NULL || size > HCC_STRING_TABLE_WORKER_DATA_CHUNK_SIZE / 4) {
+		return hcc_stack_push_many_thread_safe(string_table->data, size);
+	}
+
+	if (w->string_table_data_remaining < size) {
+		w->string_table_data = hcc_stack_push_many_thread_safe(string_table->data, HCC_STRING_TABLE_WORKER_DATA_CHUNK_SIZE);
+		w->string_table_data_remaining = HCC_STRING_TABLE_WORKER_DATA_CHUNK_SIZE;
+	}
+
+	char* data = w->string_table_data;
+	w->string_table_data += size;
+	w->string_table_data_remaining -= size;
+	return data;
+}
+
+//
+// makes sure the identifiers up to end_id have a slot in the map, committing more of the map if they do not.
+static void hcc_string_table_ids_ensure(HccStringTable* string_table, uint32_t end_id) {
+	HccStackHeader* header = hcc_stack_header(string_table->id_to_entry_map);
+	if (end_id <= atomic_load(&header->count)) {
+		return;
+	}
+
+	if (end_id > header->reserve_cap) {
+		hcc_bail(HCC_ERROR_COLLECTION_FULL, HCC_ALLOC_TAG_STRING_TABLE_ID_TO_ENTRY_MAP);
+	}
+
+	hcc_spin_mutex_lock(&header->push_thread_safe_mutex);
+	if (end_id > atomic_load(&header->count)) {
+		hcc_stack_resize(string_table->id_to_entry_map, end_id);
+	}
+	hcc_spin_mutex_unlock(&header->push_thread_safe_mutex);
+}
+
+static uint32_t hcc_string_table_alloc_id(HccStringTable* string_table, HccWorker* w) {
+	uint32_t id;
+	if (w == NULL) {
+		//
+		// outside of a worker the identifiers are handed out one by one,
+		// as the intrinsic strings are expected to be given the next identifier in sequence.
+		id = atomic_fetch_add(&string_table->next_id, 1);
+		hcc_string_table_ids_ensure(string_table, id + 1);
+	} else {
+		if (w->string_table_next_id == w->string_table_end_id) {
+			uint32_t start_id = atomic_fetch_add(&string_table->next_id, HCC_STRING_TABLE_WORKER_ID_BLOCK_COUNT);
+			hcc_string_table_ids_ensure(string_table, start_id + HCC_STRING_TABLE_WORKER_ID_BLOCK_COUNT);
+			w->string_table_next_id = start_id;
+			w->string_table_end_id = start_id + HCC_STRING_TABLE_WORKER_ID_BLOCK_COUNT;
+		}
+
+		id = w->string_table_next_id;
+		w->string_table_next_id += 1;
+	}
+
+	return id;
+}
+
+static HccStringEntry* hcc_string_table_entry(HccStringTable* string_table, HccStringId id) {
+	uint32_t entry = *hcc_stack_get(string_table->id_to_entry_map, id.idx_plus_one);
+	return &string_table->entries_hash_tables[entry >> HCC_STRING_TABLE_ENTRY_IDX_BITS][entry & HCC_STRING_TABLE_ENTRY_IDX_MASK];
+}
+
 HccResult hcc_string_table_deduplicate(const char* string, uint32_t string_size, HccStringId* out) {
+	return hcc_string_table_deduplicate_hashed(string, string_size, hcc_string_hash(string, string_size), out);
+}
+
+HccResult hcc_string_table_deduplicate_hashed(const char* string, uint32_t string_size, HccHash hash, HccStringId* out) {
 	HCC_SET_BAIL_JMP_LOC_GLOBAL();
 
 	HccStringTable* string_table = &_hcc_gs.string_table;
+	uint32_t shard_idx = (uint32_t)(hash >> (sizeof(HccHash) * 8 - HCC_STRING_TABLE_SHARDS_SHIFT));
+	HccHashTable(HccStringEntry) entries_hash_table = string_table->entries_hash_tables[shard_idx];
 	HccString str = hcc_string((char*)string, string_size);
-	HccHashTableInsert insert = hcc_hash_table_find_insert_idx(string_table->entries_hash_table, &str);
-	HccStringEntry* entry = &string_table->entries_hash_table[insert.idx];
+	HccHashTableInsert insert = hcc_hash_table_find_insert_idx_hashed(entries_hash_table, &str, hash);
+	HccStringEntry* entry = &entries_hash_table[insert.idx];
 	if (insert.is_new) {
-		char* dst = hcc_stack_push_many_thread_safe(string_table->data, str.size);
+		HccWorker* w = _hcc_tls.w;
+		char* dst = hcc_string_table_alloc_data(string_table, w, str.size);
 		memcpy(dst, str.data, str.size);
 		str.data = dst;
 		entry->string = str;
-		uint32_t id = atomic_fetch_add(&string_table->next_id, 1);
+		uint32_t id = hcc_string_table_alloc_id(string_table, w);
+
+		//
+		// map the identifier before it is published, so any thread that sees it can look the string up straight away
+		*hcc_stack_get(string_table->id_to_entry_map, id) = (shard_idx << HCC_STRING_TABLE_ENTRY_IDX_BITS) | (uint32_t)insert.idx;
 		atomic_store(&entry->id, id);
-		*hcc_stack_get(string_table->id_to_entry_map, id) = insert.idx;
 	} else {
 		//
 		// if another thread has just inserted this string into the string table.
@@ -1481,18 +1909,15 @@ HccResult hcc_string_table_deduplicate(const char* string, uint32_t string_size,
 
 HccString hcc_string_table_get(HccStringId id) {
 	HCC_DEBUG_ASSERT_NON_ZERO(id.idx_plus_one);
-	HccStringTable* string_table = &_hcc_gs.string_table;
-	uint32_t entry_idx = *hcc_stack_get(string_table->id_to_entry_map, id.idx_plus_one);
-	return string_table->entries_hash_table[entry_idx].string;
+	return hcc_string_table_entry(&_hcc_gs.string_table, id)->string;
 }
 
 HccString hcc_string_table_get_or_empty(HccStringId id) {
 	HccStringTable* string_table = &_hcc_gs.string_table;
-	if (id.idx_plus_one == 0 || id.idx_plus_one >= hcc_hash_table_cap(string_table->entries_hash_table)) {
+	if (id.idx_plus_one == 0 || id.idx_plus_one >= hcc_stack_count(string_table->id_to_entry_map)) {
 		return hcc_string(NULL, 0);
 	}
-	uint32_t entry_idx = *hcc_stack_get(string_table->id_to_entry_map, id.idx_plus_one);
-	return string_table->entries_hash_table[entry_idx].string;
+	return hcc_string_table_entry(string_table, id)->string;
 }
 
 // ===========================================
@@ -1505,23 +1930,24 @@ HccString hcc_string_table_get_or_empty(HccStringId id) {
 
 HccResult hcc_code_file_init(HccCodeFile* code_file, HccString path_string, bool do_not_open_file) {
 	code_file->path_string = path_string;
-	code_file->line_code_start_indices = hcc_stack_init(uint32_t, 0, _hcc_gs.code_file_lines_grow_count, _hcc_gs.code_file_lines_reserve_cap);
-	code_file->pp_if_spans = hcc_stack_init(HccPPIfSpan, 0, _hcc_gs.code_file_pp_if_spans_grow_count, _hcc_gs.code_file_pp_if_spans_reserve_cap);
+	code_file->line_code_start_indices = hcc_stack_init(uint32_t, HCC_ALLOC_TAG_CODE_FILE_LINE_CODE_START_INDICES, _hcc_gs.code_file_lines_grow_count, _hcc_gs.code_file_lines_reserve_cap);
+	code_file->pp_if_spans = hcc_stack_init(HccPPIfSpan, HCC_ALLOC_TAG_CODE_FILE_PP_IF_SPANS, _hcc_gs.code_file_pp_if_spans_grow_count, _hcc_gs.code_file_pp_if_spans_reserve_cap);
 	hcc_stack_push_many(code_file->line_code_start_indices, 2);
+	code_file->include_guard_string_id.idx_plus_one = 0;
 
 	if (!do_not_open_file) {
-		HccIIO iio;
-		if (!_hcc_gs.file_open_read_fn(path_string.data, &iio)) {
+		//
+		// stat before we read so if the file is written to while we are reading it,
+		// the next compile will see a newer timestamp and check the file again.
+		if (_hcc_gs.file_stat_fn && !_hcc_gs.file_stat_fn(path_string.data, &code_file->stat)) {
 			return HccResult(HCC_ERROR_FILE_OPEN_READ, 0, NULL);
 		}
 
-		uintptr_t alloc_size = HCC_INT_ROUND_UP_ALIGN(iio.size + _HCC_TOKENIZER_LOOK_HEAD_SIZE, _hcc_gs.virt_mem_reserve_align);
-		hcc_virt_mem_reserve_commit(HCC_ALLOC_TAG_CODE, NULL, alloc_size, HCC_VIRT_MEM_PROTECTION_READ_WRITE, (void**)&code_file->code.data);
-
-		code_file->code.size = iio.size;
-		if (hcc_iio_read(&iio, code_file->code.data, iio.size) == UINTPTR_MAX) {
-			return HccResult(HCC_ERROR_FILE_READ, 0, NULL);
+		HccResult result = hcc_code_file_load_code(path_string, &code_file->code);
+		if (!HCC_IS_SUCCESS(result)) {
+			return result;
 		}
+		code_file->code_hash = hcc_hash_fnv_64(code_file->code.data, code_file->code.size, HCC_HASH_FNV_64_INIT);
 	}
 
 	atomic_fetch_or(&code_file->flags, HCC_CODE_FILE_FLAGS_IS_LOADED);
@@ -1531,12 +1957,118 @@ HccResult hcc_code_file_init(HccCodeFile* code_file, HccString path_string, bool
 void hcc_code_file_deinit(HccCodeFile* code_file) {
 	hcc_stack_deinit(code_file->line_code_start_indices);
 	hcc_stack_deinit(code_file->pp_if_spans);
-	uintptr_t alloc_size = HCC_INT_ROUND_UP_ALIGN(code_file->code.size + _HCC_TOKENIZER_LOOK_HEAD_SIZE, _hcc_gs.virt_mem_reserve_align);
-	hcc_virt_mem_release(HCC_ALLOC_TAG_CODE, code_file->code.data, alloc_size);
+	hcc_code_file_release_code(code_file->code);
+}
+
+HccResult hcc_code_file_load_code(HccString path_string, HccString* code_out) {
+	//
+	// code files are copied instead of mapped as they are files the user is editing.
+	// an editor that truncates a file in place while it is mapped would make the tokenizer fault.
+	HccIIO iio;
+	if (!_hcc_gs.file_open_read_fn(path_string.data, &iio)) {
+		return HccResult(HCC_ERROR_FILE_OPEN_READ, 0, NULL);
+	}
+
+	uintptr_t alloc_size = HCC_INT_ROUND_UP_ALIGN(iio.size + _HCC_TOKENIZER_LOOK_HEAD_SIZE, _hcc_gs.virt_mem_reserve_align);
+	hcc_virt_mem_reserve_commit(HCC_ALLOC_TAG_CODE, NULL, alloc_size, HCC_VIRT_MEM_PROTECTION_READ_WRITE, (void**)&code_out->data);
+
+	uintptr_t read_size = hcc_iio_read(&iio, code_out->data, iio.size);
+	hcc_iio_close(&iio);
+	if (read_size == UINTPTR_MAX) {
+		hcc_virt_mem_release(HCC_ALLOC_TAG_CODE, code_out->data, alloc_size);
+		return HccResult(HCC_ERROR_FILE_READ, 0, NULL);
+	}
+
+	//
+	// the file may have shrunk since it was opened, the size will then differ from the stat
+	// so the next compile will load the file again. the bytes that were not read are still zeroed.
+	code_out->size = read_size;
+	return HCC_RESULT_SUCCESS;
+}
+
+void hcc_code_file_release_code(HccString code) {
+	uintptr_t alloc_size = HCC_INT_ROUND_UP_ALIGN(code.size + _HCC_TOKENIZER_LOOK_HEAD_SIZE, _hcc_gs.virt_mem_reserve_align);
+	hcc_virt_mem_release(HCC_ALLOC_TAG_CODE, code.data, alloc_size);
+}
+
+void hcc_code_file_reset_mutator_pass(HccCodeFile* code_file) {
+	hcc_stack_clear(code_file->line_code_start_indices);
+	*hcc_stack_push(code_file->line_code_start_indices) = 0;
+	*hcc_stack_push(code_file->line_code_start_indices) = 0;
+	hcc_stack_clear(code_file->pp_if_spans);
+	code_file->include_guard_string_id.idx_plus_one = 0;
+	atomic_store(&code_file->flags, HCC_CODE_FILE_FLAGS_IS_LOADED);
+}
+
+HccResult hcc_code_file_refresh(HccCodeFile* code_file) {
+	HccFileStat stat;
+	if (!_hcc_gs.file_stat_fn(code_file->path_string.data, &stat)) {
+		return HccResult(HCC_ERROR_FILE_OPEN_READ, 0, NULL);
+	}
+
+	if (stat.size != code_file->stat.size || !HCC_CMP_ELMT(&stat.modified_time, &code_file->stat.modified_time)) {
+		//
+		// the file has been written to, but it could have been saved without any changes.
+		// so load the code and only throw away the work of the mutator pass if the contents have changed.
+		HccString code;
+		HccResult result = hcc_code_file_load_code(code_file->path_string, &code);
+		if (!HCC_IS_SUCCESS(result)) {
+			return result;
+		}
+
+		HccHash64 code_hash = hcc_hash_fnv_64(code.data, code.size, HCC_HASH_FNV_64_INIT);
+		if (code_hash == code_file->code_hash && code.size == code_file->code.size && HCC_CMP_ELMT_MANY(code.data, code_file->code.data, code.size)) {
+			hcc_code_file_release_code(code);
+		} else {
+			hcc_code_file_release_code(code_file->code);
+			code_file->code = code;
+			code_file->code_hash = code_hash;
+			hcc_code_file_reset_mutator_pass(code_file);
+		}
+		code_file->stat = stat;
+	}
+
+	if (!(atomic_load(&code_file->flags) & HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS)) {
+		//
+		// a previous compile has stopped part way through the mutator pass (most likely from an error)
+		// so the line and preprocessor if span arrays are incomplete. the next time the file is parsed will do the mutator pass again.
+		hcc_code_file_reset_mutator_pass(code_file);
+	}
+
+	return HCC_RESULT_SUCCESS;
+}
+
+void hcc_code_files_refresh(void) {
+	if (_hcc_gs.file_stat_fn == NULL) {
+		//
+		// we have no way of knowing if the code files are up to date, so throw them all away
+		hcc_clear_code_files();
+		return;
+	}
+
+	for (uint32_t idx = 0; idx < hcc_hash_table_count(_hcc_gs.path_to_code_file_map); idx += 1) {
+		HccCodeFileEntry* entry = &_hcc_gs.path_to_code_file_map[idx];
+		if (!hcc_hash_table_is_elmt_used(_hcc_gs.path_to_code_file_map, idx)) {
+			continue;
+		}
+
+		if (!HCC_IS_SUCCESS(hcc_code_file_refresh(&entry->file))) {
+			//
+			// the file has been removed or can no longer be read.
+			// drop it so the next #include of the file reports the error.
+			hcc_code_file_deinit(&entry->file);
+			hcc_hash_table_remove(_hcc_gs.path_to_code_file_map, &entry->path_string);
+			HCC_ZERO_ELMT(entry);
+		}
+	}
 }
 
 HccCodeFile* hcc_code_file_find(HccString file_path) {
-	uintptr_t idx = hcc_hash_table_find_idx(_hcc_gs.path_to_code_file_map, &file_path);
+	return hcc_code_file_find_hashed(file_path, hcc_string_hash(file_path.data, file_path.size));
+}
+
+HccCodeFile* hcc_code_file_find_hashed(HccString file_path, HccHash file_path_hash) {
+	uintptr_t idx = hcc_hash_table_find_idx_hashed(_hcc_gs.path_to_code_file_map, &file_path, file_path_hash);
 	return idx == UINTPTR_MAX ? NULL : &_hcc_gs.path_to_code_file_map[idx].file;
 }
 
@@ -1573,6 +2105,147 @@ HccResult hcc_code_file_find_or_insert(HccString file_path, HccCodeFile** code_f
 	return result;
 }
 
+bool hcc_include_resolve_key_cmp(void* a, void* b, uintptr_t size) {
+	HCC_UNUSED(size);
+	HccIncludeResolveKey* a_ = a;
+	HccIncludeResolveKey* b_ = b;
+	return
+		a_->dir_path_string_id.idx_plus_one == b_->dir_path_string_id.idx_plus_one &&
+		a_->path_string_id.idx_plus_one == b_->path_string_id.idx_plus_one &&
+		a_->include_paths_hash == b_->include_paths_hash &&
+		a_->is_system == b_->is_system;
+}
+
+HccHash hcc_include_resolve_key_hash(void* key, uintptr_t size) {
+	HCC_DEBUG_ASSERT(size == sizeof(HccIncludeResolveKey), "key is not a HccIncludeResolveKey");
+
+	HccIncludeResolveKey* k = key;
+	HccHash hash = HCC_HASH_FNV_INIT;
+	hash = hcc_hash_fnv(&k->dir_path_string_id, sizeof(k->dir_path_string_id), hash);
+	hash = hcc_hash_fnv(&k->path_string_id, sizeof(k->path_string_id), hash);
+	hash = hcc_hash_fnv(&k->include_paths_hash, sizeof(k->include_paths_hash), hash);
+	hash = hcc_hash_fnv(&k->is_system, sizeof(k->is_system), hash);
+	return hash;
+}
+
+bool hcc_include_resolve_cache_find(HccIncludeResolveKey* key, HccString* canonical_path_out) {
+	uintptr_t found_idx = hcc_hash_table_find_idx(_hcc_gs.include_resolve_cache, key);
+	if (found_idx == UINTPTR_MAX) {
+		return false;
+	}
+
+	HccIncludeResolveEntry* entry = &_hcc_gs.include_resolve_cache[found_idx];
+	if (!atomic_load(&entry->is_ready)) {
+		return false;
+	}
+
+	*canonical_path_out = entry->canonical_path;
+	return true;
+}
+
+void hcc_include_resolve_cache_insert(HccIncludeResolveKey* key, HccString canonical_path, uint64_t dir_bits) {
+	//
+	// when the cache is getting full, just stop caching instead of running out of space
+	if (hcc_hash_table_count(_hcc_gs.include_resolve_cache) >= hcc_hash_table_reserve_cap(_hcc_gs.include_resolve_cache) / 2) {
+		return;
+	}
+
+	HccHashTableInsert insert = hcc_hash_table_find_insert_idx(_hcc_gs.include_resolve_cache, key);
+	if (insert.is_new) {
+		HccIncludeResolveEntry* entry = &_hcc_gs.include_resolve_cache[insert.idx];
+		entry->canonical_path = canonical_path;
+		entry->dir_bits = dir_bits;
+		atomic_store(&entry->is_ready, true);
+	}
+}
+
+uint64_t hcc_include_resolve_dir_bit(const char* file_path, uint32_t file_path_size) {
+	uint32_t dir_size = file_path_size;
+	while (dir_size) {
+		dir_size -= 1;
+		if (file_path[dir_size] == '/' || file_path[dir_size] == '\\') {
+			break;
+		}
+	}
+
+	//
+	// the directory path is stored with a null terminator so it can be passed to the OS
+	char dir_path[PATH_MAX];
+	if (dir_size == 0 && file_path[0] != '/' && file_path[0] != '\\') {
+		dir_path[0] = '.';
+		dir_size = 1;
+	} else {
+		dir_size = HCC_MAX(dir_size, 1);
+		if (dir_size >= sizeof(dir_path)) {
+			return 0;
+		}
+		memcpy(dir_path, file_path, dir_size);
+	}
+	dir_path[dir_size] = '\0';
+
+	HccStringId dir_path_string_id;
+	hcc_string_table_deduplicate(dir_path, dir_size + 1, &dir_path_string_id);
+
+	uintptr_t found_idx = hcc_hash_table_find_idx(_hcc_gs.include_resolve_dirs, &dir_path_string_id);
+	if (found_idx == UINTPTR_MAX) {
+		if (hcc_hash_table_count(_hcc_gs.include_resolve_dirs) >= hcc_hash_table_reserve_cap(_hcc_gs.include_resolve_dirs) / 2) {
+			return 0;
+		}
+
+		HccHashTableInsert insert = hcc_hash_table_find_insert_idx(_hcc_gs.include_resolve_dirs, &dir_path_string_id);
+		if (insert.is_new) {
+			HccIncludeResolveDirEntry* entry = &_hcc_gs.include_resolve_dirs[insert.idx];
+			if (!hcc_directory_modified_time(dir_path, &entry->modified_time)) {
+				HCC_ZERO_ELMT(&entry->modified_time);
+			}
+			atomic_store(&entry->is_ready, true);
+		}
+		found_idx = insert.idx;
+	}
+
+	return (uint64_t)1 << (found_idx % 64);
+}
+
+void hcc_include_resolve_cache_refresh(void) {
+	uint64_t modified_dir_bits = 0;
+	uint32_t dirs_count = hcc_hash_table_count(_hcc_gs.include_resolve_dirs);
+	for (uint32_t idx = 0; idx < dirs_count; idx += 1) {
+		HccIncludeResolveDirEntry* entry = &_hcc_gs.include_resolve_dirs[idx];
+		if (!atomic_load(&entry->is_ready)) {
+			continue;
+		}
+
+		HccString dir_path = hcc_string_table_get(entry->path_string_id);
+		HccTime modified_time;
+		if (!hcc_directory_modified_time(dir_path.data, &modified_time)) {
+			HCC_ZERO_ELMT(&modified_time);
+		}
+
+		if (!HCC_CMP_ELMT(&modified_time, &entry->modified_time)) {
+			entry->modified_time = modified_time;
+			modified_dir_bits |= (uint64_t)1 << (idx % 64);
+		}
+	}
+
+	if (modified_dir_bits == 0) {
+		return;
+	}
+
+	uint32_t entries_count = hcc_hash_table_count(_hcc_gs.include_resolve_cache);
+	for (uint32_t idx = 0; idx < entries_count; idx += 1) {
+		HccIncludeResolveEntry* entry = &_hcc_gs.include_resolve_cache[idx];
+		if (atomic_load(&entry->is_ready) && (entry->dir_bits & modified_dir_bits)) {
+			hcc_hash_table_remove(_hcc_gs.include_resolve_cache, &entry->key);
+			HCC_ZERO_ELMT(entry);
+		}
+	}
+}
+
+void hcc_include_resolve_cache_clear(void) {
+	hcc_hash_table_clear(_hcc_gs.include_resolve_cache);
+	hcc_hash_table_clear(_hcc_gs.include_resolve_dirs);
+}
+
 HccString hcc_code_file_path_string(HccCodeFile* code_file) {
 	return code_file->path_string;
 }
@@ -1646,10 +2319,13 @@ HccSetup hcc_setup_default = {
 	.alloc_event_userdata = NULL,
 	.path_canonicalize_fn = hcc_path_canonicalize_internal,
 	.file_open_read_fn = hcc_file_open_read,
+	.file_stat_fn = hcc_file_stat,
 	.string_table_data_grow_count = 1048576,   // 1MB
 	.string_table_data_reserve_cap = 67108864, // 64MB
-	.string_table_entries_cap = 1048576,
-	.code_files_cap = 8192,
+	.string_table_entries_cap = 65536,
+	.code_files_cap = 1024,
+	.include_resolve_cache_cap = 1024,
+	.include_resolve_dirs_cap = 256,
 	.code_file_lines_grow_count = 512,
 	.code_file_lines_reserve_cap = 131072,
 	.code_file_pp_if_spans_grow_count = 256,
@@ -1662,13 +2338,19 @@ HccResult hcc_init(HccSetup* setup) {
 	_hcc_gs.alloc_event_userdata = setup->alloc_event_userdata;
 	_hcc_gs.path_canonicalize_fn = setup->path_canonicalize_fn;
 	_hcc_gs.file_open_read_fn = setup->file_open_read_fn;
+	_hcc_gs.file_stat_fn = setup->file_stat_fn;
 	HCC_SET_BAIL_JMP_LOC_GLOBAL();
 
 	hcc_virt_mem_update_page_size_reserve_align();
+	_hcc_gs.logical_cores_count = hcc_logical_cores_count();
+	hcc_mem_tracker_init();
+	hcc_virt_mem_prefaulter_init();
 	hcc_arena_alctor_init(&_hcc_gs.arena_alctor, HCC_ALLOC_TAG_GLOBAL_MEM_ARENA, setup->global_mem_arena_size);
 	hcc_string_table_init(&_hcc_gs.string_table, setup->string_table_data_grow_count, setup->string_table_data_reserve_cap, setup->string_table_entries_cap);
 
-	_hcc_gs.path_to_code_file_map = hcc_hash_table_init(HccCodeFileEntry, 0, hcc_string_key_cmp, hcc_string_key_hash, setup->code_files_cap);
+	_hcc_gs.path_to_code_file_map = hcc_hash_table_init(HccCodeFileEntry, HCC_ALLOC_TAG_PATH_TO_CODE_FILE_MAP, hcc_string_key_cmp, hcc_string_key_hash, setup->code_files_cap);
+	_hcc_gs.include_resolve_cache = hcc_hash_table_init(HccIncludeResolveEntry, HCC_ALLOC_TAG_INCLUDE_RESOLVE_CACHE, hcc_include_resolve_key_cmp, hcc_include_resolve_key_hash, setup->include_resolve_cache_cap);
+	_hcc_gs.include_resolve_dirs = hcc_hash_table_init(HccIncludeResolveDirEntry, HCC_ALLOC_TAG_INCLUDE_RESOLVE_DIRS, hcc_u32_key_cmp, hcc_u32_key_hash, setup->include_resolve_dirs_cap);
 	_hcc_gs.code_file_lines_grow_count = setup->code_file_lines_grow_count;
 	_hcc_gs.code_file_lines_reserve_cap = setup->code_file_lines_reserve_cap;
 	_hcc_gs.code_file_pp_if_spans_grow_count = setup->code_file_pp_if_spans_grow_count;
@@ -1681,13 +2363,17 @@ HccResult hcc_init(HccSetup* setup) {
 void hcc_deinit(void) {
 	hcc_arena_alctor_deinit(&_hcc_gs.arena_alctor);
 	hcc_string_table_deinit(&_hcc_gs.string_table);
-	for (uint32_t idx = 0; idx < hcc_hash_table_cap(_hcc_gs.path_to_code_file_map); idx += 1) {
+	for (uint32_t idx = 0; idx < hcc_hash_table_count(_hcc_gs.path_to_code_file_map); idx += 1) {
 		HccCodeFileEntry* entry = &_hcc_gs.path_to_code_file_map[idx];
-		if (entry->path_string.data) {
+		if (hcc_hash_table_is_elmt_used(_hcc_gs.path_to_code_file_map, idx)) {
 			hcc_code_file_deinit(&entry->file);
 		}
 	}
 	hcc_hash_table_deinit(_hcc_gs.path_to_code_file_map);
+	hcc_hash_table_deinit(_hcc_gs.include_resolve_cache);
+	hcc_hash_table_deinit(_hcc_gs.include_resolve_dirs);
+	hcc_virt_mem_prefaulter_deinit();
+	hcc_mem_tracker_deinit();
 }
 
 HccResult hcc_clear_global_mem_arena(void) {
@@ -1702,13 +2388,14 @@ HccResult hcc_clear_global_mem_arena(void) {
 HccResult hcc_clear_code_files(void) {
 	HCC_SET_BAIL_JMP_LOC_GLOBAL();
 
-	for (uint32_t idx = 0; idx < hcc_hash_table_cap(_hcc_gs.path_to_code_file_map); idx += 1) {
+	for (uint32_t idx = 0; idx < hcc_hash_table_count(_hcc_gs.path_to_code_file_map); idx += 1) {
 		HccCodeFileEntry* entry = &_hcc_gs.path_to_code_file_map[idx];
-		if (entry->path_string.data) {
+		if (hcc_hash_table_is_elmt_used(_hcc_gs.path_to_code_file_map, idx)) {
 			hcc_code_file_deinit(&entry->file);
 		}
 	}
 	hcc_hash_table_clear(_hcc_gs.path_to_code_file_map);
+	hcc_include_resolve_cache_clear();
 
 	hcc_clear_bail_jmp_loc();
 	return HCC_RESULT_SUCCESS;
@@ -197,9 +197,12 @@ enum HccAllocTag {
 	HCC_ALLOC_TAG_NONE,
 	HCC_ALLOC_TAG_GLOBAL_MEM_ARENA,
 	HCC_ALLOC_TAG_CODE,
+	HCC_ALLOC_TAG_MEM_TRACKER,
+	HCC_ALLOC_TAG_VIRT_MEM_PREFAULTER,
 	HCC_ALLOC_TAG_STRING_TABLE_ENTRIES,
 	HCC_ALLOC_TAG_STRING_TABLE_DATA,
 	HCC_ALLOC_TAG_STRING_TABLE_ID_TO_ENTRY_MAP,
+	HCC_ALLOC_TAG_WORKERS,
 	HCC_ALLOC_TAG_WORKER_CALL_STACKS,
 	HCC_ALLOC_TAG_WORKER_JOB_QUEUE,
 	HCC_ALLOC_TAG_ATA_TEXT,
@@ -214,12 +217,26 @@ enum HccAllocTag {
 	HCC_ALLOC_TAG_WORKER_STRING_BUFFER,
 	HCC_ALLOC_TAG_WORKER_ARENA,
 
+	HCC_ALLOC_TAG_OPTION_DEFINES,
+	HCC_ALLOC_TAG_TASK_INCLUDE_PATH_STRINGS,
+	HCC_ALLOC_TAG_MESSAGE_SYS_ELMTS,
+	HCC_ALLOC_TAG_MESSAGE_SYS_LOCATIONS,
+	HCC_ALLOC_TAG_MESSAGE_SYS_STRINGS,
+	HCC_ALLOC_TAG_PATH_TO_CODE_FILE_MAP,
+	HCC_ALLOC_TAG_INCLUDE_RESOLVE_CACHE,
+	HCC_ALLOC_TAG_INCLUDE_RESOLVE_DIRS,
+	HCC_ALLOC_TAG_CODE_FILE_LINE_CODE_START_INDICES,
+	HCC_ALLOC_TAG_CODE_FILE_PP_IF_SPANS,
+	HCC_ALLOC_TAG_CONSTANT_TABLE_ENTRIES,
+	HCC_ALLOC_TAG_CONSTANT_TABLE_DATA,
+
 	HCC_ALLOC_TAG_CU_SHADER_FUNCTION_DECLS,
 	HCC_ALLOC_TAG_CU_RESOURCE_STRUCTS,
 	HCC_ALLOC_TAG_CU_GLOBAL_DECLARATIONS,
 	HCC_ALLOC_TAG_CU_STRUCT_DECLARATIONS,
 	HCC_ALLOC_TAG_CU_UNION_DECLARATIONS,
 	HCC_ALLOC_TAG_CU_ENUM_DECLARATIONS,
+	HCC_ALLOC_TAG_CU_WORKER_STACK_CHUNKS,
 
 	HCC_ALLOC_TAG_DATA_TYPE_TABLE_ARRAYS,
 	HCC_ALLOC_TAG_DATA_TYPE_TABLE_COMPOUNDS,
@@ -245,6 +262,7 @@ enum HccAllocTag {
 	HCC_ALLOC_TAG_AST_FILE_PRAGMA_ONCED_FILES,
 	HCC_ALLOC_TAG_AST_FILE_UNIQUE_INCLUDED_FILES,
 	HCC_ALLOC_TAG_AST_FORWARD_DECLARTIONS_TO_LINK,
+	HCC_ALLOC_TAG_AST_FILE_INCLUDE_EFFECTS,
 	HCC_ALLOC_TAG_AST_FILE_GLOBAL_DECLARATIONS,
 	HCC_ALLOC_TAG_AST_FILE_STRUCT_DECLARATIONS,
 	HCC_ALLOC_TAG_AST_FILE_UNION_DECLARATIONS,
@@ -257,6 +275,10 @@ enum HccAllocTag {
 	HCC_ALLOC_TAG_AST_GLOBAL_VARIBALES,
 	HCC_ALLOC_TAG_AST_FORWARD_DECLARTIONS,
 	HCC_ALLOC_TAG_AST_DESIGNATED_INITIALIZER_ELMT_INDICES,
+	HCC_ALLOC_TAG_AST_FUNCTION_CALLEES,
+	HCC_ALLOC_TAG_AST_REACHABLE_FUNCTION_DECLS,
+	HCC_ALLOC_TAG_AST_UNLINKED_REACHABLE_FUNCTION_DECLS,
+	HCC_ALLOC_TAG_AST_INCLUDE_CACHE,
 
 	HCC_ALLOC_TAG_AML_FUNCTION_ALCTOR_NODES_POOL,
 	HCC_ALLOC_TAG_AML_FUNCTION_ALCTOR_WORDS_POOL,
@@ -269,6 +291,9 @@ enum HccAllocTag {
 	HCC_ALLOC_TAG_AML_CALL_GRAPH_NODES,
 	HCC_ALLOC_TAG_AML_OPIMIZE_FUNCTIONS,
 	HCC_ALLOC_TAG_AML_FUNCTION_CALL_NODE_LISTS,
+	HCC_ALLOC_TAG_AML_CALL_GRAPH_DEPS,
+	HCC_ALLOC_TAG_AML_CALL_GRAPH_WAITING_NODES,
+	HCC_ALLOC_TAG_AML_CALL_GRAPH_MADE_DECLS,
 
 	HCC_ALLOC_TAG_SPIRV_FUNCTIONS,
 	HCC_ALLOC_TAG_SPIRV_FUNCTION_WORDS,
@@ -292,6 +317,7 @@ enum HccAllocTag {
 	HCC_ALLOC_TAG_PPGEN_MACRO_ARGS_STACK,
 	HCC_ALLOC_TAG_ATAGEN_PAUSED_FILE_STACK,
 	HCC_ALLOC_TAG_ATAGEN_OPEN_BRACKET_STACK,
+	HCC_ALLOC_TAG_ATAGEN_INCLUDE_RECORDING_STACK,
 
 	HCC_ALLOC_TAG_ASTGEN_VARIABLE_STACK_STRINGS,
 	HCC_ALLOC_TAG_ASTGEN_VARIABLE_STACK,
@@ -301,9 +327,11 @@ enum HccAllocTag {
 	HCC_ALLOC_TAG_ASTGEN_COMPOUND_FIELDS,
 	HCC_ALLOC_TAG_ASTGEN_FUNCTION_PARAMS_AND_VARIABLES,
 	HCC_ALLOC_TAG_ASTGEN_ENUM_VALUES,
+	HCC_ALLOC_TAG_ASTGEN_FUNCTION_CALLEES,
 	HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_NESTED,
 	HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_NESTED_CURLYS,
 	HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_NESTED_ELMTS,
+	HCC_ALLOC_TAG_ASTGEN_CURLY_INITIALIZER_COMPOSITE_CONSTANT_IDS,
 
 	HCC_ALLOC_TAG_SPIRVLINK_WORDS,
 
@@ -324,15 +352,35 @@ typedef struct HccTrackedMem HccTrackedMem;
 struct HccTrackedMem {
 	HccAllocTag tag;
 	void*       addr;
-	uintptr_t   size;
+	uintptr_t   size;           // the size of the reserved address space
+	uintptr_t   committed_size; // how much of the reserved address space has been committed
+};
+
+typedef struct HccMemTrackerTagStats HccMemTrackerTagStats;
+struct HccMemTrackerTagStats {
+	uintptr_t reserved_size;
+	uintptr_t committed_size;
+	uintptr_t reserved_size_high_water_mark;
+	uintptr_t committed_size_high_water_mark;
+	uint32_t  reservations_count;
 };
 
+//
+// the live and peak sizes of all the virtual memory allocated with this tag since hcc_init
+void hcc_mem_tracker_tag_stats(HccAllocTag tag, HccMemTrackerTagStats* out);
+
 typedef struct HccMemTrackerIter HccMemTrackerIter;
 
+//
+// iterates over all the virtual memory reservations that are still alive.
+// the memory tracker is locked from start to finish, so other threads that allocate will wait
+// and the iterating thread must not allocate or release any memory itself.
 HccMemTrackerIter* hcc_mem_tracker_iter_start(void);
 void hcc_mem_tracker_iter_finish(HccMemTrackerIter* iter);
 bool hcc_mem_tracker_iter_next(HccMemTrackerIter* iter, HccTrackedMem* out);
 
+//
+// writes out a table of the live and peak sizes of every tag that has been used
 void hcc_mem_tracker_log(HccIIO* iio);
 
 // ===========================================
@@ -1714,7 +1762,7 @@ typedef struct HccConstantTableSetup HccConstantTableSetup;
 struct HccConstantTableSetup {
 	uint32_t data_grow_size;
 	uint32_t data_reserve_size;
-	uint32_t entries_cap;
+	uint32_t entries_cap; // initial capacity of the constant table, it grows when it is full
 };
 
 typedef struct HccConstant HccConstant;
@@ -2250,6 +2298,8 @@ struct HccASTFileSetup {
 	uint32_t unique_include_files_reserve_cap;
 	uint32_t forward_declarations_to_link_grow_count;
 	uint32_t forward_declarations_to_link_reserve_cap;
+	uint32_t include_effects_grow_count;
+	uint32_t include_effects_reserve_cap;
 };
 
 HccString hcc_ast_file_get_path(HccASTFile* file);
@@ -2286,6 +2336,7 @@ struct HccASTSetup {
 	uint32_t        forward_declarations_reserve_cap;
 	uint32_t        designated_initializer_elmt_indices_grow_count;
 	uint32_t        designated_initializer_elmt_indices_reserve_cap;
+	uint32_t        include_cache_cap; // initial capacity of the cached header token streams shared by all files in the compilation unit, it grows when it is full
 };
 
 // ===========================================
@@ -2695,6 +2746,8 @@ struct HccCUSetup {
 	uint32_t              functions_reserve_cap;
 	uint32_t              function_params_and_variables_grow_count;
 	uint32_t              function_params_and_variables_reserve_cap;
+	uint32_t              function_callees_grow_count;
+	uint32_t              function_callees_reserve_cap;
 };
 
 HccDataTypeTable* hcc_cu_get_data_type_table(HccCU* cu);
@@ -2880,6 +2933,12 @@ void hcc_task_deinit(HccTask* t);
 void hcc_task_set_final_worker_job_type(HccTask* t, HccWorkerJobType final_worker_job_type);
 
 HccResult hcc_task_add_include_path(HccTask* t, HccString path);
+
+//
+// sets the directory that precompiled headers are written to and loaded from.
+// an included file is stored as a precompiled header when it is tokenized, so the next compile that includes it
+// with the same macros defined can load it's tokens instead of tokenizing it again.
+HccResult hcc_task_set_pch_dir(HccTask* t, HccString path);
 HccResult hcc_task_add_input_code_file(HccTask* t, const char* file_path, HccOptions* options);
 
 HccResult hcc_task_add_output_ast_text(HccTask* t, HccIIO* iio);
@@ -2919,7 +2978,7 @@ struct HccPPGenSetup {
 	uint32_t stringify_buffer_reserve_cap;
 	uint32_t if_stack_grow_count;
 	uint32_t if_stack_reserve_cap;
-	uint32_t macro_declarations_cap;
+	uint32_t macro_declarations_cap; // initial capacity of each worker macro table, it grows when it is full
 	uint32_t macro_args_stack_grow_count;
 	uint32_t macro_args_stack_reserve_cap;
 };
@@ -2931,6 +2990,11 @@ struct HccATAGenSetup {
 	uint32_t      paused_file_stack_reserve_cap;
 	uint32_t      open_bracket_stack_grow_count;
 	uint32_t      open_bracket_stack_reserve_cap;
+	uint32_t      include_recording_stack_grow_count;
+	uint32_t      include_recording_stack_reserve_cap;
+	uint32_t      pch_elmts_grow_count;
+	uint32_t      pch_elmts_reserve_cap;
+	uint32_t      pch_idx_map_cap; // initial capacity of each worker precompiled header index map, it grows when it is full
 };
 
 typedef struct HccASTGenSetup HccASTGenSetup;
@@ -2939,6 +3003,8 @@ struct HccASTGenSetup {
 	uint32_t variable_stack_reserve_cap;
 	uint32_t compound_fields_reserve_cap;
 	uint32_t function_params_and_variables_reserve_cap;
+	uint32_t function_callees_grow_count;
+	uint32_t function_callees_reserve_cap;
 	uint32_t enum_values_reserve_cap;
 	uint32_t curly_initializer_nested_reserve_cap;
 	uint32_t curly_initializer_nested_curlys_reserve_cap;
@@ -2974,16 +3040,26 @@ struct HccCompilerSetup {
 	uint32_t            worker_string_buffer_reserve_size;
 	uint32_t            worker_arena_size;
 	uint32_t            workers_count;
-	uint32_t            worker_jobs_queue_cap;
+	uint32_t            worker_jobs_queue_cap; // initial capacity of each worker job deque, they grow when they are full
 	uint32_t            worker_call_stack_size;
+	uint32_t*           worker_core_indices;         // optional, worker N only runs on logical core worker_core_indices[N % worker_core_indices_count]
+	uint32_t            worker_core_indices_count;
 };
 
 extern HccCompilerSetup hcc_compiler_setup_default;
 
 HccResult hcc_compiler_init(HccCompilerSetup* setup, HccCompiler** c_out);
 HccResult hcc_compiler_deinit(HccCompiler* c);
+//
+// a task can be dispatched again once it has completed, it reuses the memory from its last dispatch.
+// the worker arenas are not reset by a dispatch, so dispatching again and again grows them
+// unless hcc_compiler_clear_mem_arenas is called in between.
 HccResult hcc_compiler_dispatch_task(HccCompiler* c, HccTask* t);
 HccResult hcc_compiler_wait_for_all_tasks(HccCompiler* c);
+//
+// resets the worker arenas. the locations in the messages of every task that has run and the declarations
+// of their compilation units live in these arenas, so only call this when no tasks are running
+// and the results of the tasks that have finished are no longer needed.
 HccResult hcc_compiler_clear_mem_arenas(HccCompiler* c);
 HccDuration hcc_compiler_duration(HccCompiler* c); // total duration from when the compiler started, must be called when the compiler is complete
 HccDuration hcc_compiler_worker_job_type_duration(HccCompiler* c, HccWorkerJobType type); // duration spent on the compiler by the workers for this job type, must be called when the compiler is complete
@@ -3063,10 +3139,32 @@ typedef uint32_t HccFlags;
 enum HccFlags {
 	HCC_FLAGS_NONE =              0x0,
 	HCC_FLAGS_ENABLE_STACKTRACE = 0x1,
+
+	//
+	// ask the OS to back the large virtual memory reservations with huge pages to cut down on TLB misses.
+	// these are the string table, token bags, AML function pools, SPIR-V link words and other big tables.
+	// only Linux (transparent huge pages) is supported right now, otherwise this does nothing.
+	HCC_FLAGS_ENABLE_HUGE_PAGES = 0x2,
+
+	//
+	// large commits of virtual memory get their physical pages allocated on a background thread,
+	// so the compiler threads take less page faults when they first write to them.
+	// only Linux 5.14 and later (MADV_POPULATE_WRITE) is supported right now, otherwise this does nothing.
+	HCC_FLAGS_ENABLE_PREFAULT =   0x4,
+};
+
+typedef struct HccFileStat HccFileStat;
+struct HccFileStat {
+	HccTime  modified_time;
+	uint64_t size;
 };
 
 typedef uint32_t (*HccPathCanonicalizeFn)(const char* path, char* out_buf);
 typedef bool (*HccFileOpenReadFn)(const char* path, HccIIO* out);
+//
+// used to see if a code file has changed on disk since the last compile.
+// when this is NULL the code files are thrown away at the start of every compile.
+typedef bool (*HccFileStatFn)(const char* path, HccFileStat* out);
 
 typedef struct HccSetup HccSetup;
 struct HccSetup {
@@ -3075,11 +3173,14 @@ struct HccSetup {
 	HccAllocEventFn        alloc_event_fn;
 	HccPathCanonicalizeFn  path_canonicalize_fn;
 	HccFileOpenReadFn      file_open_read_fn;
+	HccFileStatFn          file_stat_fn;
 	void*                  alloc_event_userdata;
 	uint32_t               string_table_data_grow_count;
 	uint32_t               string_table_data_reserve_cap;
-	uint32_t               string_table_entries_cap;
-	uint32_t               code_files_cap;
+	uint32_t               string_table_entries_cap;  // initial capacity of the string table, it grows when it is full
+	uint32_t               code_files_cap;            // initial capacity of the code file map, it grows when it is full
+	uint32_t               include_resolve_cache_cap; // initial capacity of the include resolve cache, it grows when it is full
+	uint32_t               include_resolve_dirs_cap;  // initial capacity of the include resolve directories, it grows when it is full
 	uint32_t               code_file_lines_grow_count;
 	uint32_t               code_file_lines_reserve_cap;
 	uint32_t               code_file_pp_if_spans_grow_count;
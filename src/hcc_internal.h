@@ -6,6 +6,8 @@
 #include <stdatomic.h>
 #if defined(HCC_ARCH_X86_64)
 #include <immintrin.h>
+#elif defined(HCC_ARCH_AARCH64)
+#include <arm_neon.h>
 #endif
 #include <signal.h>
 #include <stdarg.h>
@@ -203,18 +205,34 @@ uint32_t hcc_mostsetbitidx32(uint32_t bits);
 void hcc_get_last_system_error_string(char* buf_out, uint32_t buf_out_size);
 uint32_t hcc_path_canonicalize_internal(const char* path, char* out_buf);
 HccString hcc_path_canonicalize(const char* path);
+//
+// these store the path in the string table instead of the global arena, so the same path
+// is only ever stored once no matter how many times it is looked up between compiles.
+// an empty string is returned if the path cannot be canonicalized or does not fit in PATH_MAX.
+HccString hcc_path_canonicalize_deduplicate(const char* path);
+HccString hcc_path_deduplicate(const char* path, uint32_t path_size);
 bool hcc_path_is_absolute(const char* path);
 char* hcc_file_read_all_the_codes(const char* path, uint64_t* size_out);
 void hcc_stacktrace(uint32_t ignore_levels_count, char* buf, uint32_t buf_size);
 bool hcc_file_open_read(const char* path, HccIIO* out);
 bool hcc_file_open_write(const char* path, HccIIO* out);
+bool hcc_file_stat(const char* path, HccFileStat* out);
 bool hcc_path_is_relative(const char* path);
 bool hcc_path_exists(const char* path);
 bool hcc_path_is_file(const char* path);
 bool hcc_path_is_directory(const char* path);
+//
+// the modified time of a directory changes when a file is created, removed or renamed inside of it.
+// returns false if @param(path) is not a directory.
+bool hcc_directory_modified_time(const char* path, HccTime* out);
 bool hcc_make_directory(const char* path);
+bool hcc_path_rename(const char* src_path, const char* dst_path);
+bool hcc_path_remove(const char* path);
+uint32_t hcc_process_id(void);
 HccString hcc_path_replace_file_name(HccString parent, HccString file_name);
 uint32_t hcc_logical_cores_count(void);
+uint32_t hcc_available_logical_cores(uint32_t* core_indices_out, uint32_t core_indices_cap); // writes the index of each logical core this process is allowed to run on (eg. when restricted by taskset or a cpuset) and returns how many there are
+uint32_t hcc_available_logical_cores_count(void);
 int hcc_execute_shell_command(const char* shell_command);
 void hcc_register_segfault_handler(void);
 
@@ -352,6 +370,7 @@ struct HccThreadSetup {
 	void*           arg;
 	void*           call_stack;
 	uintptr_t       call_stack_size;
+	uint32_t        core_idx_plus_one; // the logical core the thread only runs on, 0 lets it run on any of them
 };
 
 void hcc_thread_start(HccThread* thread, HccThreadSetup* setup);
@@ -368,7 +387,8 @@ void hcc_thread_wait_for_termination(HccThread* thread);
 typedef struct HccSemaphore HccSemaphore;
 struct HccSemaphore {
 	HccAtomic(uint32_t) value;
-	HccAtomic(uint32_t) waiters_count;
+	HccAtomic(uint32_t) waiters_count;  // threads that are in hcc_semaphore_take_or_wait_then_take
+	HccAtomic(uint32_t) sleepers_count; // threads that are sleeping in the kernel, hcc_semaphore_give only wakes up when this is non zero
 };
 
 void hcc_semaphore_init(HccSemaphore* semaphore, uint32_t initial_value);
@@ -403,9 +423,16 @@ void hcc_spin_mutex_unlock(HccSpinMutex* mutex);
 //
 // ===========================================
 
+typedef uint32_t HccMutexState;
+enum HccMutexState {
+	HCC_MUTEX_STATE_UNLOCKED,
+	HCC_MUTEX_STATE_LOCKED,
+	HCC_MUTEX_STATE_LOCKED_WITH_SLEEPERS,
+};
+
 typedef struct HccMutex HccMutex;
 struct HccMutex {
-	HccAtomic(uint32_t) is_locked;
+	HccAtomic(HccMutexState) state;
 };
 
 void hcc_mutex_init(HccMutex* mutex);
@@ -421,9 +448,29 @@ void hcc_mutex_unlock(HccMutex* mutex);
 //
 // ===========================================
 
+//
+// the max number of live reservations that can be iterated over, any more are still counted in the tag stats
+#define HCC_MEM_TRACKER_RECORDS_CAP 65536
+
+struct HccMemTrackerIter {
+	uint32_t next_idx;
+};
+
+typedef struct HccMemTracker HccMemTracker;
+struct HccMemTracker {
+	HccSpinMutex          mutex;
+	HccTrackedMem*        records;         // the live reservations sorted from the highest address to the lowest
+	uint32_t              records_count;
+	uint32_t              records_cap;
+	uint32_t              untracked_count; // live reservations that did not fit in the records
+	HccMemTrackerIter     iter;
+	HccMemTrackerTagStats tag_stats[HCC_ALLOC_TAG_COUNT];
+};
+
 void hcc_mem_tracker_init(void);
 void hcc_mem_tracker_deinit(void);
 void hcc_mem_tracker_update(HccAllocMode mode, HccAllocTag tag, void* addr, uintptr_t size);
+void hcc_mem_tracker_update_committed(HccAllocTag tag, void* addr, uintptr_t size, bool is_commit);
 
 // ===========================================
 //
@@ -445,6 +492,15 @@ struct HccArenaAlctor {
 	HccAtomic(HccArenaHeader*) arena;
 	HccAtomic(bool) alloc_arena_sync_point;
 	HccAllocTag     tag;
+	HccArenaHeader* free_arenas; // arenas that have been given back by a reset or restore, reused before reserving new ones. linked with prev
+};
+
+//
+// a position in an arena allocator that it can be rolled back to with hcc_arena_alctor_restore
+typedef struct HccArenaMarker HccArenaMarker;
+struct HccArenaMarker {
+	HccArenaHeader* arena;
+	uint32_t        pos;
 };
 
 HccArenaHeader* hcc_arena_alloc(HccAllocTag tag, uint32_t arena_size);
@@ -452,6 +508,16 @@ void hcc_arena_alctor_init(HccArenaAlctor* alctor, HccAllocTag tag, uint32_t are
 void hcc_arena_alctor_deinit(HccArenaAlctor* alctor);
 void* hcc_arena_alctor_alloc(HccArenaAlctor* alctor, uint32_t size, uint32_t align);
 void* hcc_arena_alctor_alloc_thread_safe(HccArenaAlctor* alctor, uint32_t size, uint32_t align);
+
+//
+// frees everything that was allocated after the marker was saved, for scratch memory that is only needed for a short while.
+// the freed memory is zeroed so the allocator still hands out zeroed memory like a fresh arena.
+// these must not be called while other threads are allocating from the same arena allocator.
+HccArenaMarker hcc_arena_alctor_save(HccArenaAlctor* alctor);
+void hcc_arena_alctor_restore(HccArenaAlctor* alctor, HccArenaMarker marker);
+
+//
+// frees everything in the arena allocator, the first arena is kept and the rest are kept for reuse
 void hcc_arena_alctor_reset(HccArenaAlctor* alctor);
 #define HCC_ARENA_ALCTOR_ALLOC_ELMT(T, alctor) hcc_arena_alctor_alloc(alctor, sizeof(T), alignof(T))
 #define HCC_ARENA_ALCTOR_ALLOC_ARRAY(T, alctor, count) hcc_arena_alctor_alloc(alctor, sizeof(T) * count, alignof(T))
@@ -626,6 +692,39 @@ void hcc_virt_mem_reset(HccAllocTag tag, void* addr, uintptr_t size);
 //
 void hcc_virt_mem_force_physical_page_allocation(void* addr, uintptr_t size);
 
+//
+// a background thread that allocates the physical pages for large commits of virtual memory
+// before the compiler threads get to them. see HCC_FLAGS_ENABLE_PREFAULT
+#define HCC_VIRT_MEM_PREFAULTER_QUEUE_CAP 256
+#define HCC_VIRT_MEM_PREFAULTER_CALL_STACK_SIZE 65536
+
+typedef struct HccVirtMemPrefaultRange HccVirtMemPrefaultRange;
+struct HccVirtMemPrefaultRange {
+	void*     addr;
+	uintptr_t size;
+};
+
+typedef struct HccVirtMemPrefaulter HccVirtMemPrefaulter;
+struct HccVirtMemPrefaulter {
+	HccThread               thread;
+	HccSemaphore            semaphore; // given once for every range that is queued and once more to stop the thread
+	HccSpinMutex            mutex;
+	HccAtomic(bool)         is_running;
+	uint32_t                queue_head_idx;
+	uint32_t                queue_count;
+	HccVirtMemPrefaultRange queue[HCC_VIRT_MEM_PREFAULTER_QUEUE_CAP];
+	void*                   call_stack;
+};
+
+void hcc_virt_mem_prefaulter_init(void);
+void hcc_virt_mem_prefaulter_deinit(void);
+
+//
+// queues the pages to be physically allocated on the prefaulter thread.
+// this is only a hint, the range is dropped when the queue is full or the prefaulter is not running.
+// it is fine for the range to be decommitted or released before the prefaulter gets to it.
+void hcc_virt_mem_prefault(void* addr, uintptr_t size);
+
 //
 // creates a magic ring buffer using virtual memory. the ring buffer will be of @param(size)
 // in bytes in physical memory but take up twice the address space. we use virtual memory to map/mirror
@@ -658,6 +757,31 @@ void hcc_virt_mem_magic_ring_buffer_alloc(HccAllocTag tag, void* requested_addr,
 //
 void hcc_virt_mem_magic_ring_buffer_dealloc(HccAllocTag tag, void* addr, uintptr_t size);
 
+//
+// maps a file into memory as a private copy on write mapping so it does not have to be read into a new allocation.
+// the rest of the last page of the file and the whole of @param(zeroed_tail_size) after it are zeroed,
+// the zeroed tail is an anonymous mapping directly after the file's pages when the file ends too close to a page boundary.
+// writes to the memory are never written back to the file.
+//
+// WARNING: if the file is truncated while it is mapped, accessing the pages that are past the new end of the file will fault.
+//          only map files that are replaced by renaming a new file over them, never ones that are edited in place.
+//
+// @param(path): the path to the file you wish to map
+//
+// @param(zeroed_tail_size): the number of zeroed bytes that must follow the last byte of the file.
+//
+// @param(addr_out) a pointer to a value that is set to the start of the mapped file
+//     when this function returns successfully.
+//
+// @param(size_out) a pointer to a value that is set to the size of the file
+//     when this function returns successfully.
+//
+// @return: false if the file could not be mapped, you can fall back to reading the file instead.
+//     release the memory with hcc_virt_mem_release and a size of @param(size_out) + @param(zeroed_tail_size)
+//     rounded up to the reserve_align that is retrieved from hcc_virt_mem_reserve_align.
+//
+bool hcc_virt_mem_map_file(HccAllocTag tag, const char* path, uintptr_t zeroed_tail_size, void** addr_out, uint64_t* size_out);
+
 // ===========================================
 //
 //
@@ -686,6 +810,34 @@ static inline HccString hcc_string_slice(HccString string, uintptr_t start, uint
 
 bool hcc_string_key_cmp(void* a, void* b, uintptr_t size);
 
+//
+// these scan a chunk of bytes at a time using SSE2 or AVX2 on x86_64 and NEON on aarch64.
+// they never read past data + size so they are safe on strings that are not padded.
+//
+
+//
+// returns the index of the first byte that is any of a, b, c or d, otherwise size is returned.
+// pass the same byte more than once to search for fewer bytes.
+uint32_t hcc_bytes_find_any_4(const char* data, uint32_t size, char a, char b, char c, char d);
+
+static inline uint32_t hcc_bytes_find(const char* data, uint32_t size, char byte) {
+	return hcc_bytes_find_any_4(data, size, byte, byte, byte, byte);
+}
+
+//
+// returns the number of ' ' and '\t' bytes at the start of data
+uint32_t hcc_bytes_count_spaces(const char* data, uint32_t size);
+
+//
+// returns the number of [a-zA-Z0-9_] bytes at the start of data
+uint32_t hcc_bytes_count_ident(const char* data, uint32_t size);
+
+//
+// pushes @param(base_idx) + the index after every '\n' in data on to @param(line_starts), a HccStack(uint32_t), when it is not NULL.
+// the line starts of a chunk are all pushed at once from the mask of the newlines in it.
+// returns the number of newlines found and if there are any, @param(last_line_start_idx_out) is set to the last line start.
+uint32_t hcc_bytes_push_line_starts(const char* data, uint32_t size, uint32_t base_idx, uint32_t* line_starts, uint32_t* last_line_start_idx_out);
+
 // ===========================================
 //
 //
@@ -719,6 +871,19 @@ typedef HccHash64 (*HccHash64Fn)(void* data, HccHash64 hash);
 HccHash32 hcc_hash_fnv_32(const void* data, uintptr_t size, HccHash32 hash);
 HccHash64 hcc_hash_fnv_64(const void* data, uintptr_t size, HccHash64 hash);
 
+//
+// a wyhash style hash that reads 8 bytes at a time and is much faster than FNV on anything but the shortest data.
+// unlike FNV it cannot be continued, the seed is just mixed into the result.
+HccHash64 hcc_hash_wy_64(const void* data, uintptr_t size, HccHash64 seed);
+#define hcc_hash_wy(data, size, seed) ((HccHash)hcc_hash_wy_64(data, size, seed))
+
+//
+// the hash of a string that is used by hcc_string_key_hash.
+// pass it to the *_hashed functions when the hash is already known, so the string is not hashed again.
+static inline HccHash hcc_string_hash(const char* data, uintptr_t size) {
+	return hcc_hash_wy(data, size, 0);
+}
+
 void hcc_generate_enum_hashes(char* array_name, char** strings, char** enum_strings, uint32_t enums_count);
 void hcc_generate_hashes(void);
 uint32_t hcc_string_to_enum_hashed_find(HccString string, HccHash32* enum_hashes, uint32_t enums_count);
@@ -747,6 +912,15 @@ struct HccStackHeader {
 #endif
 };
 
+//
+// a run of elements that a single thread has taken from a stack that many threads push onto.
+// see hcc_stack_push_many_chunked
+typedef struct HccStackChunk HccStackChunk;
+struct HccStackChunk {
+	uint32_t idx;     // the next element to hand out
+	uint32_t end_idx; // idx == end_idx when the chunk has run out
+};
+
 #define HccStack(T) T*
 
 #define hcc_stack_header(stack)      ((stack) ? (((HccStackHeader*)(stack)) - 1)     : NULL)
@@ -763,6 +937,12 @@ HccStack(void) _hcc_stack_init(HccAllocTag tag, uintptr_t grow_count, uintptr_t
 #define hcc_stack_deinit(stack) _hcc_stack_deinit(stack, sizeof(*(stack))); (stack) = NULL
 void _hcc_stack_deinit(HccStack(void) stack, uintptr_t elmt_size);
 
+//
+// clears the stack and zeroes all of the memory it has committed, so it is the same as a freshly initialized stack.
+// use this instead of hcc_stack_clear when reusing a stack that expects new elements to start zeroed.
+#define hcc_stack_reset(stack) _hcc_stack_reset(stack, sizeof(*(stack)))
+void _hcc_stack_reset(HccStack(void) stack, uintptr_t elmt_size);
+
 #if HCC_ENABLE_DEBUG_ASSERTIONS
 #define hcc_stack_get(stack, idx) (&(stack)[HCC_DEBUG_ASSERT_ARRAY_BOUNDS(idx, hcc_stack_count(stack))])
 #else
@@ -790,6 +970,15 @@ uintptr_t _hcc_stack_push_many(HccStack(void) stack, uintptr_t amount, uintptr_t
 #define hcc_stack_push_many_thread_safe(stack, amount) (&(stack)[_hcc_stack_push_many_thread_safe(stack, amount, sizeof(*(stack)))])
 uintptr_t _hcc_stack_push_many_thread_safe(HccStack(void) stack, uintptr_t amount, uintptr_t elmt_size);
 
+//
+// for stacks that many threads push onto at the same time where elements are only ever looked up by index or pointer.
+// the thread takes chunk_cap elements at a time from the stack into its own chunk and hands those out without any locking.
+// elements from one call to the next are not contiguous and unused elements are left behind in the stack,
+// so the stack must not be iterated over. if chunk is NULL then this is just hcc_stack_push_many_thread_safe.
+#define hcc_stack_push_chunked(stack, chunk, chunk_cap) (&(stack)[_hcc_stack_push_many_chunked(stack, chunk, 1, chunk_cap, sizeof(*(stack)))])
+#define hcc_stack_push_many_chunked(stack, chunk, amount, chunk_cap) (&(stack)[_hcc_stack_push_many_chunked(stack, chunk, amount, chunk_cap, sizeof(*(stack)))])
+uintptr_t _hcc_stack_push_many_chunked(HccStack(void) stack, HccStackChunk* chunk, uintptr_t amount, uintptr_t chunk_cap, uintptr_t elmt_size);
+
 #define hcc_stack_pop(stack) _hcc_stack_pop_many(stack, 1, sizeof(*(stack)))
 #define hcc_stack_pop_many(stack, amount) _hcc_stack_pop_many(stack, amount, sizeof(*(stack)))
 void _hcc_stack_pop_many(HccStack(void) stack, uintptr_t amount, uintptr_t elmt_size);
@@ -902,18 +1091,46 @@ void _hcc_deque_pop_back_many(HccDeque(void) deque, uintptr_t amount, uintptr_t
 typedef bool (*HccHashTableKeyCmpFn)(void* a, void* b, uintptr_t size);
 typedef HccHash (*HccHashTableKeyHashFn)(void* key, uintptr_t size);
 
+//
+// the index maps hashes to the elements of the table. it has its own allocation so it can grow
+// as entries are inserted, without moving the elements which stay at the same index for the life of the table.
+typedef struct HccHashTableIndex HccHashTableIndex;
+struct HccHashTableIndex {
+	HccHashTableIndex*   retired_next; // the smaller index that this one replaced, other threads may still be searching it until the next clear
+	uintptr_t            cap;
+	HccAtomic(HccHash)*  hashes;
+	uint32_t*            elmt_indices;
+	uint8_t*             tags; // see HCC_HASH_TABLE_TAG_*, a hint for the hashes that is written before a hash is published
+	HccAtomic(uint32_t)* dirty_bucket_bitset; // a bit per bucket that has had an entry inserted since the last clear
+	uintptr_t            tombstones_count; // the slots that have been removed since this index was built
+};
+
+//
+// the elements are packed at the start of the table in the order they are inserted.
+// removed elements are put on the free list and handed out again by the next inserts,
+// so count is the most elements that have been in use at once and not the number that are in use now.
+// the address space for reserve_cap elements is reserved up front and cap is the number of elements
+// that have pages committed for them so far. cap is doubled when an insert needs an element past it.
 typedef struct HccHashTableHeader HccHashTableHeader;
 struct HccHashTableHeader {
 	alignas(hcc_max_align_t)
-	HccAtomic(uintptr_t) count;
-	uintptr_t            cap;
-	HccHashTableKeyCmpFn  key_cmp_fn;
-	HccHashTableKeyHashFn key_hash_fn;
-	HccAtomic(HccHash)*  hashes;
-	HccAllocTag          tag;
+	HccAtomic(uintptr_t)          count;
+	HccAtomic(uintptr_t)          cap;
+	uintptr_t                     reserve_cap;
+	HccSpinMutex                  grow_mutex; // held while more pages are being committed for the elements
+	HccHashTableKeyCmpFn          key_cmp_fn;
+	HccHashTableKeyHashFn         key_hash_fn;
+	HccAtomic(HccHash)*           elmt_hashes; // the hash of each element, or a tombstone once it has been removed
+	HccAtomic(HccHashTableIndex*) index;
+	HccAtomic(uint32_t)           inserting_count; // the threads that are inserting into the index, waited on when growing the index
+	HccAtomic(bool)               is_resizing;
+	uint32_t*                     free_elmt_indices; // a stack of the elements that have been removed
+	HccAtomic(uint32_t)           free_count;
+	HccSpinMutex                  free_mutex;
+	HccAllocTag                   tag;
 #if HCC_ENABLE_DEBUG_ASSERTIONS
-	uint32_t             magic_number;
-	uintptr_t            elmt_size;
+	uint32_t                      magic_number;
+	uintptr_t                     elmt_size;
 #endif
 };
 
@@ -932,8 +1149,14 @@ struct HccNameToIdxEntry {
 #define HccHashTable(KVEntry) KVEntry*
 
 #define hcc_hash_table_header(table) ((table) ? (((HccHashTableHeader*)(table)) - 1) : NULL)
-#define hcc_hash_table_count(table)  ((table) ? hcc_hash_table_header(table)->count  : 0)
+#define hcc_hash_table_count(table)  ((table) ? HCC_MIN(hcc_hash_table_header(table)->count, hcc_hash_table_header(table)->cap) : 0)
 #define hcc_hash_table_cap(table)    ((table) ? hcc_hash_table_header(table)->cap    : 0)
+#define hcc_hash_table_reserve_cap(table) ((table) ? hcc_hash_table_header(table)->reserve_cap : 0)
+
+//
+// the most elements a hash table can grow to, only the address space is reserved for them up front.
+// a table that is given a bigger starting capacity is reserved for that instead.
+#define HCC_HASH_TABLE_RESERVE_CAP (1 << 22)
 
 #if HCC_ENABLE_DEBUG_ASSERTIONS
 #define hcc_hash_table_get(table, idx) (&(table)[_HCC_ASSERT_ARRAY_BOUNDS(idx, hcc_hash_table_cap(table))])
@@ -956,9 +1179,27 @@ uintptr_t _hcc_hash_table_find_idx(HccHashTable(void) table, void* key, uintptr_
 #define hcc_hash_table_find_insert_idx(table, key) _hcc_hash_table_find_insert_idx(table, key, sizeof(*(key)), sizeof(*(table)))
 HccHashTableInsert _hcc_hash_table_find_insert_idx(HccHashTable(void) table, void* key, uintptr_t key_size, uintptr_t elmt_size);
 
+//
+// the same as above but with the hash of the key already worked out,
+// it must be the same value that the key_hash_fn of the table returns for the key.
+#define hcc_hash_table_find_idx_hashed(table, key, hash) _hcc_hash_table_find_idx_hashed(table, key, sizeof(*(key)), hash, sizeof(*(table)))
+uintptr_t _hcc_hash_table_find_idx_hashed(HccHashTable(void) table, void* key, uintptr_t key_size, HccHash hash, uintptr_t elmt_size);
+
+#define hcc_hash_table_find_insert_idx_hashed(table, key, hash) _hcc_hash_table_find_insert_idx_hashed(table, key, sizeof(*(key)), hash, sizeof(*(table)))
+HccHashTableInsert _hcc_hash_table_find_insert_idx_hashed(HccHashTable(void) table, void* key, uintptr_t key_size, HccHash hash, uintptr_t elmt_size);
+
+//
+// the element of the removed key is reused by a later insert, so no other thread can be using the table
+// or still holding on to the element when this is called.
 #define hcc_hash_table_remove(table, key) _hcc_hash_table_remove(table, key, sizeof(*(key)), sizeof(*(table)))
 bool _hcc_hash_table_remove(HccHashTable(void) table, void* key, uintptr_t key_size, uintptr_t elmt_size);
 
+//
+// returns false when the element at idx has been removed and is waiting on the free list to be reused.
+// used to go through the elements up to hcc_hash_table_count while no other thread is inserting.
+#define hcc_hash_table_is_elmt_used(table, idx) _hcc_hash_table_is_elmt_used(table, idx, sizeof(*(table)))
+bool _hcc_hash_table_is_elmt_used(HccHashTable(void) table, uintptr_t idx, uintptr_t elmt_size);
+
 bool hcc_u32_key_cmp(void* a, void* b, uintptr_t size);
 bool hcc_u64_key_cmp(void* a, void* b, uintptr_t size);
 
@@ -1108,6 +1349,7 @@ struct HccDataTypeTable {
 
 void hcc_data_type_table_init(HccCU* cu, HccCUSetup* setup);
 void hcc_data_type_table_deinit(HccCU* cu);
+void hcc_data_type_table_reset(HccCU* cu);
 
 // ===========================================
 //
@@ -1156,6 +1398,7 @@ bool hcc_constant_entry_key_cmp(void* a, void* b, uintptr_t size);
 
 void hcc_constant_table_init(HccCU* cu, HccConstantTableSetup* setup);
 void hcc_constant_table_deinit(HccCU* cu);
+void hcc_constant_table_reset(HccCU* cu);
 HccConstantId _hcc_constant_table_deduplicate_end(HccCU* cu, HccDataType data_type, void* data, uint32_t data_size, uint32_t data_align, bool is_zero);
 
 // ===========================================
@@ -1181,6 +1424,7 @@ struct HccASTVariable {
 typedef uint8_t HccASTFunctionFlags;
 enum HccASTFunctionFlags {
 	HCC_AST_FUNCTION_FLAGS_INLINE = 0x1,
+	HCC_AST_FUNCTION_FLAGS_IS_REACHABLE = 0x2, // set by hcc_ast_seed_reachable_functions and hcc_ast_find_reachable_functions
 };
 
 #define HCC_FUNCTION_MAX_PARAMS_COUNT 32
@@ -1192,6 +1436,9 @@ struct HccASTFunction {
 	HccLocation*        identifier_location;
 	HccLocation*        return_data_type_location;
 	HccASTVariable*     params_and_variables;
+	HccASTFile*         ast_file; // the file the function is defined in
+	HccDecl*            callees; // the function decl of every call in the body, forward declarations are resolved after ASTLINK
+	uint32_t            callees_count;
 	HccStringId         identifier_string_id;
 	HccDataType         function_data_type;
 	HccDataType         return_data_type;
@@ -1630,6 +1877,19 @@ uint32_t hcc_ata_token_cursor_tokens_count(HccATATokenCursor* cursor);
 #define HCC_PP_TOKEN_SET_PREEXPANDED_MACRO_ARG(location) ((HccLocation*)(((uintptr_t)location) | 0x1))
 #define HCC_PP_TOKEN_STRIP_PREEXPANDED_MACRO_ARG(location) ((HccLocation*)(((uintptr_t)location) & ~(uintptr_t)0x1))
 
+//
+// what a HccATAValue holds, see hcc_ata_token_value_type
+typedef uint8_t HccATAValueType;
+enum HccATAValueType {
+	HCC_ATA_VALUE_TYPE_STRING_ID,
+	HCC_ATA_VALUE_TYPE_CONSTANT_ID,
+	HCC_ATA_VALUE_TYPE_MACRO_PARAM_IDX,
+};
+
+//
+// @param(value_idx): the index of the value for the token, this must be less than hcc_ata_token_num_values(token)
+HccATAValueType hcc_ata_token_value_type(HccATAToken token, uint32_t value_idx);
+
 typedef struct HccATATokenBag HccATATokenBag;
 struct HccATATokenBag {
 	HccStack(HccATAToken)  tokens;
@@ -1662,6 +1922,8 @@ struct HccPPMacro {
 	HccLocation*      location;
 	HccStringId*      params;
 	HccATATokenCursor token_cursor;
+	HccHash64         content_hash; // hash of everything that makes up the macro, see HccATAGen.macro_state_hash
+	uint32_t          token_values_count;
 	uint32_t          params_count: 8;
 	uint32_t          is_function: 1;
 	uint32_t          has_va_args: 1;
@@ -1779,10 +2041,68 @@ struct HccCodeFile {
 	HccString                   code;
 	HccStack(uint32_t)          line_code_start_indices;
 	HccStack(HccPPIfSpan)       pp_if_spans;
+	HccFileStat                 stat;      // of the file on disk when the code was loaded
+	HccHash64                   code_hash;
+	HccStringId                 include_guard_string_id; // the macro of an #ifndef that wraps the whole file, found by the mutator pass
 };
 
 HccResult hcc_code_file_init(HccCodeFile* code_file, HccString path_string, bool do_not_open_file);
 void hcc_code_file_deinit(HccCodeFile* code_file);
+HccResult hcc_code_file_load_code(HccString path_string, HccString* code_out);
+void hcc_code_file_release_code(HccString code);
+void hcc_code_file_reset_mutator_pass(HccCodeFile* code_file);
+HccResult hcc_code_file_refresh(HccCodeFile* code_file);
+HccCodeFile* hcc_code_file_find_hashed(HccString file_path, HccHash file_path_hash);
+void hcc_code_files_refresh(void);
+
+//
+// remembers where an #include resolved to so the include directories do not have to be searched
+// on disk again. files that could not be found are remembered too, using an empty canonical_path.
+// it is shared by every worker and task and is kept between compiles. each entry remembers the directories
+// that were searched and when a new set of tasks starts, only the entries that searched a directory
+// that has since been modified (a file was created, removed or renamed in it) are thrown away.
+typedef struct HccIncludeResolveKey HccIncludeResolveKey;
+struct HccIncludeResolveKey {
+	HccStringId dir_path_string_id; // the directory of the including file for a relative #include "", otherwise zero
+	HccStringId path_string_id;     // the path as it is spelled in the #include
+	HccHash64   include_paths_hash; // see HccTask.include_paths_hash
+	bool        is_system;          // #include <>
+};
+
+typedef struct HccIncludeResolveEntry HccIncludeResolveEntry;
+struct HccIncludeResolveEntry {
+	HccIncludeResolveKey key;
+	HccString            canonical_path;
+	uint64_t             dir_bits; // see hcc_include_resolve_dir_bit, of every directory that was searched
+	HccAtomic(bool)      is_ready; // set once canonical_path has been written, until then the entry is treated as a miss
+};
+
+//
+// a directory that an #include was searched for in. the modified time is taken before the directory is searched
+// so a file that is created while it is being searched makes the next compile search for the #include again.
+typedef struct HccIncludeResolveDirEntry HccIncludeResolveDirEntry;
+struct HccIncludeResolveDirEntry {
+	HccStringId     path_string_id;
+	HccTime         modified_time; // zero when the directory does not exist
+	HccAtomic(bool) is_ready;      // set once modified_time has been written
+};
+
+bool hcc_include_resolve_key_cmp(void* a, void* b, uintptr_t size);
+HccHash hcc_include_resolve_key_hash(void* key, uintptr_t size);
+bool hcc_include_resolve_cache_find(HccIncludeResolveKey* key, HccString* canonical_path_out);
+void hcc_include_resolve_cache_insert(HccIncludeResolveKey* key, HccString canonical_path, uint64_t dir_bits);
+
+//
+// starts tracking the directory of the file at @param(file_path) if it is not already.
+// @return: the bit for the directory that goes in HccIncludeResolveEntry.dir_bits. it is the index of the directory
+//     modulo 64 so many directories share a bit, which only makes us throw away some entries that are still valid.
+//     zero is returned when the directory could not be tracked and then the #include must not be cached.
+uint64_t hcc_include_resolve_dir_bit(const char* file_path, uint32_t file_path_size);
+
+//
+// called between compiles, throws away the entries that searched a directory that has been modified since.
+void hcc_include_resolve_cache_refresh(void);
+void hcc_include_resolve_cache_clear(void);
 
 // ===========================================
 //
@@ -1851,6 +2171,9 @@ HccPPEval hcc_ppgen_eval_unary_expr(HccWorker* w, uint32_t* token_idx_mut, uint3
 HccPPEval hcc_ppgen_eval_expr(HccWorker* w, uint32_t min_precedence, uint32_t* token_idx_mut, uint32_t* token_value_idx_mut);
 void hcc_ppgen_ensure_end_of_directive(HccWorker* w, HccErrorCode error_code, HccPPDirective directive);
 
+HccHash64 hcc_ppgen_string_hash(HccStringId string_id, HccHash64 hash);
+HccHash64 hcc_ppgen_predefined_macro_content_hash(HccStringId identifier_string_id);
+HccHash64 hcc_ppgen_macro_content_hash(HccPPMacro* macro, HccATATokenBag* macro_token_bag);
 void hcc_ppgen_parse_define(HccWorker* w);
 void hcc_ppgen_parse_undef(HccWorker* w);
 void hcc_ppgen_parse_include(HccWorker* w);
@@ -1904,21 +2227,258 @@ enum HccATAGenRunMode {
 typedef struct HccATAPausedFile HccATAPausedFile;
 struct HccATAPausedFile {
 	bool        we_are_mutator_of_code_file;
+	bool        is_code_file_mutator_pass_completed;
 	uint32_t    pp_if_span_id;
 	uint32_t    if_stack_count;
 	HccLocation location;
 };
 
+typedef uint8_t HccATAIncludeEffectType;
+enum HccATAIncludeEffectType {
+	HCC_ATA_INCLUDE_EFFECT_TYPE_DEFINE,
+	HCC_ATA_INCLUDE_EFFECT_TYPE_UNDEF,
+	HCC_ATA_INCLUDE_EFFECT_TYPE_PRAGMA_ONCE,
+	HCC_ATA_INCLUDE_EFFECT_TYPE_FOUND_INCLUDED_FILE,
+	HCC_ATA_INCLUDE_EFFECT_TYPE_TOKENIZED_FILE, // changes nothing, it records which files the tokens came from for precompiled headers
+};
+
+//
+// a change to the preprocessor state of a HccASTFile that happens outside of its token bag.
+// these are logged so that the changes made by an included file can be replayed
+// on another file that takes the included file's tokens from the include cache.
+typedef struct HccATAIncludeEffect HccATAIncludeEffect;
+struct HccATAIncludeEffect {
+	HccATAIncludeEffectType type;
+	union {
+		uint32_t    macro_idx; // HCC_ATA_INCLUDE_EFFECT_TYPE_DEFINE
+		HccStringId string_id; // everything else
+		uint32_t    pch_idx;   // in a precompiled header, the index of the macro, file or string
+	};
+};
+
+//
+// an included file will produce the same tokens and effects when it is included
+// with the same set of macros defined and the same set of files pragma onced.
+typedef struct HccATAIncludeCacheKey HccATAIncludeCacheKey;
+struct HccATAIncludeCacheKey {
+	HccStringId path_string_id;
+	HccHash64   macro_state_hash;
+	HccHash64   pragma_onced_hash;
+};
+
+typedef struct HccATAIncludeCacheEntry HccATAIncludeCacheEntry;
+struct HccATAIncludeCacheEntry {
+	HccATAIncludeCacheKey key;
+	HccASTFile*           ast_file; // the file that holds the tokens and effects in it's token bag and include effects
+	uint32_t              tokens_start_idx;
+	uint32_t              tokens_end_idx;
+	uint32_t              token_values_start_idx;
+	uint32_t              token_values_end_idx;
+	uint32_t              effects_start_idx;
+	uint32_t              effects_end_idx;
+	HccAtomic(bool)       is_ready; // set once all of the above has been written, until then the entry is treated as a miss
+};
+
+bool hcc_ata_include_cache_key_cmp(void* a, void* b, uintptr_t size);
+HccHash hcc_ata_include_cache_key_hash(void* key, uintptr_t size);
+
+//
+// an included file that is currently being tokenized that will be stored in the include cache
+// when we reach the end of it. it is thrown away if anything happens that the include cache cannot replay.
+typedef struct HccATAIncludeRecording HccATAIncludeRecording;
+struct HccATAIncludeRecording {
+	HccATAIncludeCacheKey key;
+	uint32_t              paused_files_count;
+	uint32_t              tokens_start_idx;
+	uint32_t              token_values_start_idx;
+	uint32_t              effects_start_idx;
+	bool                  is_invalid;
+};
+
+//
+// a precompiled header (PCH) is an include cache entry that has been written to disk so that it can be used by the next compile.
+// HccStringId, HccConstantId and pointers are different in every process, so the precompiled header stores them
+// as indices into its own tables of strings, constants, files, locations and macros, and these are mapped back when it is loaded.
+// the file name is the hex of hcc_atagen_pch_key_hash followed by HCC_ATA_PCH_FILE_EXTENSION.
+//
+// the file is laid out as the HccATAPCHHeader followed by these arrays, each one starts on a 8 byte alignment:
+//     HccATAPCHString     strings[strings_count]
+//     char                string_bytes[string_bytes_size]       // each string is followed by a null terminator
+//     HccATAPCHFile       files[files_count]
+//     uint32_t            line_code_start_indices[line_code_start_indices_count]
+//     HccATAPCHIfSpan     if_spans[if_spans_count]
+//     HccATAPCHLocation   locations[locations_count]
+//     HccATAPCHConstant   constants[constants_count]
+//     HccATAPCHMacro      macros[macros_count]
+//     uint32_t            macro_params[macro_params_count]      // string indices
+//     HccATAToken         tokens[tokens_count]                  // the tokens of the included file followed by the tokens of each macro
+//     uint32_t            token_locations[tokens_count]         // location indices
+//     uint32_t            token_values[token_values_count]      // string, constant or macro param indices, see hcc_ata_token_value_type
+//     HccATAIncludeEffect effects[effects_count]                // using HccATAIncludeEffect.pch_idx
+//
+#define HCC_ATA_PCH_MAGIC_NUMBER   0x48435048 // "HPCH"
+#define HCC_ATA_PCH_VERSION        2
+#define HCC_ATA_PCH_FILE_EXTENSION ".hccpch"
+#define HCC_ATA_PCH_ALIGN          8
+#define HCC_ATA_PCH_TOKEN_LOCATION_IS_PREEXPANDED_MACRO_ARG 0x80000000
+
+typedef struct HccATAPCHHeader HccATAPCHHeader;
+struct HccATAPCHHeader {
+	uint32_t  magic_number;
+	uint32_t  version;
+	HccHash64 key_hash;
+	HccHash64 macro_state_hash;
+	HccHash64 pragma_onced_hash;
+	uint32_t  path_string_idx;
+	uint32_t  strings_count;
+	uint32_t  string_bytes_size;
+	uint32_t  files_count;
+	uint32_t  line_code_start_indices_count;
+	uint32_t  if_spans_count;
+	uint32_t  locations_count;
+	uint32_t  constants_count;
+	uint32_t  macros_count;
+	uint32_t  macro_params_count;
+	uint32_t  tokens_count;
+	uint32_t  token_values_count;
+	uint32_t  file_tokens_count;       // the tokens at the start of tokens that belong to the included file
+	uint32_t  file_token_values_count; // the token values at the start of token_values that belong to the included file
+	uint32_t  effects_count;
+};
+
+typedef struct HccATAPCHString HccATAPCHString;
+struct HccATAPCHString {
+	uint32_t bytes_start_idx;
+	uint32_t size;
+	uint64_t hash; // hcc_string_hash, checked when loading so a corrupt string cannot end up in the hash tables
+};
+
+//
+// a file that the tokens have a location in. if the file was tokenized by the included file
+// then it's line_code_start_indices and pp_if_spans are stored so that the mutator pass does not need to be done when loading.
+// the precompiled header is thrown away if any of the files have changed.
+typedef struct HccATAPCHFile HccATAPCHFile;
+struct HccATAPCHFile {
+	HccHash64 code_hash;
+	uint32_t  code_size;
+	uint32_t  path_string_idx;
+	uint32_t  line_code_start_indices_start_idx;
+	uint32_t  line_code_start_indices_count;
+	uint32_t  if_spans_start_idx;
+	uint32_t  if_spans_count;
+	uint32_t  is_tokenized;
+	uint32_t  _reserved;
+};
+
+typedef struct HccATAPCHIfSpan HccATAPCHIfSpan;
+struct HccATAPCHIfSpan {
+	uint32_t directive;
+	uint32_t location_idx;
+	uint32_t parent_id;
+	uint32_t first_id;
+	uint32_t has_else;
+	uint32_t prev_id;
+	uint32_t next_id;
+	uint32_t last_id;
+};
+
+typedef struct HccATAPCHLocation HccATAPCHLocation;
+struct HccATAPCHLocation {
+	uint32_t file_idx;
+	uint32_t parent_location_idx_plus_one;
+	uint32_t macro_idx_plus_one;                   // a macro that is defined by the included file
+	uint32_t macro_identifier_string_idx_plus_one; // a macro that is defined before the included file, so it is found by it's name when loading
+	uint32_t code_start_idx;
+	uint32_t code_end_idx;
+	uint32_t line_start;
+	uint32_t line_end;
+	uint32_t column_start;
+	uint32_t column_end;
+	uint32_t display_path_string_idx_plus_one;
+	uint32_t display_line;
+};
+
+typedef struct HccATAPCHConstant HccATAPCHConstant;
+struct HccATAPCHConstant {
+	HccDataType data_type;
+	uint32_t    _reserved;
+	HccBasic    basic;
+};
+
+typedef struct HccATAPCHMacro HccATAPCHMacro;
+struct HccATAPCHMacro {
+	HccHash64 content_hash;
+	uint32_t  identifier_string_idx;
+	uint32_t  location_idx;
+	uint32_t  params_start_idx;
+	uint32_t  params_count;
+	uint32_t  tokens_start_idx;
+	uint32_t  tokens_count;
+	uint32_t  token_values_start_idx;
+	uint32_t  token_values_count;
+	uint32_t  is_function;
+	uint32_t  has_va_args;
+};
+
+//
+// the keys of HccATAGenPCH.idx_map. pointers are used as they are,
+// user space pointers never have the top bits set so they cannot clash with the identifiers.
+#define HCC_ATA_PCH_IDX_KEY_STRING_ID(string_id)        (((uint64_t)1 << 63) | (string_id).idx_plus_one)
+#define HCC_ATA_PCH_IDX_KEY_CONSTANT_ID(constant_id)    (((uint64_t)1 << 62) | (constant_id).idx_plus_one)
+#define HCC_ATA_PCH_IDX_KEY_MACRO_IDENTIFIER(string_id) (((uint64_t)3 << 62) | (string_id).idx_plus_one) // the last macro defined with this name
+#define HCC_ATA_PCH_IDX_KEY_PTR(ptr)                    ((uint64_t)(uintptr_t)(ptr))
+
+typedef struct HccATAPCHIdxEntry HccATAPCHIdxEntry;
+struct HccATAPCHIdxEntry {
+	uint64_t key;
+	uint32_t idx;
+};
+
+//
+// the working memory used to store and load precompiled headers
+typedef struct HccATAGenPCH HccATAGenPCH;
+struct HccATAGenPCH {
+	HccHashTable(HccATAPCHIdxEntry) idx_map; // when storing, maps strings, constants, files, locations and macros to their index in the precompiled header
+	HccStack(HccATAPCHString)       strings;
+	HccStack(char)                  string_bytes;
+	HccStack(HccATAPCHFile)         files;
+	HccStack(HccCodeFile*)          code_files; // the code file of each of the files
+	HccStack(uint32_t)              line_code_start_indices;
+	HccStack(HccATAPCHIfSpan)       if_spans;
+	HccStack(HccATAPCHLocation)     locations;
+	HccStack(HccLocation*)          src_locations; // when storing, the location each of the locations is made from. when loading, the location made for each of them
+	HccStack(HccATAPCHConstant)     constants;
+	HccStack(HccATAPCHMacro)        macros;
+	HccStack(uint32_t)              macro_params;
+	HccStack(HccATAToken)           tokens;
+	HccStack(uint32_t)              token_locations;
+	HccStack(uint32_t)              token_values;
+	HccStack(HccATAIncludeEffect)   effects;
+	HccStack(HccStringId)           string_ids;    // when loading, the string id of each of the strings
+	HccStack(HccConstantId)         constant_ids;  // when loading, the constant id of each of the constants
+	HccStack(uint32_t)              macro_indices; // when loading, the index into HccASTFile.macros of each of the macros
+	HccStack(bool)                  we_are_mutator_of_code_files; // when loading, whether we have to complete the mutator pass of each of the code files
+};
+
 typedef struct HccATAGen HccATAGen;
 struct HccATAGen {
 	HccPPGen                 ppgen;
 	HccASTFile*              ast_file;
 
-	HccATAGenRunMode            run_mode;
-	HccATATokenBag*             dst_token_bag;
-	HccStack(HccATAPausedFile)  paused_file_stack;
-	HccStack(HccATAOpenBracket) open_bracket_stack;
-	bool                        we_are_mutator_of_code_file; // this is true when this is the first thread to start parsing the code file.
+	HccATAGenRunMode                 run_mode;
+	HccATATokenBag*                  dst_token_bag;
+	HccStack(HccATAPausedFile)       paused_file_stack;
+	HccStack(HccATAOpenBracket)      open_bracket_stack;
+	HccStack(HccATAIncludeRecording) include_recording_stack;
+	HccATAGenPCH                     pch;
+	bool                             we_are_mutator_of_code_file; // this is true when this is the first thread to start parsing the code file.
+	bool                             is_code_file_mutator_pass_completed; // HCC_CODE_FILE_FLAGS_COMPLETED_MUTATOR_PASS from when we started parsing the code file, so it does not change half way through
+
+	//
+	// the sum of HccPPMacro.content_hash for every macro that is currently defined.
+	// a sum is used so the order the macros where defined in does not matter.
+	// the hashes are made from the contents of the macros, so it is the same in every process.
+	HccHash64                macro_state_hash;
 
 	//
 	// data used when run_mode == HCC_TOKENGEN_RUN_MODE_PP_DEFINE_REPLACEMENT_LIST
@@ -1946,6 +2506,7 @@ void hcc_atagen_generate(HccWorker* w);
 HccLocation* hcc_atagen_make_location(HccWorker* w);
 void hcc_atagen_advance_column(HccWorker* w, uint32_t by);
 void hcc_atagen_advance_newline(HccWorker* w);
+void hcc_atagen_advance_over_code(HccWorker* w, uint32_t size);
 uint32_t hcc_atagen_display_line(HccWorker* w);
 void hcc_atagen_token_add(HccWorker* w, HccATAToken token);
 void hcc_atagen_token_value_add(HccWorker* w, HccATAValue value);
@@ -1956,6 +2517,32 @@ void hcc_atagen_paused_file_push(HccWorker* w);
 void hcc_atagen_paused_file_pop(HccWorker* w);
 void hcc_atagen_location_setup_new_file(HccWorker* w, HccCodeFile* code_file);
 bool hcc_atagen_is_last_token_string(HccATATokenBag* bag);
+void hcc_atagen_include_effect_push(HccWorker* w, HccATAIncludeEffectType type, uint32_t macro_idx_or_string_id);
+bool hcc_atagen_include_cache_can_be_used(HccWorker* w);
+bool hcc_atagen_include_cache_replay(HccWorker* w, HccATAIncludeCacheKey* key);
+void hcc_atagen_include_recording_begin(HccWorker* w, HccATAIncludeCacheKey* key);
+void hcc_atagen_include_recording_end(HccWorker* w);
+void hcc_atagen_include_recordings_invalidate(HccWorker* w);
+void hcc_atagen_include_cache_publish(HccWorker* w, HccATAIncludeCacheKey* key, uint32_t tokens_start_idx, uint32_t token_values_start_idx, uint32_t effects_start_idx);
+void hcc_atagen_include_replay_define(HccWorker* w, uint32_t macro_idx);
+void hcc_atagen_include_replay_undef(HccWorker* w, HccStringId identifier_string_id);
+HccHash64 hcc_atagen_pch_key_hash(HccWorker* w, HccATAIncludeCacheKey* key);
+bool hcc_atagen_pch_path(HccWorker* w, HccHash64 key_hash, char* path_out, uint32_t path_out_size);
+bool hcc_atagen_pch_load(HccWorker* w, HccATAIncludeCacheKey* key, HccCodeFile* code_file, bool we_are_mutator_of_code_file);
+void hcc_atagen_pch_store(HccWorker* w, HccATAIncludeRecording* recording);
+uint32_t hcc_atagen_pch_idx_find(HccWorker* w, uint64_t key);
+bool hcc_atagen_pch_idx_insert(HccWorker* w, uint64_t key, uint32_t idx);
+uint32_t hcc_atagen_pch_add_string(HccWorker* w, HccStringId string_id);
+uint32_t hcc_atagen_pch_add_constant(HccWorker* w, HccConstantId constant_id);
+uint32_t hcc_atagen_pch_add_file(HccWorker* w, HccCodeFile* code_file);
+uint32_t hcc_atagen_pch_add_location(HccWorker* w, HccLocation* location);
+uint32_t hcc_atagen_pch_add_macro(HccWorker* w, HccPPMacro* macro);
+bool hcc_atagen_pch_add_tokens(HccWorker* w, HccATATokenBag* bag, uint32_t tokens_start_idx, uint32_t tokens_count, uint32_t token_values_start_idx);
+bool hcc_atagen_pch_add_code_file_mutator_data(HccWorker* w, uint32_t file_idx);
+bool hcc_atagen_pch_write_section(HccIIO* iio, void* data, uintptr_t size);
+void hcc_atagen_pch_load_location(HccWorker* w, HccATAPCHLocation* pch_location, HccLocation* location_out);
+bool hcc_atagen_pch_tokens_are_valid(HccATAPCHHeader* header, HccATAToken* tokens, uint32_t* token_locations, uint32_t* token_values, uint32_t tokens_count, uint32_t token_values_count, uint32_t macro_params_count);
+void hcc_atagen_pch_load_tokens(HccWorker* w, HccATATokenBag* bag, HccATAToken* tokens, uint32_t* token_locations, uint32_t* token_values, uint32_t tokens_count);
 void hcc_atagen_token_merge_append_string(HccWorker* w, HccATATokenBag* bag, HccString append_string);
 
 bool hcc_atagen_consume_backslash(HccWorker* w);
@@ -1967,6 +2554,7 @@ HccString hcc_atagen_parse_ident_from_string(HccWorker* w, HccString string, Hcc
 HccString hcc_atagen_parse_ident(HccWorker* w, HccErrorCode error_code);
 
 uint32_t hcc_atagen_parse_num(HccWorker* w, HccATAToken* token_out);
+void hcc_atagen_parse_string_run(HccWorker* w, char terminator_byte);
 void hcc_atagen_parse_string(HccWorker* w, char terminator_byte, bool ignore_escape_sequences_except_double_quotes);
 uint32_t hcc_atagen_find_macro_param(HccWorker* w, HccStringId ident_string_id);
 void hcc_atagen_consume_hash_for_define_replacement_list(HccWorker* w);
@@ -1992,26 +2580,35 @@ struct HccDeclEntry {
 
 typedef struct HccASTFile HccASTFile;
 struct HccASTFile {
-	HccString                path;
-	HccATAIter               iter;
-	HccStack(HccPPMacro)     macros;
-	HccStack(HccStringId)    macro_params;
-	HccStack(HccStringId)    pragma_onced_files;
-	HccStack(HccStringId)    unique_included_files;
-	HccStack(HccDecl)        forward_declarations_to_link;
-	HccATATokenBag           token_bag;
-	HccATATokenBag           macro_token_bag;
+	HccString                     path;
+	HccATAIter                    iter;
+	HccStack(HccPPMacro)          macros;
+	HccStack(HccStringId)         macro_params;
+	HccStack(HccStringId)         pragma_onced_files;
+	HccStack(HccStringId)         unique_included_files;
+	HccStack(HccDecl)             forward_declarations_to_link;
+	HccATATokenBag                token_bag;
+	HccATATokenBag                macro_token_bag;
+	HccStack(HccATAIncludeEffect) include_effects;
+	HccHash64                     pragma_onced_hash; // the sum of the hashes of the pragma_onced_files
 
 	//
 	// used for when we want to find an identifier local to the file.
 	// HccCU has these hash tables that are a combination all of them from all files.
+	// they are NULL until the file is generated into the AST, see hcc_ast_file_init_declarations.
 	HccHashTable(HccDeclEntry) global_declarations;
 	HccHashTable(HccDeclEntry) struct_declarations; // struct T
 	HccHashTable(HccDeclEntry) union_declarations;  // union T
 	HccHashTable(HccDeclEntry) enum_declarations;   // enum T
+
+	//
+	// set when ASTLINK has resolved the forward declarations of this file,
+	// so the functions defined in it can be lowered to AML. guarded by HccAST.reachable_mutex.
+	bool is_linked;
 };
 
-void hcc_ast_file_init(HccASTFile* file, HccCU* cu, HccASTFileSetup* setup, HccString path);
+void hcc_ast_file_init(HccASTFile* file, HccASTFileSetup* setup, HccString path);
+void hcc_ast_file_init_declarations(HccASTFile* file, HccCU* cu);
 void hcc_ast_file_deinit(HccASTFile* file);
 bool hcc_ast_file_has_been_pragma_onced(HccASTFile* file, HccStringId path_string_id);
 void hcc_ast_file_set_pragma_onced(HccASTFile* file, HccStringId path_string_id);
@@ -2033,25 +2630,42 @@ struct HccASTFileEntry {
 
 typedef struct HccAST HccAST;
 struct HccAST {
-	HccASTFileSetup               file_setup;
-	HccHashTable(HccASTFileEntry) files_hash_table;
-	HccStack(HccASTFile*)         files;
-	HccStack(HccASTVariable)      function_params_and_variables;
-	HccStack(HccASTFunction)      functions;
-	HccStack(HccASTExpr)          exprs;
-	HccStack(HccLocation)         expr_locations;
-	HccStack(HccASTVariable)      global_variables;
-	HccStack(HccASTForwardDecl)   forward_declarations;
-	HccStack(uint64_t)            designated_initializer_elmt_indices; // referenced by HCC_AST_EXPR_TYPE_DESIGNATED_INITIALIZER
+	HccASTFileSetup                       file_setup;
+	HccHashTable(HccASTFileEntry)         files_hash_table;
+	HccStack(HccASTFile*)                 files;
+	HccStack(HccASTVariable)              function_params_and_variables;
+	HccStack(HccDecl)                     function_callees;
+	HccStack(HccASTFunction)              functions;
+	HccStack(HccASTExpr)                  exprs;
+	HccStack(HccLocation)                 expr_locations;
+	HccStack(HccASTVariable)              global_variables;
+	HccStack(HccASTForwardDecl)           forward_declarations;
+	HccStack(uint64_t)                    designated_initializer_elmt_indices; // referenced by HCC_AST_EXPR_TYPE_DESIGNATED_INITIALIZER
+	HccHashTable(HccATAIncludeCacheEntry) include_cache; // token streams of included files, so each one only gets tokenized once per set of macros
+	HccStack(HccDecl)                     reachable_function_decls; // every function that can be reached from a shader and whose file has been linked
+	HccStack(HccDecl)                     unlinked_reachable_function_decls; // functions that can be reached from a shader but their file has not been linked yet
+	HccSpinMutex                          reachable_mutex;
 };
 
 void hcc_ast_init(HccCU* cu, HccCUSetup* setup);
 void hcc_ast_deinit(HccCU* cu);
+void hcc_ast_reset(HccCU* cu);
 void hcc_ast_add_file(HccCU* cu, HccString file_path, HccASTFile** out);
 HccASTFile* hcc_ast_find_file(HccCU* cu, HccString file_path);
 void hcc_ast_print_expr(HccCU* cu, HccASTFunction* function, HccASTExpr* expr, uint32_t indent, HccIIO* iio);
 void hcc_ast_print(HccCU* cu, HccIIO* iio);
 
+//
+// marks the shader functions as reachable, called once ASTGEN has finished for every file.
+void hcc_ast_seed_reachable_functions(HccCU* cu);
+
+//
+// called when ASTLINK has finished with linked_file. the calls of the reachable functions in the files that are linked
+// are walked, as their forward declarations can be resolved now. each function that is found is pushed on to
+// cu->ast.reachable_function_decls and can be lowered to AML, the new ones are between the start and end indices.
+// functions found in files that are not linked yet are held back until their file is linked.
+void hcc_ast_find_reachable_functions(HccCU* cu, HccASTFile* linked_file, uint32_t* start_idx_out, uint32_t* end_idx_out);
+
 // ===========================================
 //
 //
@@ -2275,6 +2889,7 @@ struct HccASTGen {
 	HccStack(HccCompoundField) compound_fields;
 	HccStack(HccEnumValue)     enum_values;
 	HccStack(HccASTVariable)   function_params_and_variables;
+	HccStack(HccDecl)          function_callees;
 	HccStack(HccStringId)      variable_stack_strings;
 	HccStack(HccDecl)          variable_stack;
 	uint32_t                   next_var_idx;
@@ -2492,6 +3107,7 @@ struct HccAMLFunctionAlctor {
 
 void hcc_aml_function_alctor_init(HccCU* cu, HccAMLFunctionAlctorSetup* setup);
 void hcc_aml_function_alctor_deinit(HccCU* cu);
+void hcc_aml_function_alctor_reset(HccCU* cu);
 uint32_t hcc_aml_function_alctor_instr_count_round_up_log2(HccCU* cu, uint32_t max_instrs_count);
 HccAMLFunction* hcc_aml_function_alctor_alloc(HccCU* cu, uint32_t max_instrs_count);
 void hcc_aml_function_alctor_dealloc(HccCU* cu, HccAMLFunction* function);
@@ -2519,26 +3135,38 @@ struct HccAMLCallNode {
 	uint32_t next_call_node_idx;
 };
 
+//
+// tracks when the call graph of a function and every function it calls has been made in HCC_AML_OPT_PHASE_0,
+// so a shader can start HCC_AML_OPT_PHASE_1 without waiting on the call graphs of the other shaders.
+typedef struct HccAMLCallGraphDeps HccAMLCallGraphDeps;
+struct HccAMLCallGraphDeps {
+	HccAMLCallNode* waiting_callers; // the functions that call this one and are waiting on it, linked through HccAML.call_graph_waiting_nodes
+	uint32_t        waiting_calls_count; // the calls in this function to functions that are not is_made yet
+	bool            is_made;
+};
+
 typedef struct HccAML HccAML;
 struct HccAML {
 	HccAMLFunctionAlctor      function_alctor;
 	HccStack(HccAtomic(HccAMLFunction*)) functions; // use index of HccDecl(Function) to access this array
 	HccStack(HccLocation*)    locations; // all the HccAMLInstr have a location index into this array
-	HccAMLOptPhase opt_phase;
 	HccStack(HccAMLCallNode)  call_graph_nodes;
 	HccStack(HccAMLCallNode*) function_call_node_lists;
-	HccStack(HccDecl)         optimize_functions[2];
-	uint32_t                  optimize_functions_idx;
+	HccStack(HccDecl)         optimize_functions; // functions reachable from the shaders, ordered from the deepest calls to the entry points
 	HccSpinMutex              optimize_functions_mutex; // used to lock and deduplicate optimize functions when needed
+	HccStack(HccAMLCallGraphDeps) call_graph_deps; // use index of HccDecl(Function) to access this array
+	HccStack(HccAMLCallNode)  call_graph_waiting_nodes;
+	HccStack(HccDecl)         call_graph_made_decls; // work list used when a function is_made and its callers are told
+	HccSpinMutex              call_graph_deps_mutex; // guards all of the call_graph_* above
 };
 
 void hcc_aml_init(HccCU* cu, HccCUSetup* setup);
 void hcc_aml_deinit(HccCU* cu);
+void hcc_aml_reset(HccCU* cu);
 void hcc_aml_print_operand(HccCU* cu, const HccAMLFunction* function, HccAMLOperand operand, HccIIO* iio, bool is_definition);
 void hcc_aml_print(HccCU* cu, HccIIO* iio);
 HccLocation* hcc_aml_instr_location(HccCU* cu, HccAMLInstr* instr);
 HccStack(HccDecl) hcc_aml_optimize_functions(HccCU* cu);
-void hcc_aml_next_optimize_functions_array(HccCU* cu);
 HccAMLOperand hcc_aml_basic_block_next(const HccAMLFunction* function, HccAMLOperand basic_block_operand);
 HccAMLOperand hcc_aml_instr_switch_merge_basic_block_operand(const HccAMLFunction* function, HccAMLInstr* instr);
 
@@ -2655,6 +3283,12 @@ const HccAMLFunction* hcc_amlopt_make_call_graph(HccWorker* w, HccDecl function_
 const HccAMLFunction* hcc_amlopt_check_for_recursion_and_make_ordered_function_list(HccWorker* w, HccDecl function_decl, const HccAMLFunction* aml_function);
 const HccAMLFunction* hcc_amlopt_check_for_unsupported_features(HccWorker* w, HccDecl function_decl, const HccAMLFunction* aml_function);
 
+//
+// called when HCC_AML_OPT_PHASE_0 has made the call graph of function_decl.
+// every shader whose whole call graph has been made is given out to HCC_AML_OPT_PHASE_1 from here.
+// shaders that are part of a call cycle are never made, they are given out at the end of AMLGEN to report the recursion.
+void hcc_amlopt_call_graph_made(HccWorker* w, HccDecl function_decl);
+
 void hcc_amlopt_optimize(HccWorker* w);
 
 // ===========================================
@@ -3265,6 +3899,8 @@ struct HccSPIRVDescriptorBindingInfo {
 };
 
 void hcc_spirv_init(HccCU* cu, HccCUSetup* setup);
+void hcc_spirv_deinit(HccCU* cu);
+void hcc_spirv_reset(HccCU* cu);
 HccSPIRVId hcc_spirv_next_id(HccCU* cu);
 HccSPIRVId hcc_spirv_next_id_many(HccCU* cu, uint32_t amount);
 HccSPIRVId hcc_spirv_type_deduplicate(HccCU* cu, HccSPIRVStorageClass storage_class, HccDataType data_type);
@@ -3399,6 +4035,27 @@ struct HccDeclEntryAtomic {
 	HccAtomic(HccDeclEntryAtomicLink*) link;
 };
 
+typedef uint8_t HccCUStackChunk;
+enum HccCUStackChunk {
+	HCC_CU_STACK_CHUNK_AML_LOCATIONS,
+	HCC_CU_STACK_CHUNK_AST_FUNCTION_PARAMS_AND_VARIABLES,
+	HCC_CU_STACK_CHUNK_AST_FUNCTION_CALLEES,
+	HCC_CU_STACK_CHUNK_DTT_COMPOUND_FIELDS,
+	HCC_CU_STACK_CHUNK_DTT_ENUM_VALUES,
+	HCC_CU_STACK_CHUNK_DTT_FUNCTION_PARAMS,
+
+	HCC_CU_STACK_CHUNK_COUNT,
+};
+
+#define HCC_CU_STACK_CHUNK_CAP 256
+
+//
+// the chunks each worker has taken from the CU stacks, on their own cache line so workers do not false share
+typedef struct HccCUWorkerStackChunks HccCUWorkerStackChunks;
+struct HccCUWorkerStackChunks {
+	_Alignas(HCC_CACHE_LINE_ALIGN) HccStackChunk chunks[HCC_CU_STACK_CHUNK_COUNT];
+};
+
 typedef struct HccCU HccCU;
 struct HccCU {
 	HccConstantTable         constant_table;
@@ -3420,11 +4077,27 @@ struct HccCU {
 	HccHashTable(HccDeclEntryAtomic) struct_declarations; // struct T
 	HccHashTable(HccDeclEntryAtomic) union_declarations;  // union T
 	HccHashTable(HccDeclEntryAtomic) enum_declarations;   // enum T
+
+	HccCUWorkerStackChunks*          worker_stack_chunks; // indexed by worker, NULL until the CU is given to a compiler
+	uint32_t                         worker_stack_chunks_count;
 };
 
 void hcc_cu_init(HccCU* cu, HccCUSetup* setup, HccOptions* options);
 void hcc_cu_deinit(HccCU* cu);
 
+//
+// clears everything in the CU so it can be used for another compile.
+// all of the tables keep the memory they have committed, so a task that is dispatched
+// over and over again reuses the same CU instead of creating a new one each time.
+void hcc_cu_reset(HccCU* cu, HccOptions* options);
+
+//
+// returns NULL when not called from a worker of the compiler that the CU was given to
+uintptr_t hcc_cu_worker_stack_chunks_size(uint32_t workers_count);
+HccStackChunk* hcc_cu_worker_stack_chunk(HccCU* cu, HccCUStackChunk chunk);
+#define hcc_cu_stack_push(cu, stack, chunk) hcc_stack_push_chunked(stack, hcc_cu_worker_stack_chunk(cu, chunk), HCC_CU_STACK_CHUNK_CAP)
+#define hcc_cu_stack_push_many(cu, stack, chunk, amount) hcc_stack_push_many_chunked(stack, hcc_cu_worker_stack_chunk(cu, chunk), amount, HCC_CU_STACK_CHUNK_CAP)
+
 // ===========================================
 //
 //
@@ -3529,6 +4202,8 @@ struct HccTask {
 	HccIIO*                 output_iio_metadata_json;
 	HccMessageSys           message_sys;
 	HccStack(HccString)     include_path_strings;
+	HccHash64               include_paths_hash; // of the include_path_strings in order
+	HccString               pch_dir_path; // empty when precompiled headers are not used
 	HccMutex                is_running_mutex;
 	HccAtomic(uint32_t)     queued_jobs_count;
 	HccTime                 worker_job_type_start_times[HCC_WORKER_JOB_TYPE_COUNT];
@@ -3555,20 +4230,57 @@ void hcc_task_finish(HccTask* t, bool thread_that_set_error);
 typedef struct HccWorkerJob HccWorkerJob;
 struct HccWorkerJob {
 	HccWorkerJobType type;
+	HccAMLOptPhase   aml_opt_phase; // for HCC_WORKER_JOB_TYPE_AMLOPT
 	HccTask*         task;
 	void*            arg;
 };
 
+//
+// a growable ring of jobs used by the HccWorkerJobDeque.
+// rings that get replaced by a bigger ring are kept in the prev linked list
+// until the deque is deinitialized, as a thief may still be reading from them.
+typedef struct HccWorkerJobRing HccWorkerJobRing;
+struct HccWorkerJobRing {
+	HccWorkerJobRing* prev;
+	uintptr_t         size;
+	uint64_t          cap; // is always a power of two
+	HccWorkerJob      jobs[];
+};
+
+//
+// a Chase-Lev work stealing deque.
+// only the owner can push and pop from the bottom, any thread can steal from the top.
+// the owner side must be externally synchronized if multiple threads are going to push to it.
+typedef struct HccWorkerJobDeque HccWorkerJobDeque;
+struct HccWorkerJobDeque {
+	_Alignas(HCC_CACHE_LINE_ALIGN) HccAtomic(int64_t) top;
+	_Alignas(HCC_CACHE_LINE_ALIGN) HccAtomic(int64_t) bottom;
+	HccAtomic(HccWorkerJobRing*) ring;
+};
+
+void hcc_worker_job_deque_init(HccWorkerJobDeque* deque, uint32_t cap);
+void hcc_worker_job_deque_deinit(HccWorkerJobDeque* deque);
+void hcc_worker_job_deque_push(HccWorkerJobDeque* deque, HccWorkerJob* job);
+bool hcc_worker_job_deque_pop(HccWorkerJobDeque* deque, HccWorkerJob* job_out);
+bool hcc_worker_job_deque_steal(HccWorkerJobDeque* deque, HccWorkerJob* job_out);
+
 typedef struct HccWorker HccWorker;
 struct HccWorker {
+	HccWorkerJobDeque job_deque;
 	HccCompiler*   c;
 	HccCU*         cu;
 	HccWorkerJob   job;
 	HccThread      thread;
 	HccTime        job_start_time;
 	uint8_t        initialized_generators_bitset;
+	bool           is_mem_allocated;
+	bool           is_ready;
 	HccStack(char) string_buffer;
 	HccArenaAlctor arena_alctor;
+	char*          string_table_data;           // the rest of the chunk of string table data this worker took last
+	uint32_t       string_table_data_remaining;
+	uint32_t       string_table_next_id;        // the rest of the block of string identifiers this worker took last
+	uint32_t       string_table_end_id;
 
 	HccATAGen      atagen;
 	HccASTGen      astgen;
@@ -3610,7 +4322,8 @@ struct HccCompiler {
 	HccAtomic(HccCompilerFlags)    flags;
 	HccCompilerSetup               setup;
 	uint32_t                       workers_count;
-	HccWorker*                     workers;
+	HccWorker*                     workers; // in their own reservation as there are too many of them for the global arena on machines with lots of cores
+	uintptr_t                      workers_size;
 	void*                          worker_call_stacks_addr;
 	uintptr_t                      worker_call_stacks_size;
 	HccAtomic(uint32_t)            tasks_running_count;
@@ -3619,17 +4332,17 @@ struct HccCompiler {
 	HccDuration                    worker_job_type_durations[HCC_WORKER_JOB_TYPE_COUNT];
 	HccDuration                    duration;
 	HccTime                        start_time;
-	struct {
-		HccWorkerJob*              data;
-		uint32_t                   cap;
-		HccAtomic(uint32_t)        head_idx;
-		HccAtomic(uint32_t)        tail_idx;
-		HccSemaphore               semaphore;
-	} worker_job_queue;
+	HccSemaphore                   worker_jobs_semaphore; // holds a count of the jobs that are queued in all of the deques
+	HccSemaphore                   workers_ready_semaphore; // given by each worker once it has allocated its memory
+	HccSpinMutex                   injected_job_deque_mutex;
+	HccWorkerJobDeque              injected_job_deque; // jobs given by threads that are not workers of this compiler
 };
 
 void hcc_compiler_give_worker_job(HccCompiler* c, HccTask* t, HccWorkerJobType job_type, void* arg);
-bool hcc_compiler_take_or_wait_then_take_worker_job(HccCompiler* c, HccWorkerJob* job_out);
+void hcc_compiler_give_amlopt_worker_job(HccCompiler* c, HccTask* t, HccDecl function_decl, HccAMLOptPhase phase);
+void _hcc_compiler_give_worker_job(HccCompiler* c, HccWorkerJob* job);
+void _hcc_compiler_push_worker_job(HccCompiler* c, HccWorkerJob* job); // does not count the job in t->queued_jobs_count
+bool hcc_compiler_take_or_wait_then_take_worker_job(HccCompiler* c, HccWorker* w, HccWorkerJob* job_out);
 
 // ===========================================
 //
@@ -3651,10 +4364,24 @@ struct HccStringEntry {
 	HccAtomic(uint32_t) id;
 };
 
+//
+// the entries are split across many hash tables using the top bits of the string hash,
+// so workers that are interning different strings at the same time rarely contend on the same table.
+#define HCC_STRING_TABLE_SHARDS_SHIFT 4
+#define HCC_STRING_TABLE_SHARDS_COUNT (1 << HCC_STRING_TABLE_SHARDS_SHIFT)
+#define HCC_STRING_TABLE_ENTRY_IDX_BITS (32 - HCC_STRING_TABLE_SHARDS_SHIFT)
+#define HCC_STRING_TABLE_ENTRY_IDX_MASK ((1u << HCC_STRING_TABLE_ENTRY_IDX_BITS) - 1)
+
+//
+// workers take string identifiers and string data from the string table in blocks
+// and hand them out to new strings themselves without touching any shared state.
+#define HCC_STRING_TABLE_WORKER_ID_BLOCK_COUNT 64
+#define HCC_STRING_TABLE_WORKER_DATA_CHUNK_SIZE 4096
+
 typedef struct HccStringTable HccStringTable;
 struct HccStringTable {
-	HccHashTable(HccStringEntry) entries_hash_table;
-	HccStack(uint32_t)           id_to_entry_map;
+	HccHashTable(HccStringEntry) entries_hash_tables[HCC_STRING_TABLE_SHARDS_COUNT];
+	HccStack(uint32_t)           id_to_entry_map; // (shard_idx << HCC_STRING_TABLE_ENTRY_IDX_BITS) | entry_idx
 	HccStack(char)               data;
 	HccAtomic(uint32_t)          next_id;
 };
@@ -3703,6 +4430,10 @@ void hcc_string_table_deinit(HccStringTable* string_table);
 HccStringId hcc_string_table_alloc_next_id(HccStringTable* string_table);
 void hcc_string_table_skip_next_ids(HccStringTable* string_table, uint32_t num);
 
+//
+// the same as hcc_string_table_deduplicate but with hash = hcc_string_hash(string, string_size) already worked out
+HccResult hcc_string_table_deduplicate_hashed(const char* string, uint32_t string_size, HccHash hash, HccStringId* out);
+
 // ===========================================
 //
 //
@@ -3719,20 +4450,26 @@ struct HccCodeFileEntry {
 
 typedef struct HccGS HccGS;
 struct HccGS {
-	HccFlags                       flags;
-	uintptr_t                      virt_mem_page_size;
-	uintptr_t                      virt_mem_reserve_align;
-	HccAllocEventFn                alloc_event_fn;
-	HccPathCanonicalizeFn          path_canonicalize_fn;
-	HccFileOpenReadFn              file_open_read_fn;
-	HccArenaAlctor                 arena_alctor;
-	void*                          alloc_event_userdata;
-	HccStringTable                 string_table;
-	HccHashTable(HccCodeFileEntry) path_to_code_file_map;
-	uint32_t                       code_file_lines_grow_count;
-	uint32_t                       code_file_lines_reserve_cap;
-	uint32_t                       code_file_pp_if_spans_grow_count;
-	uint32_t                       code_file_pp_if_spans_reserve_cap;
+	HccFlags                                flags;
+	uintptr_t                               virt_mem_page_size;
+	uintptr_t                               virt_mem_reserve_align;
+	uint32_t                                logical_cores_count;
+	HccAllocEventFn                         alloc_event_fn;
+	HccPathCanonicalizeFn                   path_canonicalize_fn;
+	HccFileOpenReadFn                       file_open_read_fn;
+	HccFileStatFn                           file_stat_fn;
+	HccArenaAlctor                          arena_alctor;
+	void*                                   alloc_event_userdata;
+	HccMemTracker                           mem_tracker;
+	HccVirtMemPrefaulter                    virt_mem_prefaulter;
+	HccStringTable                          string_table;
+	HccHashTable(HccCodeFileEntry)          path_to_code_file_map;
+	HccHashTable(HccIncludeResolveEntry)    include_resolve_cache;
+	HccHashTable(HccIncludeResolveDirEntry) include_resolve_dirs;
+	uint32_t                                code_file_lines_grow_count;
+	uint32_t                                code_file_lines_reserve_cap;
+	uint32_t                                code_file_pp_if_spans_grow_count;
+	uint32_t                                code_file_pp_if_spans_reserve_cap;
 };
 
 extern HccGS _hcc_gs;
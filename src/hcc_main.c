@@ -21,10 +21,62 @@ void print_duration(const char* what, HccDuration d) {
 	printf("%s took: %.2fms\n", what, hcc_duration_to_f32_millisecs(d));
 }
 
+//
+// the worker job deques share the default capacity between them but each keep atleast this many entries.
+// '-j auto' stops adding workers when there is no more capacity left to share, as that is all the jobs that can be queued up to run in parallel.
+#define HCC_CLI_WORKER_JOBS_QUEUE_MIN_CAP 64
+
+//
+// the most worker threads that can be asked for with '-j <int>'
+#define HCC_CLI_WORKERS_MAX 1024
+
 int main(int argc, char** argv) {
 	hcc_register_segfault_handler();
 
 	HccSetup hcc_setup = hcc_setup_default;
+	bool pin_workers = false;
+	uint32_t workers_count = hcc_compiler_setup_default.workers_count;
+
+	//
+	// these change how the library and compiler are initialized, so they are looked for before everything else
+	for (int arg_idx = 1; arg_idx < argc; arg_idx += 1) {
+		if (strcmp(argv[arg_idx], "--huge-pages") == 0) {
+			hcc_setup.flags |= HCC_FLAGS_ENABLE_HUGE_PAGES;
+		} else if (strcmp(argv[arg_idx], "--prefault") == 0) {
+			hcc_setup.flags |= HCC_FLAGS_ENABLE_PREFAULT;
+		} else if (strcmp(argv[arg_idx], "--pin-workers") == 0) {
+			pin_workers = true;
+		} else if (strcmp(argv[arg_idx], "-j") == 0) {
+			arg_idx += 1;
+			if (arg_idx == argc) {
+				fprintf(stderr, "'-j' is missing a following number of worker threads or 'auto'. eg. '-j 8' or '-j auto'\n");
+				exit(1);
+			}
+
+			const char* a = argv[arg_idx];
+			if (strcmp(a, "auto") == 0) {
+				workers_count = 0;
+				continue;
+			}
+
+			//
+			// strtoul skips whitespace and accepts a sign, so make sure it starts with a digit
+			uint32_t size = strlen(a);
+			char* end_ptr;
+			errno = 0;
+			unsigned long num = strtoul(a, &end_ptr, 10);
+			if (size == 0 || a[0] < '0' || a[0] > '9' || a + size != end_ptr || errno == ERANGE || num == 0 || num > HCC_CLI_WORKERS_MAX) {
+				fprintf(stderr, "'-j %s' argument is not 'auto' or an unsigned integer from 1 to %u\n", a, HCC_CLI_WORKERS_MAX);
+				exit(1);
+			}
+			workers_count = num;
+		}
+	}
+
+	if (workers_count == 0) {
+		workers_count = HCC_MIN(hcc_available_logical_cores_count(), hcc_compiler_setup_default.worker_jobs_queue_cap / HCC_CLI_WORKER_JOBS_QUEUE_MIN_CAP);
+	}
+
 	HCC_ENSURE(hcc_init(&hcc_setup));
 
 	HccOptions* options;
@@ -33,6 +85,23 @@ int main(int argc, char** argv) {
 
 	HccCompiler* compiler;
 	HccCompilerSetup compiler_setup = hcc_compiler_setup_default;
+	compiler_setup.workers_count = workers_count;
+
+	//
+	// jobs are spread out over the worker deques, so share the default capacity between them.
+	// they grow when they are full so this only saves reserving memory that would not get used.
+	compiler_setup.worker_jobs_queue_cap = HCC_MAX(hcc_compiler_setup_default.worker_jobs_queue_cap / workers_count, HCC_CLI_WORKER_JOBS_QUEUE_MIN_CAP);
+
+	if (pin_workers) {
+		//
+		// give each worker a logical core of its own out of the ones this process is allowed to run on,
+		// wrapping around when there are more workers than cores
+		uint32_t cores_count = hcc_available_logical_cores_count();
+		uint32_t* worker_core_indices = HCC_ARENA_ALCTOR_ALLOC_ARRAY(uint32_t, &_hcc_gs.arena_alctor, cores_count);
+		cores_count = HCC_MIN(hcc_available_logical_cores(worker_core_indices, cores_count), cores_count);
+		compiler_setup.worker_core_indices = worker_core_indices;
+		compiler_setup.worker_core_indices_count = cores_count;
+	}
 	HCC_ENSURE(hcc_compiler_init(&compiler_setup, &compiler));
 
 	HccTask* task;
@@ -45,6 +114,7 @@ int main(int argc, char** argv) {
 	bool output_final_file = true;
 	bool has_input = false;
 	bool debug_time = false;
+	bool debug_mem = false;
 	const char* hlsl_dir = NULL;
 	const char* msl_dir = NULL;
 	bool enable_stdout_color = true;
@@ -184,6 +254,27 @@ int main(int argc, char** argv) {
 				fprintf(stderr, "--msl '%s' path is a file and not a directory\n", msl_dir);
 				exit(1);
 			}
+		} else if (strcmp(argv[arg_idx], "--pch-dir") == 0) {
+			arg_idx += 1;
+			if (arg_idx == argc) {
+				fprintf(stderr, "'--pch-dir' is missing a following directory path to follow '--pch-dir path/to/directory'\n");
+				exit(1);
+			}
+
+			const char* pch_dir = argv[arg_idx];
+			if (hcc_path_exists(pch_dir) && hcc_path_is_file(pch_dir)) {
+				fprintf(stderr, "--pch-dir '%s' path is a file and not a directory\n", pch_dir);
+				exit(1);
+			}
+
+			if (!hcc_make_directory(pch_dir) && !hcc_path_is_directory(pch_dir)) {
+				char buf[1024];
+				hcc_get_last_system_error_string(buf, sizeof(buf));
+				fprintf(stderr, "failed to make directory at '%s': %s\n", pch_dir, buf);
+				exit(1);
+			}
+
+			HCC_ENSURE(hcc_task_set_pch_dir(task, hcc_string_c((char*)pch_dir)));
 		} else if (strcmp(argv[arg_idx], "--max-descriptors") == 0) {
 			arg_idx += 1;
 			if (arg_idx == argc) {
@@ -236,6 +327,12 @@ int main(int argc, char** argv) {
 			hcc_options_set_bool(options, HCC_OPTION_KEY_UNORDERED_SWIZZLING_ENABLED, true);
 		} else if (strcmp(argv[arg_idx], "--debug-time") == 0) {
 			debug_time = true;
+		} else if (strcmp(argv[arg_idx], "--debug-mem") == 0) {
+			debug_mem = true;
+		} else if (strcmp(argv[arg_idx], "--huge-pages") == 0 || strcmp(argv[arg_idx], "--prefault") == 0 || strcmp(argv[arg_idx], "--pin-workers") == 0) {
+			// already handled before hcc_init
+		} else if (strcmp(argv[arg_idx], "-j") == 0) {
+			arg_idx += 1; // already handled before hcc_init
 		} else if (strcmp(argv[arg_idx], "--debug-ata") == 0) {
 			HccIIO* stdout_iio = HCC_ARENA_ALCTOR_ALLOC_ELMT(HccIIO, &_hcc_gs.arena_alctor);
 			*stdout_iio = hcc_iio_file(stdout);
@@ -270,6 +367,7 @@ int main(int argc, char** argv) {
 				"\t--hlsl-packing               | errors on bundled constants if they do not follow the HLSL packing rules for cbuffers. --hlsl also enables this\n"
 				"\t--hlsl <path>                | path to a directory where the HLSL files will go. requires spirv-cross to be installed\n"
 				"\t--msl  <path>                | path to a directory where the MSL files will go. requires spirv-cross to be installed\n"
+				"\t--pch-dir <path>             | path to a directory where precompiled headers are stored and reused between compiles\n"
 				"\t--max-descriptors <int>      | sets the size of the resource descriptors arrays\n"
 				"\t--max-bc-size <int>          | sets the maximum size of the bundled constants passed into every shader\n"
 				"\t--disable-color              | disables color output when printing to stdout\n"
@@ -279,8 +377,13 @@ int main(int argc, char** argv) {
 				"\t--enable-float16             | enables 16bit float support\n"
 				"\t--enable-float64             | enables 64bit float support\n"
 				"\t--enable-unordered-swizzling | allows for vector swizzling x, y, z, w out of order eg. .zyx or .xx or .yyzz \n"
+				"\t--huge-pages                 | backs the large memory reservations with huge pages, only supported on Linux\n"
+				"\t--prefault                   | allocates the physical pages of large memory commits on a background thread, only supported on Linux 5.14+\n"
+				"\t--pin-workers                | pins each worker thread to a logical core of its own\n"
+				"\t-j <int>|auto                | the number of worker threads used to compile, auto uses one for each logical core this process can run on up to 64. defaults to 1\n"
 				"\t--help                       | displays this prompt and then exits\n"
 				"\t--debug-time                 | prints the duration of each compiliation stage of the compiler\n"
+				"\t--debug-mem                  | prints the live and peak virtual memory used by each allocation tag after compiling\n"
 				"\t--debug-ata                  | prints the Abstract Token Array made by the compiler, it will stop after ATAGEN stage\n"
 				"\t--debug-ast                  | prints the Abstract Syntax Tree made by the compiler, it will stop after ASTGEN stage\n"
 				"\t--debug-aml                  | prints the Abstract Machine Language made by the compiler, it will stop after AMLGEN stage\n"
@@ -323,7 +426,7 @@ int main(int argc, char** argv) {
 		exit(1);
 	}
 
-	hcc_compiler_dispatch_task(compiler, task);
+	HCC_ENSURE(hcc_compiler_dispatch_task(compiler, task));
 	HccResult result = hcc_task_wait_for_complete(task);
 
 	HccIIO iio = hcc_iio_file(stdout);
@@ -455,6 +558,14 @@ int main(int argc, char** argv) {
 		}
 	}
 
+	if (debug_mem) {
+		//
+		// the output before this (eg. the SPIR-V tools warning) may not end in a new line
+		printf("\n");
+		HccIIO stdout_iio = hcc_iio_file(stdout);
+		hcc_mem_tracker_log(&stdout_iio);
+	}
+
 	return 0;
 }
 
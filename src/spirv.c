@@ -8,37 +8,12 @@
 //
 // ===========================================
 
-void hcc_spirv_init(HccCU* cu, HccCUSetup* setup) {
-	HCC_UNUSED(setup);
+//
+// sets up the ids and constants that every SPIR-V binary uses, these get created again after a reset.
+// the constant table must be initialized before this is called.
+static void hcc_spirv_prepare(HccCU* cu) {
 	cu->spirv.next_spirv_id = HCC_SPIRV_ID_USER_START;
 
-	cu->spirv.functions = hcc_stack_init(HccSPIRVFunction, HCC_ALLOC_TAG_SPIRV_FUNCTIONS, setup->functions_grow_count, setup->functions_reserve_cap);
-	cu->spirv.function_words = hcc_stack_init(HccSPIRVWord, HCC_ALLOC_TAG_SPIRV_FUNCTION_WORDS, (uint32_t)(setup->aml.function_alctor.instrs_grow_count * HCC_AML_INSTR_AVERAGE_WORDS), (uint32_t)(setup->aml.function_alctor.instrs_reserve_cap * HCC_AML_INSTR_AVERAGE_WORDS));
-	uint32_t types_reserve_cap           =
-		setup->dtt.arrays_reserve_cap    +
-		setup->dtt.compounds_reserve_cap +
-		setup->dtt.pointers_reserve_cap  +
-		setup->dtt.buffers_reserve_cap   ;
-	uint32_t types_grow_count           =
-		setup->dtt.arrays_grow_count    +
-		setup->dtt.compounds_grow_count +
-		setup->dtt.pointers_grow_count  +
-		setup->dtt.buffers_grow_count   ;
-	cu->spirv.type_table = hcc_hash_table_init(HccSPIRVTypeEntry, HCC_ALLOC_TAG_SPIRV_TYPE_TABLE, hcc_spirv_type_key_cmp, hcc_spirv_type_key_hash, types_reserve_cap);
-	uint32_t decl_table_entries_cap            =
-		setup->functions_reserve_cap           +
-		setup->ast.global_variables_reserve_cap;
-	cu->spirv.decl_table = hcc_hash_table_init(HccSPIRVDeclEntry, HCC_ALLOC_TAG_SPIRV_DECL_TABLE, hcc_u32_key_cmp, hcc_u32_key_hash, decl_table_entries_cap);
-	cu->spirv.descriptor_binding_table = hcc_hash_table_init(HccSPIRVDescriptorBindingEntry, HCC_ALLOC_TAG_SPIRV_DESCRIPTOR_BINDING_TABLE, hcc_spirv_descriptor_binding_key_cmp, hcc_spirv_descriptor_binding_key_hash, decl_table_entries_cap);
-	cu->spirv.constant_table = hcc_hash_table_init(HccSPIRVConstantEntry, HCC_ALLOC_TAG_SPIRV_CONSTANT_TABLE, hcc_u32_key_cmp, hcc_u32_key_hash, setup->constant_table.entries_cap);
-	cu->spirv.types_and_constants = hcc_stack_init(HccSPIRVTypeOrConstant, HCC_ALLOC_TAG_SPIRV_TYPES_AND_CONSTANTS, types_grow_count, types_reserve_cap + setup->constant_table.entries_cap);
-	cu->spirv.type_elmt_ids = hcc_stack_init(HccSPIRVId, HCC_ALLOC_TAG_SPIRV_TYPE_ELMT_IDS, setup->dtt.compound_fields_grow_count, setup->dtt.compound_fields_reserve_cap);
-	cu->spirv.entry_points = hcc_stack_init(HccSPIRVEntryPoint, HCC_ALLOC_TAG_SPIRV_ENTRY_POINTS, setup->functions_grow_count, setup->functions_reserve_cap);
-	cu->spirv.entry_point_global_variable_ids = hcc_stack_init(HccSPIRVId, HCC_ALLOC_TAG_SPIRV_ENTRY_POINT_GLOBAL_VARIABLE_IDS, setup->ast.global_variables_grow_count, setup->ast.global_variables_reserve_cap);
-	cu->spirv.global_variable_words = hcc_stack_init(HccSPIRVId, HCC_ALLOC_TAG_SPIRV_GLOBAL_VARIABLE_WORDS, setup->ast.global_variables_grow_count * 4, setup->ast.global_variables_reserve_cap * 4);
-	cu->spirv.name_words = hcc_stack_init(HccSPIRVId, HCC_ALLOC_TAG_SPIRV_NAME_WORDS, types_grow_count, types_reserve_cap);
-	cu->spirv.decorate_words = hcc_stack_init(HccSPIRVId, HCC_ALLOC_TAG_SPIRV_DECORATE_WORDS, types_grow_count, types_reserve_cap);
-
 	HccBasic basic = { .u32 = hcc_options_get_u32(cu->options, HCC_OPTION_KEY_RESOURCE_DESCRIPTORS_MAX) };
 	cu->spirv.resource_descriptors_max_constant_spirv_id = hcc_spirv_constant_deduplicate(cu, hcc_constant_table_deduplicate_basic(cu, HCC_DATA_TYPE_AML_INTRINSIC_U32, &basic));
 	basic.u32 = HCC_SPIRV_SCOPE_DEVICE;
@@ -65,6 +40,73 @@ void hcc_spirv_init(HccCU* cu, HccCUSetup* setup) {
 	cu->spirv.quad_swap_diagonal_spirv_id = hcc_spirv_constant_deduplicate(cu, hcc_constant_table_deduplicate_basic(cu, HCC_DATA_TYPE_AML_INTRINSIC_U32, &basic));
 }
 
+void hcc_spirv_init(HccCU* cu, HccCUSetup* setup) {
+	HCC_UNUSED(setup);
+	cu->spirv.functions = hcc_stack_init(HccSPIRVFunction, HCC_ALLOC_TAG_SPIRV_FUNCTIONS, setup->functions_grow_count, setup->functions_reserve_cap);
+	cu->spirv.function_words = hcc_stack_init(HccSPIRVWord, HCC_ALLOC_TAG_SPIRV_FUNCTION_WORDS, (uint32_t)(setup->aml.function_alctor.instrs_grow_count * HCC_AML_INSTR_AVERAGE_WORDS), (uint32_t)(setup->aml.function_alctor.instrs_reserve_cap * HCC_AML_INSTR_AVERAGE_WORDS));
+	uint32_t types_reserve_cap           =
+		setup->dtt.arrays_reserve_cap    +
+		setup->dtt.compounds_reserve_cap +
+		setup->dtt.pointers_reserve_cap  +
+		setup->dtt.buffers_reserve_cap   ;
+	uint32_t types_grow_count           =
+		setup->dtt.arrays_grow_count    +
+		setup->dtt.compounds_grow_count +
+		setup->dtt.pointers_grow_count  +
+		setup->dtt.buffers_grow_count   ;
+	cu->spirv.type_table = hcc_hash_table_init(HccSPIRVTypeEntry, HCC_ALLOC_TAG_SPIRV_TYPE_TABLE, hcc_spirv_type_key_cmp, hcc_spirv_type_key_hash, types_grow_count);
+	uint32_t decl_table_entries_cap           =
+		setup->functions_grow_count           +
+		setup->ast.global_variables_grow_count;
+	cu->spirv.decl_table = hcc_hash_table_init(HccSPIRVDeclEntry, HCC_ALLOC_TAG_SPIRV_DECL_TABLE, hcc_u32_key_cmp, hcc_u32_key_hash, decl_table_entries_cap);
+	cu->spirv.descriptor_binding_table = hcc_hash_table_init(HccSPIRVDescriptorBindingEntry, HCC_ALLOC_TAG_SPIRV_DESCRIPTOR_BINDING_TABLE, hcc_spirv_descriptor_binding_key_cmp, hcc_spirv_descriptor_binding_key_hash, decl_table_entries_cap);
+	cu->spirv.constant_table = hcc_hash_table_init(HccSPIRVConstantEntry, HCC_ALLOC_TAG_SPIRV_CONSTANT_TABLE, hcc_u32_key_cmp, hcc_u32_key_hash, setup->constant_table.entries_cap);
+	cu->spirv.types_and_constants = hcc_stack_init(HccSPIRVTypeOrConstant, HCC_ALLOC_TAG_SPIRV_TYPES_AND_CONSTANTS, types_grow_count, types_reserve_cap + HCC_MAX(setup->constant_table.entries_cap, HCC_HASH_TABLE_RESERVE_CAP));
+	cu->spirv.type_elmt_ids = hcc_stack_init(HccSPIRVId, HCC_ALLOC_TAG_SPIRV_TYPE_ELMT_IDS, setup->dtt.compound_fields_grow_count, setup->dtt.compound_fields_reserve_cap);
+	cu->spirv.entry_points = hcc_stack_init(HccSPIRVEntryPoint, HCC_ALLOC_TAG_SPIRV_ENTRY_POINTS, setup->functions_grow_count, setup->functions_reserve_cap);
+	cu->spirv.entry_point_global_variable_ids = hcc_stack_init(HccSPIRVId, HCC_ALLOC_TAG_SPIRV_ENTRY_POINT_GLOBAL_VARIABLE_IDS, setup->ast.global_variables_grow_count, setup->ast.global_variables_reserve_cap);
+	cu->spirv.global_variable_words = hcc_stack_init(HccSPIRVId, HCC_ALLOC_TAG_SPIRV_GLOBAL_VARIABLE_WORDS, setup->ast.global_variables_grow_count * 4, setup->ast.global_variables_reserve_cap * 4);
+	cu->spirv.name_words = hcc_stack_init(HccSPIRVId, HCC_ALLOC_TAG_SPIRV_NAME_WORDS, types_grow_count, types_reserve_cap);
+	cu->spirv.decorate_words = hcc_stack_init(HccSPIRVId, HCC_ALLOC_TAG_SPIRV_DECORATE_WORDS, types_grow_count, types_reserve_cap);
+
+	hcc_spirv_prepare(cu);
+}
+
+void hcc_spirv_deinit(HccCU* cu) {
+	hcc_stack_deinit(cu->spirv.functions);
+	hcc_stack_deinit(cu->spirv.function_words);
+	hcc_hash_table_deinit(cu->spirv.type_table);
+	hcc_hash_table_deinit(cu->spirv.decl_table);
+	hcc_hash_table_deinit(cu->spirv.descriptor_binding_table);
+	hcc_hash_table_deinit(cu->spirv.constant_table);
+	hcc_stack_deinit(cu->spirv.types_and_constants);
+	hcc_stack_deinit(cu->spirv.type_elmt_ids);
+	hcc_stack_deinit(cu->spirv.entry_points);
+	hcc_stack_deinit(cu->spirv.entry_point_global_variable_ids);
+	hcc_stack_deinit(cu->spirv.global_variable_words);
+	hcc_stack_deinit(cu->spirv.name_words);
+	hcc_stack_deinit(cu->spirv.decorate_words);
+}
+
+void hcc_spirv_reset(HccCU* cu) {
+	hcc_stack_reset(cu->spirv.functions);
+	hcc_stack_reset(cu->spirv.function_words);
+	hcc_hash_table_clear(cu->spirv.type_table);
+	hcc_hash_table_clear(cu->spirv.decl_table);
+	hcc_hash_table_clear(cu->spirv.descriptor_binding_table);
+	hcc_hash_table_clear(cu->spirv.constant_table);
+	hcc_stack_reset(cu->spirv.types_and_constants);
+	hcc_stack_reset(cu->spirv.type_elmt_ids);
+	hcc_stack_reset(cu->spirv.entry_points);
+	hcc_stack_reset(cu->spirv.entry_point_global_variable_ids);
+	hcc_stack_reset(cu->spirv.global_variable_words);
+	hcc_stack_reset(cu->spirv.name_words);
+	hcc_stack_reset(cu->spirv.decorate_words);
+	cu->spirv.final_binary_words = NULL;
+	cu->spirv.final_binary_words_count = 0;
+	hcc_spirv_prepare(cu);
+}
+
 HccSPIRVId hcc_spirv_next_id(HccCU* cu) {
 	return atomic_fetch_add(&cu->spirv.next_spirv_id, 1);
 }
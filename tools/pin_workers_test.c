@@ -0,0 +1,81 @@
+//
+// starts a compiler with every worker pinned to a logical core this process can run on,
+// like 'hcc --pin-workers' does, then checks that the affinity mask of each worker thread only has the core it was given.
+// build and run with scripts/pin_workers_test.sh
+#include <stdlib.h>
+
+#include "../src/core.c"
+#include "../src/ata.c"
+#include "../src/ast.c"
+#include "../src/aml.c"
+#include "../src/atagen.c"
+#include "../src/astgen.c"
+#include "../src/astlink.c"
+#include "../src/amlgen.c"
+#include "../src/amlopt.c"
+#include "../src/spirv.c"
+#include "../src/spirvgen.c"
+#include "../src/spirvlink.c"
+#include "../src/metadatagen.c"
+#include "../interop/hcc_interop.c"
+#include "../src/hcc.c"
+#include <hmaths.c>
+
+int main(int argc, char** argv) {
+	HCC_UNUSED(argc);
+	HCC_UNUSED(argv);
+
+#ifdef HCC_OS_LINUX
+	HccSetup setup = hcc_setup_default;
+	HCC_ENSURE(hcc_init(&setup));
+
+	uint32_t cores_count = hcc_available_logical_cores_count();
+	uint32_t* core_indices = malloc(cores_count * sizeof(uint32_t));
+	cores_count = HCC_MIN(hcc_available_logical_cores(core_indices, cores_count), cores_count);
+
+	//
+	// one more worker than there are cores, so the wrap around to the first core is checked too
+	HccCompilerSetup compiler_setup = hcc_compiler_setup_default;
+	compiler_setup.workers_count = cores_count + 1;
+	compiler_setup.worker_core_indices = core_indices;
+	compiler_setup.worker_core_indices_count = cores_count;
+	HccCompiler* c;
+	HCC_ENSURE(hcc_compiler_init(&compiler_setup, &c));
+
+	uint32_t configured_cores_count = get_nprocs_conf();
+	cpu_set_t* cpu_set = CPU_ALLOC(configured_cores_count);
+	size_t cpu_set_size = CPU_ALLOC_SIZE(configured_cores_count);
+	uint32_t failed_count = 0;
+	for (uint32_t worker_idx = 0; worker_idx < c->workers_count; worker_idx += 1) {
+		HccWorker* w = &c->workers[worker_idx];
+		uint32_t core_idx = core_indices[worker_idx % cores_count];
+
+		//
+		// pthread_getaffinity_np is sched_getaffinity for the thread behind the handle
+		CPU_ZERO_S(cpu_set_size, cpu_set);
+		if (pthread_getaffinity_np(w->thread.handle, cpu_set_size, cpu_set) != 0) {
+			printf("worker %u: failed to get the affinity mask\n", worker_idx);
+			failed_count += 1;
+			continue;
+		}
+
+		int mask_cores_count = CPU_COUNT_S(cpu_set_size, cpu_set);
+		if (mask_cores_count != 1 || !CPU_ISSET_S(core_idx, cpu_set_size, cpu_set)) {
+			printf("worker %u: expected to only run on core %u but the affinity mask has %d cores\n", worker_idx, core_idx, mask_cores_count);
+			failed_count += 1;
+		}
+	}
+	CPU_FREE(cpu_set);
+
+	uint32_t workers_count = c->workers_count;
+	HCC_ENSURE(hcc_compiler_deinit(c));
+	free(core_indices);
+	hcc_deinit();
+
+	printf("pin_workers_test: %s, %u workers checked\n", failed_count ? "FAILED" : "passed", workers_count);
+	return failed_count ? 1 : 0;
+#else
+	printf("pin_workers_test: skipped, the affinity masks are only checked on Linux\n");
+	return 0;
+#endif
+}